@@ -0,0 +1,271 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "ActorSignificanceSubsystem.h"
+
+#include "AIController.h"
+#include "BaseSpider.h"
+#include "BrainComponent.h"
+#include "SignificanceManager.h"
+#include "WebGraphSubsystem.h"
+#include "Engine/World.h"
+#include "GameFramework/PawnMovementComponent.h"
+#include "GameFramework/PlayerController.h"
+
+static TAutoConsoleVariable<bool> CVarSignificanceEnabled(
+	TEXT("Spider.Significance.Enabled"),
+	true,
+	TEXT("Throttle spider and firefly ticks by significance, off ticks everything every frame"));
+
+static TAutoConsoleVariable<float> CVarSignificanceNearDistance(
+	TEXT("Spider.Significance.NearDistance"),
+	2500.f,
+	TEXT("Closer than this to a viewpoint ticks every frame"));
+
+static TAutoConsoleVariable<float> CVarSignificanceFarDistance(
+	TEXT("Spider.Significance.FarDistance"),
+	8000.f,
+	TEXT("Further than this from every viewpoint ticks at the low rate, or not at all when not rendered"));
+
+static TAutoConsoleVariable<float> CVarSignificanceMediumInterval(
+	TEXT("Spider.Significance.MediumInterval"),
+	1.f / 30.f,
+	TEXT("Tick interval in seconds between the near and far distance"));
+
+static TAutoConsoleVariable<float> CVarSignificanceLowInterval(
+	TEXT("Spider.Significance.LowInterval"),
+	0.1f,
+	TEXT("Tick interval in seconds past the far distance"));
+
+const FName UActorSignificanceSubsystem::SPIDER_TAG{ TEXT("Spider") };
+const FName UActorSignificanceSubsystem::FIREFLY_TAG{ TEXT("Firefly") };
+
+void UActorSignificanceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	if (UWebGraphSubsystem* WebGraph{ Collection.InitializeDependency<UWebGraphSubsystem>() })
+		m_SegmentRemovedHandle = WebGraph->OnSegmentRemoved.AddUObject(this, &UActorSignificanceSubsystem::HandleSegmentRemoved);
+}
+
+void UActorSignificanceSubsystem::Deinitialize()
+{
+	if (UWebGraphSubsystem* WebGraph{ GetWorld()->GetSubsystem<UWebGraphSubsystem>() })
+		WebGraph->OnSegmentRemoved.Remove(m_SegmentRemovedHandle);
+
+	m_Tracked.Reset();
+	Super::Deinitialize();
+}
+
+void UActorSignificanceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UWorld* World{ GetWorld() };
+	USignificanceManager* SignificanceManager{ USignificanceManager::Get(World) };
+	if (SignificanceManager == nullptr)
+		return;
+
+	const bool Enabled{ CVarSignificanceEnabled.GetValueOnGameThread() };
+	if (Enabled != m_Enabled)
+	{
+		m_Enabled = Enabled;
+		ApplyToAll(ESignificanceBucket::High);
+	}
+
+	if (!m_Enabled)
+		return;
+
+	m_Viewpoints.Reset();
+	for (FConstPlayerControllerIterator It{ World->GetPlayerControllerIterator() }; It; ++It)
+	{
+		const APlayerController* PlayerController{ It->Get() };
+		if (PlayerController == nullptr || !PlayerController->IsLocalController())
+			continue;
+
+		FVector Location{};
+		FRotator Rotation{};
+		PlayerController->GetPlayerViewPoint(Location, Rotation);
+		m_Viewpoints.Emplace(Rotation, Location);
+	}
+
+	// Without anyone watching nothing gets throttled, the benchmark and dedicated servers run everything
+	if (m_Viewpoints.IsEmpty())
+		return;
+
+	SignificanceManager->Update(m_Viewpoints);
+}
+
+TStatId UActorSignificanceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UActorSignificanceSubsystem, STATGROUP_Tickables);
+}
+
+void UActorSignificanceSubsystem::RegisterSpider(ABaseSpider* Spider)
+{
+	Register(Spider, SPIDER_TAG, false);
+}
+
+void UActorSignificanceSubsystem::RegisterFirefly(APawn* Firefly)
+{
+	Register(Firefly, FIREFLY_TAG, true);
+}
+
+void UActorSignificanceSubsystem::Unregister(AActor* Actor)
+{
+	if (Actor == nullptr || m_Tracked.Remove(Actor) == 0)
+		return;
+
+	if (USignificanceManager* SignificanceManager{ USignificanceManager::Get(GetWorld()) })
+		SignificanceManager->UnregisterObject(Actor);
+}
+
+void UActorSignificanceSubsystem::Wake(AActor* Actor)
+{
+	const FTracked* Tracked{ m_Tracked.Find(Actor) };
+	if (Tracked && Tracked->Bucket != ESignificanceBucket::High)
+		ApplyBucket(Actor, ESignificanceBucket::High);
+}
+
+ESignificanceBucket UActorSignificanceSubsystem::GetBucket(const AActor* Actor) const
+{
+	const FTracked* Tracked{ m_Tracked.Find(Actor) };
+	return Tracked ? Tracked->Bucket : ESignificanceBucket::High;
+}
+
+void UActorSignificanceSubsystem::Register(AActor* Actor, FName Tag, bool Firefly)
+{
+	USignificanceManager* SignificanceManager{ USignificanceManager::Get(GetWorld()) };
+	if (Actor == nullptr || SignificanceManager == nullptr || m_Tracked.Contains(Actor))
+		return;
+
+	m_Tracked.Add(Actor, { ESignificanceBucket::Low, Firefly });
+	ApplyBucket(Actor, ESignificanceBucket::High);
+
+	// Significance runs in parallel, the calc functions only read
+	USignificanceManager::FSignificanceFunction SignificanceFunction{ [Firefly](USignificanceManager::FManagedObjectInfo* Info, const FTransform& Viewpoint)
+	{
+		const AActor* Tracked{ CastChecked<AActor>(Info->GetObject()) };
+		return Firefly ? CalcFireflySignificance(Tracked, Viewpoint) : CalcSpiderSignificance(Tracked, Viewpoint);
+	} };
+
+	// Compared against what we applied last, Wake can change that between updates
+	USignificanceManager::FPostSignificanceFunction PostSignificanceFunction{ [this](USignificanceManager::FManagedObjectInfo* Info, float OldSignificance, float Significance, bool Final)
+	{
+		AActor* Tracked{ CastChecked<AActor>(Info->GetObject()) };
+		const ESignificanceBucket Bucket{ ToBucket(Significance) };
+		if (GetBucket(Tracked) != Bucket)
+			ApplyBucket(Tracked, Bucket);
+	} };
+
+	SignificanceManager->RegisterObject(Actor, Tag, MoveTemp(SignificanceFunction), USignificanceManager::EPostSignificanceType::Sequential, MoveTemp(PostSignificanceFunction));
+}
+
+float UActorSignificanceSubsystem::CalcSpiderSignificance(const AActor* Actor, const FTransform& Viewpoint)
+{
+	const ABaseSpider* Spider{ static_cast<const ABaseSpider*>(Actor) };
+	// Replays have to run every frame they were recorded in, AI spiders are locally controlled too so only the player is pinned
+	if ((Spider->IsPlayerControlled() && Spider->IsLocallyControlled()) || Spider->IsReplaying())
+		return static_cast<float>(ESignificanceBucket::High);
+
+	if (Spider->IsIdle())
+		return static_cast<float>(ESignificanceBucket::Suspended);
+
+	// Moving spiders keep simulating off-screen, they would freeze mid jump
+	return static_cast<float>(CalcDistanceBucket(Actor, Viewpoint, false));
+}
+
+float UActorSignificanceSubsystem::CalcFireflySignificance(const AActor* Actor, const FTransform& Viewpoint)
+{
+	return static_cast<float>(CalcDistanceBucket(Actor, Viewpoint, true));
+}
+
+ESignificanceBucket UActorSignificanceSubsystem::CalcDistanceBucket(const AActor* Actor, const FTransform& Viewpoint, bool CanSuspend)
+{
+	const double DistanceSquared{ FVector::DistSquared(Actor->GetActorLocation(), Viewpoint.GetLocation()) };
+	const bool Rendered{ Actor->WasRecentlyRendered(0.5f) };
+
+	if (DistanceSquared < FMath::Square(CVarSignificanceNearDistance.GetValueOnAnyThread()))
+		return Rendered ? ESignificanceBucket::High : ESignificanceBucket::Medium;
+
+	if (DistanceSquared < FMath::Square(CVarSignificanceFarDistance.GetValueOnAnyThread()))
+		return Rendered ? ESignificanceBucket::Medium : ESignificanceBucket::Low;
+
+	return CanSuspend && !Rendered ? ESignificanceBucket::Suspended : ESignificanceBucket::Low;
+}
+
+ESignificanceBucket UActorSignificanceSubsystem::ToBucket(float Significance)
+{
+	return static_cast<ESignificanceBucket>(FMath::Clamp(FMath::RoundToInt32(Significance), 0, static_cast<int32>(ESignificanceBucket::High)));
+}
+
+void UActorSignificanceSubsystem::ApplyBucket(AActor* Actor, ESignificanceBucket Bucket)
+{
+	FTracked* Tracked{ m_Tracked.Find(Actor) };
+	if (Tracked == nullptr)
+		return;
+
+	Tracked->Bucket = Bucket;
+
+	const bool Ticking{ Bucket != ESignificanceBucket::Suspended };
+	float Interval{};
+	if (Bucket == ESignificanceBucket::Medium)
+		Interval = CVarSignificanceMediumInterval.GetValueOnGameThread();
+	else if (Bucket == ESignificanceBucket::Low)
+		Interval = CVarSignificanceLowInterval.GetValueOnGameThread();
+
+	const auto ApplyToActor = [Ticking, Interval](AActor* Target)
+	{
+		Target->SetActorTickEnabled(Ticking);
+		Target->SetActorTickInterval(Interval);
+	};
+
+	const auto ApplyToComponent = [Ticking, Interval](UActorComponent* Target)
+	{
+		Target->SetComponentTickEnabled(Ticking);
+		Target->SetComponentTickInterval(Interval);
+	};
+
+	// Spiders run all movement in their own tick, leave their controllers alone so they can still wake them
+	ApplyToActor(Actor);
+	if (!Tracked->Firefly)
+		return;
+
+	const APawn* Pawn{ Cast<APawn>(Actor) };
+	if (Pawn == nullptr)
+		return;
+
+	if (UPawnMovementComponent* Movement{ Pawn->GetMovementComponent() })
+		ApplyToComponent(Movement);
+
+	if (AAIController* Controller{ Cast<AAIController>(Pawn->GetController()) })
+	{
+		ApplyToActor(Controller);
+		if (UBrainComponent* Brain{ Controller->GetBrainComponent() })
+			ApplyToComponent(Brain);
+	}
+}
+
+void UActorSignificanceSubsystem::ApplyToAll(ESignificanceBucket Bucket)
+{
+	for (const TPair<TObjectKey<AActor>, FTracked>& Pair : m_Tracked)
+	{
+		if (AActor* Actor{ Pair.Key.ResolveObjectPtr() })
+			ApplyBucket(Actor, Bucket);
+	}
+}
+
+void UActorSignificanceSubsystem::HandleSegmentRemoved(int32 Segment, AActor* Owner)
+{
+	// Idle spiders could be standing on what just went, let them find out
+	TArray<AActor*> Sleeping{};
+	for (const TPair<TObjectKey<AActor>, FTracked>& Pair : m_Tracked)
+	{
+		if (!Pair.Value.Firefly && Pair.Value.Bucket == ESignificanceBucket::Suspended)
+			Sleeping.Add(Pair.Key.ResolveObjectPtr());
+	}
+
+	for (AActor* Spider : Sleeping)
+	{
+		if (Spider)
+			Wake(Spider);
+	}
+}
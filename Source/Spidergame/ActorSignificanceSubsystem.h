@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ActorSignificanceSubsystem.generated.h"
+
+class ABaseSpider;
+
+UENUM(BlueprintType)
+enum class ESignificanceBucket : uint8
+{
+	Suspended,
+	Low,
+	Medium,
+	High
+};
+
+/**
+ * Feeds spiders and fireflies to the significance manager and throttles their ticks by the bucket they land in.
+ * Close or visible actors tick every frame, distant ones less often, idle spiders and far off-screen fireflies not at all.
+ * Locally controlled spiders always stay High. Anything can be woken early through Wake, spiders do it themselves on input and jumps.
+ */
+UCLASS()
+class SPIDERGAME_API UActorSignificanceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	void RegisterSpider(ABaseSpider* Spider);
+	// Throttles the pawn, its movement component, its controller and the controller's brain
+	void RegisterFirefly(APawn* Firefly);
+	void Unregister(AActor* Actor);
+
+	// Back to full rate until the next significance update says otherwise
+	UFUNCTION(BlueprintCallable, Category="Significance")
+	void Wake(AActor* Actor);
+
+	UFUNCTION(BlueprintPure, Category="Significance")
+	ESignificanceBucket GetBucket(const AActor* Actor) const;
+
+private:
+	static const FName SPIDER_TAG;
+	static const FName FIREFLY_TAG;
+
+	struct FTracked
+	{
+		ESignificanceBucket Bucket{ ESignificanceBucket::High };
+		bool Firefly{ false };
+	};
+
+	TMap<TObjectKey<AActor>, FTracked> m_Tracked{};
+	bool m_Enabled{ true };
+	TArray<FTransform> m_Viewpoints{};
+	FDelegateHandle m_SegmentRemovedHandle{};
+
+	static float CalcSpiderSignificance(const AActor* Actor, const FTransform& Viewpoint);
+	static float CalcFireflySignificance(const AActor* Actor, const FTransform& Viewpoint);
+	static ESignificanceBucket CalcDistanceBucket(const AActor* Actor, const FTransform& Viewpoint, bool CanSuspend);
+	static ESignificanceBucket ToBucket(float Significance);
+
+	void Register(AActor* Actor, FName Tag, bool Firefly);
+	void ApplyBucket(AActor* Actor, ESignificanceBucket Bucket);
+	void ApplyToAll(ESignificanceBucket Bucket);
+	void HandleSegmentRemoved(int32 Segment, AActor* Owner);
+};
@@ -0,0 +1,324 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "AnimNode_SpiderLegs.h"
+
+#include "Animation/AnimInstanceProxy.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "FABRIK.h"
+#include "SpiderCollision.h"
+#include "SpiderStats.h"
+
+namespace
+{
+	struct FDefaultLeg
+	{
+		const TCHAR* Hip;
+		const TCHAR* Foot;
+		int32 GaitGroup;
+	};
+
+	// Tetrapod gait, front and mid back of one side step with mid front and back of the other
+	constexpr FDefaultLeg DEFAULT_LEGS[]
+	{
+		{ TEXT("FrontLeg_L"), TEXT("FrontFoot_L_end"), 0 },
+		{ TEXT("MidFrontLeg_L"), TEXT("MidFrontFoot_L_end"), 1 },
+		{ TEXT("MidBackLeg_L"), TEXT("MidBackFoot_L_end"), 0 },
+		{ TEXT("BackLeg_L"), TEXT("BackFoot_L_end"), 1 },
+		{ TEXT("FrontLeg_R"), TEXT("FrontFoot2_R_end"), 1 },
+		{ TEXT("MidFrontLeg_R"), TEXT("MidFrontFoot_R_end"), 0 },
+		{ TEXT("MidBackLeg_R"), TEXT("MidBackFoot_R_end"), 1 },
+		{ TEXT("BackLeg_R"), TEXT("BackFoot_R_end"), 0 }
+	};
+}
+
+FAnimNode_SpiderLegs::FAnimNode_SpiderLegs()
+{
+	for (const FDefaultLeg& DefaultLeg : DEFAULT_LEGS)
+	{
+		FSpiderLegDefinition& Leg{ Legs.AddDefaulted_GetRef() };
+		Leg.Hip = FBoneReference{ DefaultLeg.Hip };
+		Leg.Foot = FBoneReference{ DefaultLeg.Foot };
+		Leg.GaitGroup = DefaultLeg.GaitGroup;
+	}
+}
+
+void FAnimNode_SpiderLegs::Initialize_AnyThread(const FAnimationInitializeContext& Context)
+{
+	FAnimNode_SkeletalControlBase::Initialize_AnyThread(Context);
+
+	m_LegStates.Reset();
+	m_LegStates.SetNum(Legs.Num());
+	m_SolvedTransforms.Reset();
+	m_Frame = 0;
+	m_SkippedTime = 0.f;
+}
+
+bool FAnimNode_SpiderLegs::HasPreUpdate() const
+{
+	return true;
+}
+
+void FAnimNode_SpiderLegs::PreUpdate(const UAnimInstance* InAnimInstance)
+{
+	FAnimNode_SkeletalControlBase::PreUpdate(InAnimInstance);
+
+	// The body is stuck to the surface, its up is the surface normal
+	const AActor* Owner{ InAnimInstance->GetOwningActor() };
+	m_Up = Owner ? Owner->GetActorUpVector() : FVector::UnitZ();
+
+	const USkeletalMeshComponent* Mesh{ InAnimInstance->GetSkelMeshComponent() };
+	m_LOD = Mesh ? Mesh->GetPredictedLODLevel() : 0;
+	const bool Reduced{ m_LOD >= ReducedDetailLOD };
+	// Switching detail solves in full once, the replayed pose is from the old bone set
+	if (Reduced != m_Reduced)
+		m_SolvedTransforms.Reset();
+	m_Reduced = Reduced;
+
+	TraceLegs(InAnimInstance);
+}
+
+void FAnimNode_SpiderLegs::GatherDebugData(FNodeDebugData& DebugData)
+{
+	FString DebugLine{ DebugData.GetNodeName(this) };
+	DebugLine += FString::Printf(TEXT("(LOD: %d%s)"), m_LOD, m_Reduced ? TEXT(", reduced") : TEXT(""));
+	DebugData.AddDebugItem(DebugLine);
+
+	ComponentPose.GatherDebugData(DebugData);
+}
+
+void FAnimNode_SpiderLegs::UpdateInternal(const FAnimationUpdateContext& Context)
+{
+	FAnimNode_SkeletalControlBase::UpdateInternal(Context);
+	m_DeltaTime = Context.GetDeltaTime();
+}
+
+void FAnimNode_SpiderLegs::EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderLegs);
+
+	// Where the animation puts the feet, the next traces look under them
+	for (FLegState& Leg : m_LegStates)
+	{
+		if (Leg.Chain.Num() < 2)
+			continue;
+
+		Leg.RestOffset = Output.Pose.GetComponentSpaceTransform(Leg.Chain.Last()).GetLocation();
+		Leg.HasRest = true;
+	}
+
+	// Far away the last solve is good enough for a few frames
+	++m_Frame;
+	m_SkippedTime += m_DeltaTime;
+	if (m_Reduced && m_Frame % FMath::Max(ReducedUpdateInterval, 1) != 0 && !m_SolvedTransforms.IsEmpty())
+	{
+		OutBoneTransforms = m_SolvedTransforms;
+		return;
+	}
+
+	const FTransform& ComponentTransform{ Output.AnimInstanceProxy->GetComponentTransform() };
+	PlanSteps(m_SkippedTime, ComponentTransform);
+	m_SkippedTime = 0.f;
+
+	for (const FLegState& Leg : m_LegStates)
+	{
+		// Nothing under a foot that isn't stepping, the animation keeps it
+		if (Leg.Chain.Num() < 2 || (!Leg.HasTarget && !Leg.Stepping))
+			continue;
+
+		SolveLeg(Leg, ComponentTransform.InverseTransformPosition(GetFootLocation(Leg)), Output, OutBoneTransforms);
+	}
+
+	OutBoneTransforms.Sort(FCompareBoneTransformIndex());
+	m_SolvedTransforms = OutBoneTransforms;
+}
+
+bool FAnimNode_SpiderLegs::IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones)
+{
+	for (const FLegState& Leg : m_LegStates)
+	{
+		if (Leg.Chain.Num() >= 2)
+			return true;
+	}
+	return false;
+}
+
+void FAnimNode_SpiderLegs::InitializeBoneReferences(const FBoneContainer& RequiredBones)
+{
+	// Called again on LOD changes, planted feet stay where they are.
+	// The replayed pose holds compact indices of the old bone container, the next frame solves in full
+	m_SolvedTransforms.Reset();
+	m_LegStates.SetNum(Legs.Num());
+	for (int32 Index{}; Index < Legs.Num(); ++Index)
+	{
+		FSpiderLegDefinition& Leg{ Legs[Index] };
+		TArray<FCompactPoseBoneIndex>& Chain{ m_LegStates[Index].Chain };
+		Chain.Reset();
+
+		Leg.Hip.Initialize(RequiredBones);
+		Leg.Foot.Initialize(RequiredBones);
+		if (!Leg.Hip.IsValidToEvaluate(RequiredBones) || !Leg.Foot.IsValidToEvaluate(RequiredBones))
+			continue;
+
+		// Walk up from the foot, the hip has to be one of its parents
+		const FCompactPoseBoneIndex Hip{ Leg.Hip.GetCompactPoseIndex(RequiredBones) };
+		for (FCompactPoseBoneIndex Bone{ Leg.Foot.GetCompactPoseIndex(RequiredBones) }; Bone.IsValid(); Bone = RequiredBones.GetParentBoneIndex(Bone))
+		{
+			Chain.Insert(Bone, 0);
+			if (Bone == Hip)
+				break;
+		}
+
+		if (Chain[0] != Hip)
+			Chain.Reset();
+	}
+}
+
+void FAnimNode_SpiderLegs::TraceLegs(const UAnimInstance* AnimInstance)
+{
+	UWorld* World{ AnimInstance->GetWorld() };
+	const USkeletalMeshComponent* Mesh{ AnimInstance->GetSkelMeshComponent() };
+	if (World == nullptr || Mesh == nullptr || m_LegStates.IsEmpty())
+		return;
+
+	// Last frame's batch
+	for (FLegState& Leg : m_LegStates)
+	{
+		FTraceDatum Datum{};
+		if (!Leg.Handle.IsValid() || !World->QueryTraceData(Leg.Handle, Datum))
+			continue;
+
+		Leg.Handle = {};
+		Leg.HasTarget = false;
+		for (const FHitResult& Hit : Datum.OutHits)
+		{
+			if (Hit.bBlockingHit)
+			{
+				Leg.Target = Hit.ImpactPoint;
+				Leg.HasTarget = true;
+				break;
+			}
+		}
+	}
+
+	// This frame's, every leg or a few round robin at a distance
+	const AActor* Owner{ AnimInstance->GetOwningActor() };
+	const FTransform& ComponentTransform{ Mesh->GetComponentTransform() };
+	const FVector Lead{ Owner ? Owner->GetVelocity() * VelocityLead : FVector::ZeroVector };
+	const FCollisionQueryParams Params{ SCENE_QUERY_STAT(SpiderLegs), false, Owner };
+	const FCollisionObjectQueryParams SurfaceQuery{ MakeSpiderSurfaceQuery() };
+
+	const int32 Count{ m_Reduced ? FMath::Clamp(ReducedTracesPerFrame, 1, m_LegStates.Num()) : m_LegStates.Num() };
+	for (int32 Traced{}; Traced < Count; ++Traced)
+	{
+		FLegState& Leg{ m_LegStates[(m_NextTracedLeg + Traced) % m_LegStates.Num()] };
+		if (!Leg.HasRest)
+			continue;
+
+		const FVector Rest{ ComponentTransform.TransformPosition(Leg.RestOffset) + Lead };
+		Leg.Handle = World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Rest + m_Up * TraceHeight, Rest - m_Up * TraceDepth, SurfaceQuery, Params);
+	}
+
+	m_NextTracedLeg = (m_NextTracedLeg + Count) % m_LegStates.Num();
+	INC_DWORD_STAT_BY(STAT_SpiderLegTraces, Count);
+}
+
+void FAnimNode_SpiderLegs::PlanSteps(float DeltaTime, const FTransform& ComponentTransform)
+{
+	// Land the feet that finished their step, the rest of their group is still in the air
+	bool GroupStepping[2]{};
+	for (int32 Index{}; Index < m_LegStates.Num(); ++Index)
+	{
+		FLegState& Leg{ m_LegStates[Index] };
+		if (!Leg.Stepping)
+			continue;
+
+		Leg.StepTime += DeltaTime;
+		if (Leg.StepTime >= StepDuration)
+		{
+			Leg.Stepping = false;
+			Leg.Planted = Leg.Target;
+			continue;
+		}
+		GroupStepping[Legs[Index].GaitGroup & 1] = true;
+	}
+
+	for (int32 Index{}; Index < m_LegStates.Num(); ++Index)
+	{
+		FLegState& Leg{ m_LegStates[Index] };
+		if (Leg.Chain.Num() < 2 || Leg.Stepping)
+			continue;
+
+		const FVector Rest{ ComponentTransform.TransformPosition(Leg.RestOffset) };
+		if (!Leg.HasTarget)
+		{
+			// Nothing to stand on, the foot hangs where the animation has it
+			Leg.Planted = Rest;
+			continue;
+		}
+
+		if (!Leg.Placed)
+		{
+			Leg.Planted = Leg.Target;
+			Leg.Placed = true;
+			continue;
+		}
+
+		// Groups take turns, a foot left far behind doesn't wait for its turn
+		const int32 Group{ Legs[Index].GaitGroup & 1 };
+		const double Error{ FVector::Dist(Leg.Planted, Leg.Target) };
+		if (Error <= StepDistance || (GroupStepping[1 - Group] && Error <= 2.0 * StepDistance))
+			continue;
+
+		Leg.Stepping = true;
+		Leg.StepFrom = Leg.Planted;
+		Leg.StepTime = 0.f;
+		GroupStepping[Group] = true;
+	}
+}
+
+FVector FAnimNode_SpiderLegs::GetFootLocation(const FLegState& Leg) const
+{
+	if (!Leg.Stepping)
+		return Leg.Planted;
+
+	// Arc over to the target, which keeps moving with the body
+	const float Alpha{ FMath::Clamp(Leg.StepTime / FMath::Max(StepDuration, UE_KINDA_SMALL_NUMBER), 0.f, 1.f) };
+	return FMath::Lerp(Leg.StepFrom, Leg.Target, Alpha) + m_Up * StepHeight * FMath::Sin(PI * Alpha);
+}
+
+void FAnimNode_SpiderLegs::SolveLeg(const FLegState& Leg, const FVector& FootLocation, FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) const
+{
+	const int32 Count{ Leg.Chain.Num() };
+	TArray<FTransform, TInlineAllocator<8>> Original{};
+	TArray<FFABRIKChainLink> Links{};
+	Links.Reserve(Count);
+
+	double Reach{};
+	for (int32 Index{}; Index < Count; ++Index)
+	{
+		const FTransform& Transform{ Original.Add_GetRef(Output.Pose.GetComponentSpaceTransform(Leg.Chain[Index])) };
+		const double Length{ Index == 0 ? 0.0 : FVector::Dist(Original[Index - 1].GetLocation(), Transform.GetLocation()) };
+		Reach += Length;
+		Links.Emplace(Transform.GetLocation(), Length, Leg.Chain[Index].GetInt(), Index);
+	}
+
+	if (!AnimationCore::SolveFabrik(Links, FootLocation, Reach, Precision, MaxIterations))
+		return;
+
+	// Turn every bone onto its new segment, the foot keeps its angle to the last one
+	FQuat Delta{ FQuat::Identity };
+	for (int32 Index{}; Index < Count; ++Index)
+	{
+		FTransform Transform{ Original[Index] };
+		if (Index + 1 < Count)
+		{
+			const FVector OldDirection{ (Original[Index + 1].GetLocation() - Transform.GetLocation()).GetSafeNormal() };
+			const FVector NewDirection{ (Links[Index + 1].Position - Links[Index].Position).GetSafeNormal() };
+			Delta = FQuat::FindBetweenNormals(OldDirection, NewDirection);
+		}
+
+		Transform.SetRotation((Delta * Transform.GetRotation()).GetNormalized());
+		Transform.SetTranslation(Links[Index].Position);
+		OutBoneTransforms.Emplace(Leg.Chain[Index], Transform);
+	}
+}
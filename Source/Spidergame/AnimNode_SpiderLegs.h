@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BoneControllers/AnimNode_SkeletalControlBase.h"
+#include "AnimNode_SpiderLegs.generated.h"
+
+USTRUCT(BlueprintType)
+struct SPIDERGAME_API FSpiderLegDefinition
+{
+	GENERATED_BODY()
+
+	// First bone of the leg, stays where the body puts it
+	UPROPERTY(EditAnywhere, Category="Leg")
+	FBoneReference Hip{};
+	// Tip of the leg, placed on the surface
+	UPROPERTY(EditAnywhere, Category="Leg")
+	FBoneReference Foot{};
+	// Legs of one group step together, the groups take turns
+	UPROPERTY(EditAnywhere, Category="Leg")
+	int32 GaitGroup{};
+};
+
+/**
+ * Procedural foot placement for the spider's legs.
+ * Game thread (PreUpdate) only fires one batch of async traces along the surface normal under every foot and picks up
+ * last frame's hits, the gait planner and the FABRIK solve run on the animation worker with the rest of the graph.
+ * Beyond ReducedDetailLOD fewer legs are traced per frame and the legs are solved every few frames only.
+ */
+USTRUCT(BlueprintInternalUseOnly)
+struct SPIDERGAME_API FAnimNode_SpiderLegs : public FAnimNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+	// Defaults match Spider_Skeleton
+	FAnimNode_SpiderLegs();
+
+	UPROPERTY(EditAnywhere, Category="Legs")
+	TArray<FSpiderLegDefinition> Legs{};
+
+	// Traces start this far above the animated foot and end this far below it, along the surface normal
+	UPROPERTY(EditAnywhere, Category="Trace")
+	float TraceHeight{ 40.f };
+	UPROPERTY(EditAnywhere, Category="Trace")
+	float TraceDepth{ 80.f };
+
+	// A planted foot steps once its spot is this far from where the animation wants it
+	UPROPERTY(EditAnywhere, Category="Gait")
+	float StepDistance{ 25.f };
+	UPROPERTY(EditAnywhere, Category="Gait")
+	float StepDuration{ 0.12f };
+	UPROPERTY(EditAnywhere, Category="Gait")
+	float StepHeight{ 12.f };
+	// Seconds of velocity the feet aim ahead, so they land where the body is going
+	UPROPERTY(EditAnywhere, Category="Gait")
+	float VelocityLead{ 0.1f };
+
+	UPROPERTY(EditAnywhere, Category="IK")
+	int32 MaxIterations{ 10 };
+	UPROPERTY(EditAnywhere, Category="IK")
+	float Precision{ 0.5f };
+
+	// From this mesh LOD on the legs are traced round robin and solved less often, LODThreshold turns the node off
+	UPROPERTY(EditAnywhere, Category="LOD")
+	int32 ReducedDetailLOD{ 1 };
+	UPROPERTY(EditAnywhere, Category="LOD")
+	int32 ReducedTracesPerFrame{ 2 };
+	UPROPERTY(EditAnywhere, Category="LOD")
+	int32 ReducedUpdateInterval{ 3 };
+
+	// FAnimNode_Base
+	virtual void Initialize_AnyThread(const FAnimationInitializeContext& Context) override;
+	virtual bool HasPreUpdate() const override;
+	virtual void PreUpdate(const UAnimInstance* InAnimInstance) override;
+	virtual void GatherDebugData(FNodeDebugData& DebugData) override;
+
+	// FAnimNode_SkeletalControlBase
+	virtual void UpdateInternal(const FAnimationUpdateContext& Context) override;
+	virtual void EvaluateSkeletalControl_AnyThread(FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) override;
+	virtual bool IsValidToEvaluate(const USkeleton* Skeleton, const FBoneContainer& RequiredBones) override;
+
+private:
+	struct FLegState
+	{
+		// Hip to foot
+		TArray<FCompactPoseBoneIndex> Chain{};
+
+		// Animated foot in component space, where the next trace goes
+		FVector RestOffset{};
+		bool HasRest{ false };
+
+		// Surface under the foot, world space, written on the game thread
+		FVector Target{};
+		bool HasTarget{ false };
+		FTraceHandle Handle{};
+
+		// Foot on the ground or in the air between StepFrom and Target, world space
+		FVector Planted{};
+		FVector StepFrom{};
+		float StepTime{};
+		bool Stepping{ false };
+		bool Placed{ false };
+	};
+
+	TArray<FLegState> m_LegStates{};
+
+	// Game thread copies for the worker
+	FVector m_Up{ FVector::UnitZ() };
+	int32 m_LOD{};
+	bool m_Reduced{ false };
+	int32 m_NextTracedLeg{};
+
+	float m_DeltaTime{};
+	float m_SkippedTime{};
+	uint32 m_Frame{};
+	// Reused on the frames a reduced LOD skips
+	TArray<FBoneTransform> m_SolvedTransforms{};
+
+	virtual void InitializeBoneReferences(const FBoneContainer& RequiredBones) override;
+
+	void TraceLegs(const UAnimInstance* AnimInstance);
+	void PlanSteps(float DeltaTime, const FTransform& ComponentTransform);
+	FVector GetFootLocation(const FLegState& Leg) const;
+	void SolveLeg(const FLegState& Leg, const FVector& FootLocation, FComponentSpacePoseContext& Output, TArray<FBoneTransform>& OutBoneTransforms) const;
+};
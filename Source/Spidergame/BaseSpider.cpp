@@ -1,11 +1,134 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 #include "BaseSpider.h"
 
+#include "ActorSignificanceSubsystem.h"
 #include "Camera/CameraComponent.h"
 #include "Components/ArrowComponent.h"
 #include "Components/AudioComponent.h"
 #include "Components/CapsuleComponent.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/Engine.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
 #include "GameFramework/SpringArmComponent.h"
+#include "Misc/PackageName.h"
+#include "Net/UnrealNetwork.h"
+#include "SpiderBatchSubsystem.h"
+#include "SpiderCollision.h"
+#include "SpiderStats.h"
+#include "WebGraphSubsystem.h"
+#include "WebPhysicsComponent.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSpiderContact, Log, All);
+DEFINE_LOG_CATEGORY_STATIC(LogSpiderReplay, Log, All);
+
+static TAutoConsoleVariable<bool> CVarSpiderContactValidate(
+	TEXT("Spider.ContactCache.Validate"),
+	false,
+	TEXT("Trace anyway when the contact cache answers a down probe and log where they disagree"));
+
+// Lets the movement simulation trace, sweep and play sounds through the pawn
+class FSpiderPawnWorld final : public ISpiderMovementWorld
+{
+public:
+	explicit FSpiderPawnWorld(ABaseSpider& Spider)
+		: m_Spider{ Spider }
+	{
+	}
+
+	virtual bool Probe(ESpiderProbe ProbeType, const FVector& Start, const FVector& End, FHitResult& OutHit) override
+	{
+		if (ProbeType == ESpiderProbe::Down)
+			return m_Spider.ProbeDown(Start, End, OutHit);
+
+		return m_Spider.m_Probes->Probe(&m_Spider, ProbeType, Start, End, OutHit);
+	}
+
+	virtual FVector Sweep(const FVector& Start, const FVector& Delta, const FQuat& Rotation) override
+	{
+		return m_Spider.Sweep(Start, Delta, Rotation);
+	}
+
+	virtual bool SweepProbe(const FVector& Start, const FVector& End, const FQuat& Rotation, FHitResult& OutHit) override
+	{
+		return m_Spider.SweepProbe(Start, End, Rotation, OutHit);
+	}
+
+	virtual bool CanStandOn(const FHitResult& HitResult) const override
+	{
+		return GetSpiderSurface(HitResult) != ESpiderSurface::None;
+	}
+
+	virtual bool IsWeb(const FHitResult& HitResult) const override
+	{
+		return GetSpiderSurface(HitResult) == ESpiderSurface::Web;
+	}
+
+	virtual bool IsWebLine(const FHitResult& HitResult) const override
+	{
+		return GetSpiderSurface(HitResult) == ESpiderSurface::WebLine;
+	}
+
+	virtual void MountWebLine(const FHitResult& HitResult) override
+	{
+		// Registered strands are known right away, Blueprint can still override it through SetClosestWeb
+		int32 Segment{};
+		FVector ClosestPoint{};
+		const UWebGraphSubsystem* Webs{ m_Spider.m_Webs };
+		if (Webs && Webs->FindClosestSegment(HitResult.ImpactPoint, m_Spider.WebMountDistance, Segment, ClosestPoint))
+			m_Spider.m_Movement.SetClosestWeb(Webs->GetSegmentStart(Segment), Webs->GetSegmentEnd(Segment), Segment);
+
+		m_Spider.MountWebLine(HitResult.GetActor());
+	}
+
+	virtual bool GetWebStrand(int32 Strand, FVector& OutStart, FVector& OutEnd) const override
+	{
+		const UWebGraphSubsystem* Webs{ m_Spider.m_Webs };
+		if (Webs == nullptr || !Webs->IsValidSegment(Strand))
+			return false;
+
+		OutStart = Webs->GetSegmentStart(Strand);
+		OutEnd = Webs->GetSegmentEnd(Strand);
+		return true;
+	}
+
+	virtual bool IsWebStrandDetached(int32 Strand) const override
+	{
+		const UWebGraphSubsystem* Webs{ m_Spider.m_Webs };
+		return Webs && Webs->IsSegmentDetached(Strand);
+	}
+
+	virtual int32 FindWebJunction(int32 Strand, const FVector& Point, const FVector& Direction) const override
+	{
+		const UWebGraphSubsystem* Webs{ m_Spider.m_Webs };
+		const float MinAlignment{ FMath::Cos(FMath::DegreesToRadians(m_Spider.WebJunctionMaxAngle)) };
+		return Webs ? Webs->FindConnectedSegment(Strand, Point, Direction, m_Spider.WebJunctionDistance, MinAlignment) : INDEX_NONE;
+	}
+
+	virtual void PlayWalkSound(bool OnWeb, bool Moving) override
+	{
+		UAudioComponent* AudioPtr = (OnWeb) ? m_Spider.WebWalkSound : m_Spider.WalkSound;
+		m_Spider.PlaySound(AudioPtr, Moving);
+	}
+
+	virtual void PlayLandingSound() override
+	{
+		m_Spider.LandingSound->Play();
+	}
+
+	virtual void StopWalkSound() override
+	{
+		m_Spider.WalkSound->Stop();
+	}
+
+	virtual void StopAllSounds() override
+	{
+		m_Spider.StopAllSounds();
+	}
+
+private:
+	ABaseSpider& m_Spider;
+};
 
 // Sets default values
 ABaseSpider::ABaseSpider()
@@ -37,6 +160,10 @@ ABaseSpider::ABaseSpider()
 	WalkSound = CreateDefaultSubobject<UAudioComponent>(TEXT("Walk"));
 	WebWalkSound = CreateDefaultSubobject<UAudioComponent>(TEXT("WebWalk"));
 	LandingSound = CreateDefaultSubobject<UAudioComponent>(TEXT("Land"));
+
+	// Movement replicates through m_NetState, the engine's transform replication would fight it
+	bReplicates = true;
+	SetReplicateMovement(false);
 }
 
 // Called when the game starts or when spawned
@@ -44,37 +171,84 @@ void ABaseSpider::BeginPlay()
 {
 	Super::BeginPlay();
 	StopAllSounds();
+
+	m_Probes = GetWorld()->GetSubsystem<USpiderProbeSubsystem>();
+	m_Probes->Register(this);
+	if (UActorSignificanceSubsystem* Significance{ GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->RegisterSpider(this);
+	m_Webs = GetWorld()->GetSubsystem<UWebGraphSubsystem>();
+	m_Batch = GetWorld()->GetSubsystem<USpiderBatchSubsystem>();
+
+	// Sweep like the collider would when moved with sweep enabled
+	m_SweepParams = FCollisionQueryParams{ SCENE_QUERY_STAT(SpiderMove), false, this };
+	Collider->InitSweepCollisionParams(m_SweepParams, m_SweepResponseParams);
+
+	SyncMovementParams();
+	m_Movement.TraceId = GetUniqueID();
+	m_Movement.Teleport(GetActorLocation(), GetActorQuat());
+	m_PreviousSim = m_Movement.GetSimState();
+	m_RenderedLocation = GetActorLocation();
+
+	m_NetHistory.SetNum(NET_HISTORY_SIZE);
+	NetUpdateFrequency = MovingNetUpdateRate;
+	MinNetUpdateFrequency = IdleNetUpdateRate;
+	if (HasAuthority())
+		m_NetState = FSpiderNetState::FromSim(m_Movement.GetSimState(), m_SteppedNetSequence);
+}
+
+void ABaseSpider::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopRecording();
+	StopReplay();
+	if (m_Probes)
+		m_Probes->Unregister(this);
+	if (UActorSignificanceSubsystem* Significance{ GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->Unregister(this);
+
+	Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void ABaseSpider::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	
-	switch (m_State)
-	{
-	case State::Ground:
-		Grounded(DeltaTime);
-		break;
-	case State::Transition:
-		Transition(DeltaTime);
-		break;
-	case State::Fall:
-		Falling(DeltaTime);
-		break;
-	case State::OnWeb:
-		OnWeb(DeltaTime);
-		break;
-	case State::Jumping:
-		Jumping(DeltaTime);
-		break;
-	default:
-		Falling(DeltaTime);
-		break;
-	}
 
-	ConsumeMovementInputVector(); // consume in case of buildup
-	AddActorWorldOffset(m_Velocity * DeltaTime, true);
+	SyncMovementParams();
+	if (IsReplaying())
+		DeltaTime = ReplayFrame(DeltaTime);
+	else if (m_Recording)
+		RecordFrame(DeltaTime);
+
+	if (GetLocalRole() == ROLE_SimulatedProxy)
+		InterpolateProxy(DeltaTime);
+	else if (IsRemotelyControlled())
+		SimulateRemote(DeltaTime);
+	else if (m_Batch && m_Batch->ShouldBatch(this))
+		m_Batch->Queue(this, DeltaTime);
+	else
+		Simulate(DeltaTime);
+	UpdateNetBandwidth(DeltaTime);
+	RotateCamera();
+}
+
+void ABaseSpider::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ABaseSpider, m_NetState);
+}
+
+void ABaseSpider::PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker)
+{
+	Super::PreReplication(ChangedPropertyTracker);
+
+	// Only changes go out, every client connection gets its own copy
+	if (m_NetState.Identical(&m_LastSentNetState, 0))
+		return;
+
+	const UNetDriver* NetDriver{ GetNetDriver() };
+	m_NetBits += static_cast<int64>(m_NetState.GetNetBits()) * (NetDriver ? NetDriver->ClientConnections.Num() : 0);
+	m_LastSentNetState = m_NetState;
 }
 
 // Called to bind functionality to input
@@ -83,394 +257,635 @@ void ABaseSpider::SetupPlayerInputComponent(UInputComponent* PlayerInputComponen
 	Super::SetupPlayerInputComponent(PlayerInputComponent);
 }
 
-#pragma region States
+#pragma region Simulation
 // ==============================================================================
-// States
+// Simulation
 // ==============================================================================
 
+void ABaseSpider::SyncMovementParams()
+{
+	FSpiderMovementParams& Params{ m_Movement.Params };
+	Params.MovementSpeed = MovementSpeed;
+	Params.WallInterpolateTime = WallInterpolateTime;
+	Params.LargeLerpCompensation = LargeLerpCompensation;
+	Params.Gravity = Gravity;
+	Params.Drag = Drag;
+	Params.WallCheckDistance = WallCheckDistance;
+	Params.GroundCheckDistance = GroundCheckDistance;
+	Params.JumpImmuneTime = JumpImmuneTime;
+	Params.CapsuleRadius = Collider->GetScaledCapsuleRadius();
+	Params.MaxFallSubsteps = MaxFallSubsteps;
+
+	m_FixedStep.StepTime = 1.f / FMath::Max(SimulationRate, 1.f);
+	m_FixedStep.MaxSteps = FMath::Max(MaxSimulationSteps, 1);
+}
 
-void ABaseSpider::Transition(float DeltaTime)
+void ABaseSpider::Simulate(float DeltaTime)
 {
-	WalkSound->Stop();
-	m_Velocity = {};
-	
-	if (!IsTransitioning())
+	SCOPE_CYCLE_COUNTER(STAT_SpiderSimulate);
+	CSV_SCOPED_TIMING_STAT(Spider, Simulate);
+
+	BeginSimulate(DeltaTime);
+	for (int32 Step{}; Step < m_FrameSteps; ++Step)
+		FinishStep(IntegrateStep());
+	EndSimulate();
+}
+
+void ABaseSpider::BeginSimulate(float DeltaTime)
+{
+	// Input is held for every step of the frame
+	m_FrameInput = { static_cast<float>(ConsumeMovementInputVector().Y), static_cast<float>(GetControlRotation().Yaw), m_PendingJump };
+	// Predict with exactly what the server will get
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+		m_FrameInput = FSpiderNetInput::Quantize(m_FrameInput).Dequantize();
+
+	SyncTeleport();
+
+	m_FrameSteps = m_FixedStep.Advance(DeltaTime);
+	m_Landed = false;
+	m_LandingVelocity = {};
+}
+
+bool ABaseSpider::IntegrateStep()
+{
+	m_PreviousSim = m_Movement.GetSimState();
+	return m_Movement.Integrate(m_FixedStep.StepTime, m_FrameInput);
+}
+
+void ABaseSpider::FinishStep(bool Integrated)
+{
+	FSpiderPawnWorld World{ *this };
+	if (Integrated)
+		m_Movement.FinishIntegrate(m_FixedStep.StepTime, World);
+	else
+		m_Movement.Step(m_FixedStep.StepTime, m_FrameInput, World);
+
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+		RecordNetStep();
+
+	// A jump only goes into one step
+	m_FrameInput.JumpPower = 0.f;
+	m_PendingJump = 0.f;
+
+	if (m_PreviousSim.State != ESpiderState::OnWeb && m_Movement.GetSimState().State == ESpiderState::OnWeb)
 	{
-		m_State = IsOnWeb() ? State::OnWeb : State::Ground;
-		StickToSurface();
-		return;
+		m_Landed = true;
+		m_LandingVelocity = m_PreviousSim.Velocity;
 	}
-	
-	TransitionSurfaces(DeltaTime);
-	RotateCamera();
-	
-	
-	m_OldState = State::Transition;
 }
 
-void ABaseSpider::Grounded(float DeltaTime)
+void ABaseSpider::EndSimulate()
 {
-	// Reset velocity later, used in state switching checking
-	CheckGrounded();
-	CheckWall();
+	ApplySimulation(m_FixedStep.GetAlpha());
+	LoadWeb(m_Landed, m_LandingVelocity);
 
-	// Different ground check
-	if (ChangedGround())
-	{
-		SetTransition(m_DownHitResult);
-		m_State = State::Transition;
-		m_Velocity = {};
-		StopAllSounds();
+	if (HasAuthority())
+		UpdateNetState();
+	else if (GetLocalRole() == ROLE_AutonomousProxy)
+		SendNetSteps();
+}
+
+void ABaseSpider::SyncTeleport()
+{
+	if (GetActorLocation().Equals(m_RenderedLocation))
 		return;
-	}
 
-	if (HitWall() && IsMoving())
-	{
-		SetTransition(m_ForwardHitResult);
-		m_State = State::Transition;
-		m_Velocity = {};
-		StopAllSounds();
+	m_Movement.Teleport(GetActorLocation(), GetActorQuat());
+	m_PreviousSim = m_Movement.GetSimState();
+	m_ContactCache.Invalidate();
+}
+
+void ABaseSpider::RemountWeb()
+{
+	const FSpiderSimState& Sim{ m_Movement.GetSimState() };
+	if (Sim.State != ESpiderState::OnWeb || m_Webs == nullptr)
 		return;
-	}
-	
-	if (!IsGrounded())
-	{
-		m_State = State::Fall;
-		m_Velocity = {};
-		StopAllSounds();
+
+	// Segment handles are local to this world, the strand is found again by its middle.
+	// Where that isn't ours, the closest strand to the spider
+	int32 Segment{};
+	FVector ClosestPoint{};
+	const FVector Middle{ (Sim.StartLinePoint + Sim.EndLinePoint) * 0.5 };
+	if (m_Webs->FindClosestSegment(Middle, WebMountDistance, Segment, ClosestPoint)
+		|| m_Webs->FindClosestSegment(Sim.Location, WebMountDistance, Segment, ClosestPoint))
+		m_Movement.SetClosestWeb(m_Webs->GetSegmentStart(Segment), m_Webs->GetSegmentEnd(Segment), Segment);
+}
+
+void ABaseSpider::LoadWeb(bool Landed, const FVector& LandingVelocity)
+{
+	const FSpiderSimState& Current{ m_Movement.GetSimState() };
+	if (Current.State != ESpiderState::OnWeb || m_Webs == nullptr)
 		return;
-	}
 
-	m_Velocity = {};
-	
-	// Turn camera + body
-	RotateCamera();
-	RotateBody();
-	
-	HandleMove(Spider->GetForwardVector());
-	if (IsMoving())
-	{
-		StickToSurface();
-		if (ChangedGround() && IsOnWeb())
-		{
-			m_State = State::OnWeb;
-			m_Velocity = {};
-			return;
-		}
-	}
+	// Riding a registered strand we already know where we are on it
+	int32 Segment{ Current.WebStrand };
+	FVector ClosestPoint{};
+	if (m_Webs->IsValidSegment(Segment))
+		ClosestPoint = FMath::ClosestPointOnSegment(Current.Location, m_Webs->GetSegmentStart(Segment), m_Webs->GetSegmentEnd(Segment));
+	else if (!m_Webs->FindClosestSegment(Current.Location, WebMountDistance, Segment, ClosestPoint))
+		return;
 
-	// Play web walking sound if on a big web
-	const bool OnWeb{ m_DownHitResult.GetActor()->Tags.Contains(WebTag) };
-	UAudioComponent* AudioPtr = (OnWeb) ? WebWalkSound : WalkSound;
-	
-	PlaySound(AudioPtr, m_Velocity.SquaredLength() > 0);
-	
-	m_OldState = State::Ground;
+	const AActor* Web{ m_Webs->GetSegmentOwner(Segment) };
+	UWebPhysicsComponent* WebPhysics{ Web ? Web->FindComponentByClass<UWebPhysicsComponent>() : nullptr };
+	if (WebPhysics == nullptr)
+		return;
+
+	if (Landed)
+		WebPhysics->AddImpulseAtLocation(ClosestPoint, LandingVelocity * WebMass);
+	WebPhysics->AddForceAtLocation(ClosestPoint, { 0.f, 0.f, -WebMass * Gravity });
 }
 
-void ABaseSpider::OnWeb(float DeltaTime)
+void ABaseSpider::ApplySimulation(float Alpha)
 {
-	// Reset velocity later, used in state switching checking
-	CheckGrounded();
-	CheckWall();
-	
-	if (!IsGrounded())
-	{
-		m_State = State::Fall;
-		m_Velocity = {};
-		StopAllSounds();
+	// Render between the last two steps, the simulation itself never sees this transform
+	const FSpiderSimState& Current{ m_Movement.GetSimState() };
+	const FVector Location{ FMath::Lerp(m_PreviousSim.Location, Current.Location, Alpha) };
+	const FQuat Rotation{ FQuat::Slerp(m_PreviousSim.SurfaceRotation, Current.SurfaceRotation, Alpha) };
+
+	SetActorLocationAndRotation(Location, Rotation);
+	m_RenderedLocation = GetActorLocation();
+	Spider->SetRelativeRotation({ 0, Current.BodyYaw, 0 });
+}
+
+#pragma endregion Simulation
+
+#pragma region PlayerControlledAction
+// ==============================================================================
+// Player controlled action
+// ==============================================================================
+
+void ABaseSpider::RotateCamera()
+{
+	const FRotator BodyRotation{ GetControlRotation() };
+	Camera->SetRelativeRotation( { BodyRotation.Pitch, 0 ,0} );
+}
+
+void ABaseSpider::Jump(float JumpPower)
+{
+	if (UActorSignificanceSubsystem* Significance{ GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->Wake(this);
+
+	// Jumps with the next step, so it is part of the input the server gets and replays see
+	m_PendingJump = FMath::Clamp(JumpPower, 0.f, MaxJumpPower);
+}
+
+void ABaseSpider::AddMovementInput(FVector WorldDirection, float ScaleValue, bool bForce)
+{
+	Super::AddMovementInput(WorldDirection, ScaleValue, bForce);
+
+	if (ScaleValue == 0.f || WorldDirection.IsZero())
 		return;
-	}
-	
-	if (HitWall() && IsMoving())
+
+	if (UActorSignificanceSubsystem* Significance{ GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->Wake(this);
+}
+
+#pragma endregion PlayerControlledAction
+
+#pragma region Network
+// ==============================================================================
+// Network
+// ==============================================================================
+
+bool ABaseSpider::IsRemotelyControlled() const
+{
+	return HasAuthority() && IsPlayerControlled() && !IsLocallyControlled();
+}
+
+void ABaseSpider::SimulateRemote(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderSimulate);
+	CSV_SCOPED_TIMING_STAT(Spider, Simulate);
+
+	SyncTeleport();
+	m_Landed = false;
+	m_LandingVelocity = {};
+
+	// One step per client step, but no more than the server's own clock has time for.
+	// A little is banked so steps arriving in bursts still catch up
+	m_ServerStepBudget = FMath::Min(m_ServerStepBudget + DeltaTime / m_FixedStep.StepTime, static_cast<float>(m_FixedStep.MaxSteps));
+	const int32 Steps{ FMath::Min(m_ServerSteps.Num(), FMath::FloorToInt(m_ServerStepBudget)) };
+	m_ServerStepBudget -= Steps;
+	for (int32 Step{}; Step < Steps; ++Step)
 	{
-		SetTransition(m_ForwardHitResult);
-		m_State = State::Transition;
-		m_Velocity = {};
-		StopAllSounds();
-		return;
+		m_FrameInput = m_ServerSteps[Step].Input.Dequantize();
+		FinishStep(IntegrateStep());
+		m_SteppedNetSequence = m_ServerSteps[Step].Sequence;
 	}
+	m_ServerSteps.RemoveAt(0, Steps, false);
 
-	m_Velocity = {};
-	
-	RotateCamera();
-	RotateBody();
+	ApplySimulation(1.f);
+	LoadWeb(m_Landed, m_LandingVelocity);
+	UpdateNetState();
+}
+
+void ABaseSpider::InterpolateProxy(float DeltaTime)
+{
+	// Between the last two states we got, as far apart as they arrived
+	m_ProxyTime += DeltaTime;
+	ApplySimulation(m_ProxyDuration > 0.f ? FMath::Min(m_ProxyTime / m_ProxyDuration, 1.f) : 1.f);
+}
+
+void ABaseSpider::RecordNetStep()
+{
+	FSpiderNetStep& Step{ m_NetHistory[m_NextNetSequence % NET_HISTORY_SIZE] };
+	Step.Sequence = m_NextNetSequence++;
+	Step.Input = FSpiderNetInput::Quantize(m_FrameInput);
+	Step.State = m_Movement.GetSimState();
+}
 
-	// Move on web back and forth based on looking direction
-	FVector Direction{ m_EndLinePoint - m_StartLinePoint };
-	Direction.Normalize();
+void ABaseSpider::SendNetSteps()
+{
+	if (m_FrameSteps == 0)
+		return;
 
-	const double cosAngle{ Spider->GetForwardVector().Dot(Direction) };
-	Direction *= FMath::Sign(cosAngle);
-		
-	HandleMove(Direction);
+	// Every step the server hasn't confirmed yet that fits, a lost packet is covered by the next one
+	const uint16 Unacked{ static_cast<uint16>(m_NextNetSequence - m_AckedNetSequence - 1) };
+	const int32 Count{ FMath::Min<int32>(Unacked, FSpiderNetInputs::MAX_INPUTS) };
 
-	PlaySound(WebWalkSound, m_Velocity.SquaredLength() > 0);
-	
-	m_OldState = State::OnWeb;
+	FSpiderNetInputs Moves{};
+	Moves.LastSequence = static_cast<uint16>(m_NextNetSequence - 1);
+	Moves.Inputs.Reserve(Count);
+	for (int32 Index{ Count - 1 }; Index >= 0; --Index)
+		Moves.Inputs.Add(m_NetHistory[static_cast<uint16>(Moves.LastSequence - Index) % NET_HISTORY_SIZE].Input);
+
+	m_NetBits += Moves.GetNetBits();
+	ServerMove(Moves);
 }
 
-void ABaseSpider::Falling(float DeltaTime)
+void ABaseSpider::ServerMove_Implementation(const FSpiderNetInputs& Moves)
 {
-	WalkSound->Stop();
-	
-	if (CheckWall())
+	// Resent steps we already have are skipped
+	const uint16 MaxNetJump{ FSpiderNetInput::Quantize({ 0.f, 0.f, MaxJumpPower }).JumpPower };
+	bool Moving{ false };
+	const int32 Count{ Moves.Inputs.Num() };
+	for (int32 Index{}; Index < Count; ++Index)
 	{
-		SetTransition(m_ForwardHitResult);
-		m_State = State::Transition;
-		m_Velocity = {};
-		LandingSound->Play();
-		return;
+		const uint16 Sequence{ static_cast<uint16>(Moves.LastSequence - (Count - 1 - Index)) };
+		if (!FSpiderNetState::IsNewer(Sequence, m_ReceivedNetSequence))
+			continue;
+
+		// Inputs are the client's word, keep them to what a local player could do
+		FSpiderNetInput Input{ Moves.Inputs[Index] };
+		Input.Forward = FMath::Max(Input.Forward, static_cast<int8>(-MAX_int8));
+		Input.JumpPower = FMath::Min(Input.JumpPower, MaxNetJump);
+		m_ServerSteps.Add({ Sequence, Input });
+		m_ReceivedNetSequence = Sequence;
+		Moving |= Input.Forward != 0 || Input.JumpPower > 0;
 	}
-	
-	if (CollisionPrediction(DeltaTime))
+
+	if (m_ServerSteps.Num() > MAX_QUEUED_NET_STEPS)
+		m_ServerSteps.RemoveAt(0, m_ServerSteps.Num() - MAX_QUEUED_NET_STEPS, false);
+
+	if (!Moving)
+		return;
+
+	if (UActorSignificanceSubsystem* Significance{ GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->Wake(this);
+}
+
+void ABaseSpider::UpdateNetState()
+{
+	if (GetNetMode() == NM_Standalone)
+		return;
+
+	const FSpiderNetState NetState{ FSpiderNetState::FromSim(m_Movement.GetSimState(), m_SteppedNetSequence) };
+	if (NetState.State != m_NetState.State)
+		ForceNetUpdate();
+	m_NetState = NetState;
+
+	// Adaptive rate, standing still only needs the odd update
+	if (NetState.State == ESpiderState::Fall || NetState.State == ESpiderState::Jumping)
+		NetUpdateFrequency = AirborneNetUpdateRate;
+	else if (IsIdle())
+		NetUpdateFrequency = IdleNetUpdateRate;
+	else
+		NetUpdateFrequency = MovingNetUpdateRate;
+}
+
+void ABaseSpider::OnRep_NetState()
+{
+	if (GetLocalRole() == ROLE_AutonomousProxy)
 	{
-		m_Velocity = {};
-		if(ChangedGround())
-		{
-			SetTransition(m_DownHitResult);
-			m_State = State::Transition;
-		}
-		else
-		{
-			StickToSurface();
-			m_State = State::Ground;
-		}
-
-		LandingSound->Play();
+		Reconcile();
 		return;
 	}
 
-	RotateToWorld(DeltaTime);
+	// Simulated proxy, interpolate from where it is drawn now to the new state
+	const double Now{ GetWorld()->GetTimeSeconds() };
+	m_ProxyDuration = m_LastNetStateTime > 0.0 ? FMath::Clamp(static_cast<float>(Now - m_LastNetStateTime), m_FixedStep.StepTime, 1.f) : 0.f;
+	m_ProxyTime = 0.f;
+	m_LastNetStateTime = Now;
 
-	// Standard falling
-	RotateCamera();
-	RotateBody();
+	FSpiderSimState Sim{ m_Movement.GetSimState() };
+	m_PreviousSim = Sim;
+	m_PreviousSim.Location = GetActorLocation();
+	m_PreviousSim.SurfaceRotation = GetActorQuat();
+	m_NetState.ToSim(Sim);
+	m_Movement.SetSimState(Sim);
 
-	ApplyGravity(DeltaTime);
-	ApplyDrag(DeltaTime);
-	
-	ConsumeMovementInputVector(); // consume in case of buildup
-	m_OldState = State::Fall;
+	if (UActorSignificanceSubsystem* Significance{ GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->Wake(this);
 }
 
-void ABaseSpider::Jumping(float DeltaTime)
+void ABaseSpider::Reconcile()
 {
-	m_JumpImmuneTimer -= DeltaTime;
-	if (m_JumpImmuneTimer < 0)
+	// Out of order or already handled
+	const uint16 Acked{ m_NetState.Sequence };
+	if (FSpiderNetState::IsNewer(m_AckedNetSequence, Acked))
+		return;
+	m_AckedNetSequence = Acked;
+
+	// Compare with what we predicted for the same step, with nothing in flight that is where we are now
+	const FSpiderNetStep& Predicted{ m_NetHistory[Acked % NET_HISTORY_SIZE] };
+	const bool Pending{ m_NextNetSequence != static_cast<uint16>(Acked + 1) };
+	const FSpiderSimState* Compare{ Predicted.Sequence == Acked ? &Predicted.State : Pending ? nullptr : &m_Movement.GetSimState() };
+	if (Compare && Compare->State == m_NetState.State && Compare->Location.Equals(m_NetState.Location, NetCorrectionDistance))
+		return;
+
+	// Mispredicted, take the server's state and replay the steps it hasn't seen yet on top
+	INC_DWORD_STAT(STAT_SpiderNetCorrections);
+	FSpiderSimState Corrected{ Compare ? *Compare : m_Movement.GetSimState() };
+	m_NetState.ToSim(Corrected);
+	m_Movement.SetSimState(Corrected);
+	m_ContactCache.Invalidate();
+	// Segment handles are local, find the strand the server sent
+	RemountWeb();
+
+	FSpiderPawnWorld World{ *this };
+	for (uint16 Sequence{ static_cast<uint16>(Acked + 1) }; Sequence != m_NextNetSequence; ++Sequence)
 	{
-		m_State = State::Fall;
+		FSpiderNetStep& Step{ m_NetHistory[Sequence % NET_HISTORY_SIZE] };
+		if (Step.Sequence != Sequence)
+			break;
+
+		m_Movement.Step(m_FixedStep.StepTime, Step.Input.Dequantize(), World);
+		Step.State = m_Movement.GetSimState();
+	}
+}
+
+void ABaseSpider::UpdateNetBandwidth(float DeltaTime)
+{
+	if (GetNetMode() == NM_Standalone)
 		return;
+
+	m_NetWindowTime += DeltaTime;
+	if (m_NetWindowTime >= 1.f)
+	{
+		m_NetBytesPerSecond = static_cast<float>(m_NetBits) / 8.f / m_NetWindowTime;
+		m_NetBits = 0;
+		m_NetWindowTime = 0.f;
 	}
-	RotateToWorld(DeltaTime);
 
-	// Standard falling
-	RotateCamera();
-	RotateBody();
+	// Summed over every spider, the frame's total movement bandwidth
+	CSV_CUSTOM_STAT(Spider, NetBytesPerSecond, m_NetBytesPerSecond, ECsvCustomStatOp::Accumulate);
+}
 
-	ApplyGravity(DeltaTime);
-	ApplyDrag(DeltaTime);
-	
-	m_OldState = State::Jumping;
+float ABaseSpider::GetNetBytesPerSecond() const
+{
+	return m_NetBytesPerSecond;
 }
 
-#pragma endregion States
+#pragma endregion Network
 
-#pragma region PlayerControlledAction
+#pragma region Recording
 // ==============================================================================
-// Player controlled action
+// Recording
 // ==============================================================================
 
-void ABaseSpider::RotateCamera()
+void ABaseSpider::StartRecording()
 {
-	const FRotator BodyRotation{ GetController()->GetControlRotation() };
-	Camera->SetRelativeRotation( { BodyRotation.Pitch, 0 ,0} );
-}
+	// Both ends start from an empty accumulator, so every frame steps the same
+	m_FixedStep.Reset();
+	m_WebActions = 0;
 
-void ABaseSpider::RotateBody() const
-{
-	const FRotator BodyRotation{ GetController()->GetControlRotation() };
-	Spider->SetRelativeRotation({0, BodyRotation.Yaw, 0});
+	m_Recording = MakeUnique<FSpiderRecording>();
+	m_Recording->MapPath = UWorld::RemovePIEPrefix(GetWorld()->GetOutermost()->GetName());
+	m_Recording->StepTime = m_FixedStep.StepTime;
+	m_Recording->MaxSteps = m_FixedStep.MaxSteps;
 }
 
-void ABaseSpider::HandleMove(const FVector& Direction)
+FString ABaseSpider::StopRecording()
 {
-	const FVector Movement{ ConsumeMovementInputVector() };
-	const double Length{ Movement.Y * MovementSpeed };
-	
-	m_Velocity += Direction * Length;
+	if (m_Recording == nullptr)
+		return {};
+
+	const TUniquePtr<FSpiderRecording> Recording{ MoveTemp(m_Recording) };
+	if (Recording->Frames.IsEmpty())
+		return {};
+
+	const FString Path{ FSpiderRecording::MakePath(FPackageName::GetShortName(Recording->MapPath)) };
+	if (!Recording->Save(Path))
+	{
+		UE_LOG(LogSpiderReplay, Error, TEXT("%s: could not write %s"), *GetName(), *Path);
+		return {};
+	}
+
+	UE_LOG(LogSpiderReplay, Display, TEXT("%s: recorded %d frames to %s"), *GetName(), Recording->Frames.Num(), *Path);
+	return Path;
 }
 
-void ABaseSpider::Jump(float JumpPower)
+bool ABaseSpider::StartReplay(const TSharedPtr<const FSpiderRecording>& Recording)
 {
-	if (!CheckGrounded())
-		return;
+	if (Recording == nullptr || Recording->Frames.IsEmpty() || Recording->Snapshots.IsEmpty())
+		return false;
 
-	// Jump more forward if moving forward
-	if (m_Velocity.SquaredLength() != 0)
-		m_Velocity.Normalize();
-	
-	m_Velocity += Spider->GetUpVector();
-	m_Velocity.Normalize();
-	m_Velocity *= JumpPower;
-	
-	m_JumpImmuneTimer = JumpImmuneTime;
+	if (!FMath::IsNearlyEqual(Recording->StepTime, m_FixedStep.StepTime) || Recording->MaxSteps != m_FixedStep.MaxSteps)
+		UE_LOG(LogSpiderReplay, Warning, TEXT("%s: recorded with other fixed step settings, the replay won't match"), *GetName());
 
-	StopAllSounds();
-	m_State = State::Jumping;
+	m_Recording.Reset();
+	m_Replay = Recording;
+	m_ReplayFrame = 0;
+	m_ReplaySnapshot = 0;
+	m_ReplayDivergences = 0;
+	m_PendingJump = 0.f;
+	ConsumeMovementInputVector();
+
+	// Exactly where the recording started, accumulator included
+	m_Movement.SetSimState(Recording->Snapshots[0].State);
+	RemountWeb();
+	m_FixedStep.Reset();
+	m_PreviousSim = m_Movement.GetSimState();
+	m_ContactCache.Invalidate();
+	ApplySimulation(1.f);
+	return true;
 }
 
-#pragma endregion PlayerControlledAction
+bool ABaseSpider::StartReplayFromFile(const FString& Path)
+{
+	const TSharedRef<FSpiderRecording> Recording{ MakeShared<FSpiderRecording>() };
+	if (!Recording->Load(Path))
+	{
+		UE_LOG(LogSpiderReplay, Error, TEXT("%s: could not read recording %s"), *GetName(), *Path);
+		return false;
+	}
 
-#pragma region Physics
-// ==============================================================================
-// Physics
-// ==============================================================================
+	return StartReplay(Recording);
+}
 
-void ABaseSpider::ApplyGravity(float DeltaTime)
+void ABaseSpider::StopReplay()
 {
-	m_Velocity.Z -= Gravity * DeltaTime;
+	if (m_Replay == nullptr)
+		return;
+
+	UE_LOG(LogSpiderReplay, Display, TEXT("%s: replayed %d of %d frames, %d diverged snapshots"), *GetName(),
+		m_ReplayFrame, m_Replay->Frames.Num(), m_ReplayDivergences);
+	m_Replay.Reset();
 }
 
-void ABaseSpider::ApplyDrag(float DeltaTime)
+bool ABaseSpider::IsRecording() const
 {
-	m_Velocity -= m_Velocity * Drag * DeltaTime;
+	return m_Recording.IsValid();
 }
-#pragma endregion Physics
-
-#pragma region SurfaceSticking
-// ==============================================================================
-// Surface sticking
-// ==============================================================================
 
-void ABaseSpider::SetTransition(const FHitResult& HitResult)
+bool ABaseSpider::IsReplaying() const
 {
-	CalcSurfaceStickPoint(HitResult);
-	CalcLerpRatio();
-	m_LerpTimer = 0.f;
+	return m_Replay.IsValid();
 }
 
-void ABaseSpider::TransitionSurfaces(float DeltaTime)
+int32 ABaseSpider::GetReplayDivergences() const
 {
-	// Ratio to get the correct Lerp values
-	// Allows player to stop the lerp themselves
-	const double LerpStep{ m_LerpRatio * DeltaTime / WallInterpolateTime };
-	
-	m_LerpTimer += LerpStep;
-	
-	Collider->AddWorldOffset(m_StickPosition * LerpStep);
-	Collider->AddWorldRotation(m_StickRotation * LerpStep);
+	return m_ReplayDivergences;
 }
 
-void ABaseSpider::CalcSurfaceStickPoint(const FHitResult& HitResult)
+void ABaseSpider::NotifyWebAction(ESpiderWebAction Action)
 {
-	FVector ImpactForward{ Spider->GetRightVector().Cross(HitResult.ImpactNormal) };
-	ImpactForward.Normalize();
-	// Size needs to be increased to position the player just above ground
-	constexpr float SizeScalar{ 1.05f };
-	const float Size { Collider->GetScaledCapsuleRadius() * SizeScalar };
-	
-	m_StickRotation = FQuat::FindBetweenVectors( Spider->GetUpVector(), HitResult.ImpactNormal ).Rotator();
-	m_StickPosition = (HitResult.Location + HitResult.ImpactNormal * Size) - Collider->GetComponentLocation();
+	m_WebActions |= 1 << static_cast<uint8>(Action);
 }
 
-void ABaseSpider::CalcLerpRatio()
+void ABaseSpider::RecordFrame(float DeltaTime)
 {
-	// Change the lerp ratio to slow it down if the angle is too big
-	// Avoid player nausea + snappy
-	constexpr float CustomRatioThreshold{ 90.f };
-	const double Angle{ FMath::Acos(Spider->GetUpVector().Dot(m_ForwardHitResult.ImpactNormal)) };
+	// State before the frame simulates, the batch has finished the last one by now
+	if (m_Recording->Frames.Num() % FSpiderRecording::SNAPSHOT_INTERVAL == 0)
+		m_Recording->Snapshots.Add({ m_Recording->Frames.Num(), m_Movement.GetSimState() });
 
-	if (Angle < CustomRatioThreshold)
-		m_LerpRatio = 1.f / WallInterpolateTime;
-	else
-		m_LerpRatio = 1.f / (WallInterpolateTime * (CustomRatioThreshold / Angle) * LargeLerpCompensation); // Slows down lerps if an angle is too big
+	const FVector Move{ GetPendingMovementInputVector() };
+	FSpiderRecordedFrame& Frame{ m_Recording->Frames.AddDefaulted_GetRef() };
+	Frame.DeltaTime = DeltaTime;
+	Frame.Move = { static_cast<float>(Move.X), static_cast<float>(Move.Y) };
+	Frame.ControlRotation = FRotator3f{ GetControlRotation() };
+	Frame.JumpPower = m_PendingJump;
+	Frame.WebActions = m_WebActions;
+	m_WebActions = 0;
 }
 
-void ABaseSpider::StickToSurface()
+float ABaseSpider::ReplayFrame(float DeltaTime)
 {
-	CalcSurfaceStickPoint(m_DownHitResult);
-	Collider->AddWorldOffset(m_StickPosition);
-	Collider->AddWorldRotation(m_StickRotation);
+	if (m_ReplayFrame >= m_Replay->Frames.Num())
+	{
+		StopReplay();
+		return DeltaTime;
+	}
+
+	CheckReplaySnapshot();
+	const FSpiderRecordedFrame& Frame{ m_Replay->Frames[m_ReplayFrame++] };
+
+	// Recorded input replaces whatever live input came in
+	ConsumeMovementInputVector();
+	if (Controller)
+		Controller->SetControlRotation(FRotator{ Frame.ControlRotation });
+	AddMovementInput({ Frame.Move.X, Frame.Move.Y, 0.f }, 1.f, true);
+	m_PendingJump = Frame.JumpPower;
+
+	for (uint8 Action{}; Action < static_cast<uint8>(ESpiderWebAction::Count); ++Action)
+	{
+		if (Frame.WebActions & (1 << Action))
+			ReplayWebAction(static_cast<ESpiderWebAction>(Action));
+	}
+
+	return Frame.DeltaTime;
 }
 
-void ABaseSpider::RotateToWorld(float DeltaTime)
+void ABaseSpider::CheckReplaySnapshot()
 {
-	if (FellOffWall())
+	const TArray<FSpiderRecordedSnapshot>& Snapshots{ m_Replay->Snapshots };
+	if (!Snapshots.IsValidIndex(m_ReplaySnapshot) || Snapshots[m_ReplaySnapshot].Frame != m_ReplayFrame)
+		return;
+
+	const FSpiderSimState& Recorded{ Snapshots[m_ReplaySnapshot++].State };
+	const FSpiderSimState& Current{ m_Movement.GetSimState() };
+	if (Recorded.State == Current.State && Recorded.Location.Equals(Current.Location, 0.1))
+		return;
+
+	// Only the first is worth reading, the rest follow from it
+	if (m_ReplayDivergences++ == 0)
 	{
-		m_StickRotation = FQuat::FindBetweenVectors(Spider->GetUpVector(), FVector::UnitZ()).Rotator();
-		m_StickPosition = {};
-		m_LerpTimer = 0.f;
-		m_LerpRatio = 1.f;
+		UE_LOG(LogSpiderReplay, Warning, TEXT("%s: replay diverged at frame %d, %.2f units off"), *GetName(),
+			m_ReplayFrame, FVector::Dist(Recorded.Location, Current.Location));
 	}
-	if (IsTransitioning())
-		TransitionSurfaces(DeltaTime);
 }
-#pragma endregion SurfaceSticking
+
+#pragma endregion Recording
 
 #pragma region HitDetection
 // ==============================================================================
 // Hit detection
 // ==============================================================================
 
-bool ABaseSpider::CheckGrounded()
-{
-	// Trace downwards checking for anything
-	const FVector Start{ GetActorLocation() };
-	const FVector End{ Start - Spider->GetUpVector() * RAYCAST_LENGTH };
+void ABaseSpider::SetClosestWeb(const FVector& Start, const FVector& End)
+{	
+	// Lines matching a registered strand keep its handle, so junctions and snapping still work
+	int32 Segment{};
+	FVector ClosestPoint{};
+	if (m_Webs && m_Webs->FindClosestSegment((Start + End) * 0.5, WebJunctionDistance, Segment, ClosestPoint)
+		&& m_Webs->GetSegmentStart(Segment).Equals(Start, WebJunctionDistance) && m_Webs->GetSegmentEnd(Segment).Equals(End, WebJunctionDistance))
+	{
+		m_Movement.SetClosestWeb(Start, End, Segment);
+		return;
+	}
 
-	// Raycast
-	FCollisionQueryParams CollisionParams{};
-	CollisionParams.AddIgnoredActor(this);
-	GetWorld()->LineTraceSingleByChannel(m_DownHitResult, Start, End, ECC_Visibility, CollisionParams);
-	
-	return IsGrounded();
+	m_Movement.SetClosestWeb(Start, End);
 }
 
-bool ABaseSpider::CheckWall()
+bool ABaseSpider::ProbeDown(const FVector& Start, const FVector& End, FHitResult& OutHit)
 {
-	// Raycast with forward hit result instead of temp (HitWall uses forward hit result)
-	FHitResult Temp{};
-	
-	// Trace forward checking for obstacls
-	const FVector Start{ GetActorLocation() };
-	const FVector End{ Start + Spider->GetForwardVector() * RAYCAST_LENGTH };
-
-	// Raycast
-	FCollisionQueryParams CollisionParams{};
-	CollisionParams.AddIgnoredActor(this);
-	GetWorld()->LineTraceSingleByChannel(m_ForwardHitResult, Start, End, ECollisionChannel::ECC_Visibility, CollisionParams);
-	
-	if (HitWall())
-		return true;
+	if (m_ContactCache.TryHit(Start, End, OutHit))
+	{
+		INC_DWORD_STAT(STAT_SpiderContactCacheHits);
+		if (!CVarSpiderContactValidate.GetValueOnGameThread())
+			return true;
+
+		FHitResult Traced{};
+		GetWorld()->LineTraceSingleByObjectType(Traced, Start, End, MakeSpiderSurfaceQuery(), FCollisionQueryParams{ SCENE_QUERY_STAT(SpiderContactValidate), false, this });
+		const bool Agrees{ Traced.bBlockingHit && Traced.GetComponent() == OutHit.GetComponent()
+			&& Traced.ImpactNormal.Equals(OutHit.ImpactNormal, 0.01) && FMath::IsNearlyEqual(Traced.Distance, OutHit.Distance, 1.f) };
+		if (Agrees)
+			return true;
+
+		UE_LOG(LogSpiderContact, Warning, TEXT("%s: cached ground at %.1f, traced %s at %.1f"), *GetName(), OutHit.Distance,
+			Traced.bBlockingHit ? *GetNameSafe(Traced.GetComponent()) : TEXT("nothing"), Traced.Distance);
+		m_ContactCache.Invalidate();
+		OutHit = Traced;
+		return OutHit.bBlockingHit;
+	}
 
-	m_ForwardHitResult = Temp;
-	return false;
+	const bool Hit{ m_Probes->Probe(this, ESpiderProbe::Down, Start, End, OutHit) };
+
+	// Webs swing and snap, they are always traced
+	m_ContactCache.Store(Start, OutHit, GetSpiderSurface(OutHit) == ESpiderSurface::Ground);
+	return Hit;
 }
 
-bool ABaseSpider::CollisionPrediction(float DeltaTime)
+FVector ABaseSpider::Sweep(const FVector& Start, const FVector& Delta, const FQuat& Rotation) const
 {
-	FHitResult HitResult{};
-	FCollisionQueryParams CollisionParams{};
-	CollisionParams.AddIgnoredActor(this);
+	if (Delta.IsNearlyZero())
+		return Start;
 
-	// Collision prediction
-	GetWorld()->LineTraceSingleByChannel(HitResult, GetActorLocation(), GetActorLocation() +  m_Velocity * DeltaTime, ECC_Visibility, CollisionParams);
-	
-	// If the player would fall through the floor, stick them to the floor
-	if (HitResult.IsValidBlockingHit())
-	{
-		m_DownHitResult = HitResult;
-		return true;	
-	}
+	SCOPE_CYCLE_COUNTER(STAT_SpiderSweep);
 
-	return false;
+	FHitResult HitResult{};
+	const bool Hit{ GetWorld()->SweepSingleByChannel(HitResult, Start, Start + Delta, Rotation, Collider->GetCollisionObjectType(),
+		Collider->GetCollisionShape(), m_SweepParams, m_SweepResponseParams) };
+
+	return Hit ? HitResult.Location : Start + Delta;
 }
+bool ABaseSpider::SweepProbe(const FVector& Start, const FVector& End, const FQuat& Rotation, FHitResult& OutHit) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderSweep);
 
-void ABaseSpider::SetClosestWeb(const FVector& Start, const FVector& End)
-{	
-	m_StartLinePoint = Start;
-	m_EndLinePoint = End;
+	// The real capsule against what the probes see plus pawns and physics bodies, thin webs can't slip between two steps
+	OutHit = {};
+	return GetWorld()->SweepSingleByObjectType(OutHit, Start, End, Rotation, MakeSpiderFallQuery(), Collider->GetCollisionShape(), m_SweepParams);
 }
 #pragma endregion HitDetection
 
@@ -479,76 +894,52 @@ void ABaseSpider::SetClosestWeb(const FVector& Start, const FVector& End)
 // Helpers
 // ==============================================================================
 
-bool ABaseSpider::IsTransitioning() const
-{
-	// Checking for 0 necessary due to going backwards
-	return 0.f <= m_LerpTimer && m_LerpTimer <= 1.f;
-}
-
 bool ABaseSpider::IsGrounded() const
 {
-	return m_DownHitResult.IsValidBlockingHit() && m_DownHitResult.Distance <= GroundCheckDistance;
+	return m_Movement.IsGrounded();
 }
 
 bool ABaseSpider::IsJumping() const
 {
-	return m_JumpImmuneTimer > 0.f;
+	return m_Movement.IsJumping();
 }
 
 bool ABaseSpider::HitWall() const
 {
-	return	m_ForwardHitResult.IsValidBlockingHit() &&
-			m_ForwardHitResult.Distance <= WallCheckDistance;
-}
-
-bool ABaseSpider::IsOnWeb()
-{
-	AActor* Web{};
-	
-	if (CheckWall())
-		Web = m_ForwardHitResult.GetActor();
-	else if (CheckGrounded())
-		Web = m_DownHitResult.GetActor();
-
-	if (Web == nullptr || Web->Tags.IsEmpty())
-		return false;
-
-	if (Web->Tags.Contains(WebLineTag))
-	{
-		MountWebLine(Web);
-		return true;
-	}
-	
-	return false;
+	return m_Movement.HitWall();
 }
 
 bool ABaseSpider::IsMoving() const
 {
-	return m_Velocity.Length() > FLT_EPSILON;
+	return m_Movement.IsMoving();
 }
 
-bool ABaseSpider::IsFalling() const
+bool ABaseSpider::IsIdle() const
 {
-	return m_State == State::Fall;
+	const FSpiderSimState& Sim{ m_Movement.GetSimState() };
+	return Sim.State == ESpiderState::Ground && Sim.Velocity.IsNearlyZero(1.f) && GetPendingMovementInputVector().IsNearlyZero()
+		&& m_PendingJump <= 0.f && m_ServerSteps.IsEmpty() && !IsReplaying();
 }
 
-bool ABaseSpider::ChangedGround() const
+FVector ABaseSpider::GetVelocity() const
 {
-	return !GetActorUpVector().Equals(m_DownHitResult.ImpactNormal, NORMAL_TOLERANCE) && IsGrounded();
+	return m_Movement.GetSimState().Velocity;
 }
 
-bool ABaseSpider::FellOffWall() const
+bool ABaseSpider::IsFalling() const
 {
-	return !Spider->GetUpVector().Equals(FVector::UnitZ());
+	return m_Movement.IsFalling();
 }
 
 void ABaseSpider::PlaySound(UAudioComponent* Sound, bool Condition)
 {
+	// Only toggle on changes, this runs every step
+	if (Condition == Sound->IsPlaying())
+		return;
+
+	INC_DWORD_STAT(STAT_SpiderSoundToggles);
 	if (Condition)
-	{
-		if (!Sound->IsPlaying())
-			Sound->Play();
-	}
+		Sound->Play();
 	else
 		Sound->Stop();
 }
@@ -569,40 +960,61 @@ void ABaseSpider::StopAllSounds()
 
 void ABaseSpider::PrintRotation(const FRotator& Rotation) const
 {
+#if !UE_BUILD_SHIPPING
+	if (GEngine == nullptr)
+		return;
+
 	GEngine->AddOnScreenDebugMessage(-1, 2.f, FColor::Cyan,
 			FString::Printf(TEXT( "Roll: %f, Yaw: %f, Pitch: %f"),
 				Rotation.Roll,
 				Rotation.Yaw,
 				Rotation.Pitch));
-
+#endif
 }
 
 void ABaseSpider::PrintVector(const FVector& Vector, int key) const
 {
+#if !UE_BUILD_SHIPPING
+	if (GEngine == nullptr)
+		return;
+
 	GEngine->AddOnScreenDebugMessage(key, 2.f, FColor::Yellow,
 			FString::Printf(TEXT( "X: %f, Y: %f, Z: %f"),
 				Vector.X,
 				Vector.Y,
 				Vector.Z));
+#endif
 }
 
 void ABaseSpider::PrintString(const FString& String, int key) const
 {
+#if !UE_BUILD_SHIPPING
+	if (GEngine == nullptr)
+		return;
+
 	GEngine->AddOnScreenDebugMessage(key, 2.f, FColor::Silver, String);
+#endif
 }
 
 void ABaseSpider::PrintFloat(const FString& Label, float F) const
 {
+#if !UE_BUILD_SHIPPING
+	if (GEngine == nullptr)
+		return;
+
 	GEngine->AddOnScreenDebugMessage(-1, 2.f, FColor::Purple,
 			Label + FString::Printf(TEXT(": %f")
 				, F));
+#endif
 }
 
 void ABaseSpider::DrawDebugArrow(const FVector& Location, const FVector& Direction, const FColor& Color, bool PersistentLines) const
 {
+#if ENABLE_DRAW_DEBUG
 	constexpr float ArrowHeadSize{ 9.f };
 	constexpr float ArrowSize{ 5.f };
 	constexpr float LifeTIme{ 1.5f };
 	DrawDebugDirectionalArrow(GetWorld(), Location, Location + Direction, ArrowHeadSize, Color, PersistentLines, LifeTIme, 0, ArrowSize);
+#endif
 }
 #pragma endregion Debug
\ No newline at end of file
@@ -4,12 +4,19 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Pawn.h"
+#include "SpiderContactCache.h"
+#include "SpiderMovement.h"
+#include "SpiderNetMovement.h"
+#include "SpiderProbeSubsystem.h"
+#include "SpiderRecording.h"
 #include "BaseSpider.generated.h"
 
 class USpringArmComponent;
 class UCapsuleComponent;
 class UArrowComponent;
 class UCameraComponent;
+class UWebGraphSubsystem;
+class USpiderBatchSubsystem;
 
 UCLASS()
 class SPIDERGAME_API ABaseSpider : public APawn
@@ -63,22 +70,53 @@ public:
 	float LargeLerpCompensation{ 2.f };
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement")
 	float JumpForwardScale{ 0.5f };
+	// Strongest jump, also what the server clamps client jumps to.
+	// Defaults to the most a net input can carry so Blueprint jump powers keep working, lower it per spider to cap them
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Movement", meta=(ClampMin="0", ClampMax="65535"))
+	float MaxJumpPower{ MAX_uint16 };
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Physics")
 	float Gravity{ 2000.0f };
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Physics")
 	float Drag{ 0.93f };
+	// Steps per second, movement runs at this rate whatever the frame rate
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Physics")
+	float SimulationRate{ 60.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Physics")
+	int32 MaxSimulationSteps{ 8 };
+	// Sweeps per step for a fall, more for fast falls so thin webs and ledges aren't skipped
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Physics")
+	int32 MaxFallSubsteps{ 4 };
+	// How hard the spider pulls on and lands in simulated webs
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Physics")
+	float WebMass{ 2.f };
 	
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Collision")
 	float WallCheckDistance{ 100.0f };
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Collision")
 	float GroundCheckDistance{ 50.f };
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Collision")
-	FName WebTag{ "Web" };
+	float JumpImmuneTime{ 0.1f };
+	// How far from the hit a registered web strand may be to mount it without Blueprint help
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Collision")
-	FName WebLineTag{ "WebLine" };
+	float WebMountDistance{ 50.f };
+	// Strand ends closer than this count as one junction the spider walks across
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Collision")
-	float JumpImmuneTime{ 0.1f };
+	float WebJunctionDistance{ 10.f };
+	// Sharpest turn onto the next strand at a junction, past it the spider stops at the end instead
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Collision", meta=(ClampMin=0, ClampMax=180))
+	float WebJunctionMaxAngle{ 90.f };
+
+	// Replication rates, a spider standing still barely needs updates, one in the air needs the most
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Network")
+	float IdleNetUpdateRate{ 2.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Network")
+	float MovingNetUpdateRate{ 20.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Network")
+	float AirborneNetUpdateRate{ 30.f };
+	// How far the owning client's prediction may be off from the server before it is corrected
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Network")
+	float NetCorrectionDistance{ 5.f };
 	
 	UFUNCTION(BlueprintCallable)
 	bool IsGrounded() const;
@@ -88,105 +126,184 @@ public:
 	bool IsMoving() const;
 	UFUNCTION(BlueprintCallable)
 	bool IsFalling() const;
+
+	UFUNCTION(BlueprintCallable, Category="Movement")
+	void Jump(float JumpPower);
+	// Grounded, standing still and nobody pushing, nothing to simulate until woken
+	bool IsIdle() const;
+	// The simulation's velocity, the actor itself is only ever placed
+	virtual FVector GetVelocity() const override;
+	// Wakes the spider when its significance suspended it
+	virtual void AddMovementInput(FVector WorldDirection, float ScaleValue = 1.f, bool bForce = false) override;
+
+	// Movement replication sent (server) or moves sent (owning client) over the last second
+	UFUNCTION(BlueprintPure, Category="Network")
+	float GetNetBytesPerSecond() const;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void PreReplication(IRepChangedPropertyTracker& ChangedPropertyTracker) override;
+
+	// Records input, control rotation and web actions every frame until stopped
+	UFUNCTION(BlueprintCallable, Category="Recording")
+	void StartRecording();
+	// Writes the recording, returns the file or nothing when there was no recording
+	UFUNCTION(BlueprintCallable, Category="Recording")
+	FString StopRecording();
+	// Puts the spider back where the recording started and drives it with the recorded frames instead of live input
+	bool StartReplay(const TSharedPtr<const FSpiderRecording>& Recording);
+	UFUNCTION(BlueprintCallable, Category="Recording")
+	bool StartReplayFromFile(const FString& Path);
+	UFUNCTION(BlueprintCallable, Category="Recording")
+	void StopReplay();
+	UFUNCTION(BlueprintPure, Category="Recording")
+	bool IsRecording() const;
+	UFUNCTION(BlueprintPure, Category="Recording")
+	bool IsReplaying() const;
+	// Snapshots the replay didn't match, anything above zero means the session played out differently
+	UFUNCTION(BlueprintPure, Category="Recording")
+	int32 GetReplayDivergences() const;
+	// Web input lives in Blueprint, call this from it so recordings have it
+	UFUNCTION(BlueprintCallable, Category="Recording")
+	void NotifyWebAction(ESpiderWebAction Action);
 	
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	UFUNCTION(BlueprintImplementableEvent, Category="Collision")
 	void MountWebLine(AActor* SurfaceActorPtr);
+	// A replay wants this web action done, do what the input would have
+	UFUNCTION(BlueprintImplementableEvent, Category="Recording")
+	void ReplayWebAction(ESpiderWebAction Action);
 	
 private:
-	enum class State
-	{
-		Ground,
-		Transition,
-		Fall,
-		OnWeb,
-		Jumping
-	};
-	
-	static constexpr float RAYCAST_LENGTH{ 1000.f };
-	static constexpr float NORMAL_TOLERANCE{ 0.1f };
+	friend class FSpiderPawnWorld;
+	friend class USpiderBatchSubsystem;
 
 	// ==============================================================================
 	// Member variables
 	// ==============================================================================
-	State m_State{ State::Fall };
-	State m_OldState{ State::Fall };
-	
-	// Controls
-	FVector m_Velocity{};
-	
-	// Player state
-	bool m_HitWeb{ false };
-	float m_JumpImmuneTimer{};
+	FSpiderMovement m_Movement{};
+	FSpiderFixedStep m_FixedStep{};
+	// Simulation state before the last step, rendering interpolates from it
+	FSpiderSimState m_PreviousSim{};
+	// Where we last put the actor, anything else means it was moved from outside
+	FVector m_RenderedLocation{};
+	// Held for every step of the frame
+	FSpiderMovementInput m_FrameInput{};
+	int32 m_FrameSteps{};
+	bool m_Landed{ false };
+	FVector m_LandingVelocity{};
+	// Taken by the first step of the next frame
+	float m_PendingJump{};
+	UPROPERTY(Transient)
+	TObjectPtr<USpiderBatchSubsystem> m_Batch{};
 
-	// Collision
-	FHitResult m_DownHitResult{};
-	FHitResult m_ForwardHitResult{};
+	// Network
+	static constexpr int32 NET_HISTORY_SIZE{ 128 };
+	// Queued client steps beyond this are dropped, the oldest first
+	static constexpr int32 MAX_QUEUED_NET_STEPS{ 2 * FSpiderNetInputs::MAX_INPUTS };
+	UPROPERTY(ReplicatedUsing=OnRep_NetState)
+	FSpiderNetState m_NetState{};
+	FSpiderNetState m_LastSentNetState{};
+	// Owning client, predicted steps by sequence and the last one the server stepped
+	TArray<FSpiderNetStep> m_NetHistory{};
+	uint16 m_NextNetSequence{};
+	uint16 m_AckedNetSequence{ MAX_uint16 };
+	// Server, client steps waiting to be simulated
+	TArray<FSpiderNetStep> m_ServerSteps{};
+	// Steps the server's clock allows, a client sending faster only fills its queue
+	float m_ServerStepBudget{};
+	uint16 m_ReceivedNetSequence{ MAX_uint16 };
+	uint16 m_SteppedNetSequence{ MAX_uint16 };
+	// Simulated proxies, time between the last two states they got
+	float m_ProxyTime{};
+	float m_ProxyDuration{};
+	double m_LastNetStateTime{};
+	// Bandwidth
+	int64 m_NetBits{};
+	float m_NetWindowTime{};
+	float m_NetBytesPerSecond{};
 
-	// Lerp
-	FVector m_StickPosition{};
-	FRotator m_StickRotation{};
-	float m_LerpTimer{ FLT_MAX };
-	float m_LerpRatio{};
+	// Recording
+	TUniquePtr<FSpiderRecording> m_Recording{};
+	// Bit per ESpiderWebAction since the last recorded frame
+	uint8 m_WebActions{};
+	TSharedPtr<const FSpiderRecording> m_Replay{};
+	int32 m_ReplayFrame{};
+	int32 m_ReplaySnapshot{};
+	int32 m_ReplayDivergences{};
 
-	// Web
-	FVector m_StartLinePoint{};
-	FVector m_EndLinePoint{};
+	// Collision
+	UPROPERTY(Transient)
+	TObjectPtr<USpiderProbeSubsystem> m_Probes{};
+	UPROPERTY(Transient)
+	TObjectPtr<UWebGraphSubsystem> m_Webs{};
+	FCollisionQueryParams m_SweepParams{};
+	FCollisionResponseParams m_SweepResponseParams{};
+	FSpiderContactCache m_ContactCache{};
 
 	// ==============================================================================
-	// States
+	// Simulation
 	// ==============================================================================
-	void Transition(float DeltaTime);
-	void Grounded(float DeltaTime);
-	void OnWeb(float DeltaTime);
-	void Falling(float DeltaTime);
-	void Jumping(float DeltaTime);
+	void SyncMovementParams();
+	void Simulate(float DeltaTime);
+	// Simulate in parts so the batch can run the steps of many spiders together
+	void BeginSimulate(float DeltaTime);
+	// Any thread, true when the step needed nothing from the world
+	bool IntegrateStep();
+	void FinishStep(bool Integrated);
+	void EndSimulate();
+	void ApplySimulation(float Alpha);
+	void LoadWeb(bool Landed, const FVector& LandingVelocity);
+	// Carry on from wherever something else (respawn, teleport) put the actor
+	void SyncTeleport();
+	// Strand handles are local to this world, find ours again by where we are
+	void RemountWeb();
 	
 	// ==============================================================================
-	// Player controlled action
+	// Network
 	// ==============================================================================
-	void RotateCamera();
-	void RotateBody() const;
-	void HandleMove(const FVector& Direction);
-	UFUNCTION(BlueprintCallable, Category="Movement")
-	void Jump(float JumpPower);
+	// Server side pawn of a remote player, steps the moves the client sent
+	bool IsRemotelyControlled() const;
+	void SimulateRemote(float DeltaTime);
+	void InterpolateProxy(float DeltaTime);
+	void RecordNetStep();
+	void SendNetSteps();
+	void UpdateNetState();
+	void Reconcile();
+	void UpdateNetBandwidth(float DeltaTime);
+	UFUNCTION(Server, Unreliable)
+	void ServerMove(const FSpiderNetInputs& Moves);
+	UFUNCTION()
+	void OnRep_NetState();
 
 	// ==============================================================================
-	// Physics
+	// Recording
 	// ==============================================================================
-	void ApplyGravity(float DeltaTime);
-	void ApplyDrag(float DeltaTime);
-
+	void RecordFrame(float DeltaTime);
+	// Feeds the next recorded frame as input, returns the delta time it was recorded with
+	float ReplayFrame(float DeltaTime);
+	void CheckReplaySnapshot();
+	
 	// ==============================================================================
-	// Surface sticking
+	// Player controlled action
 	// ==============================================================================
-	void SetTransition(const FHitResult& HitResult);
-	void TransitionSurfaces(float DeltaTime);
-	void CalcSurfaceStickPoint(const FHitResult& HitResult);
-	void CalcLerpRatio();
-	void StickToSurface();
-	void RotateToWorld(float DeltaTime);
+	void RotateCamera();
 	
 	// ==============================================================================
 	// Hit detection
 	// ==============================================================================
-	bool CheckGrounded();
-	bool CheckWall();
-	bool CollisionPrediction(float DeltaTime);
 	UFUNCTION(BlueprintCallable, Category="Collision")
 	void SetClosestWeb(const FVector& Start, const FVector& End);
-	bool IsOnWeb();
+	FVector Sweep(const FVector& Start, const FVector& Delta, const FQuat& Rotation) const;
+	bool SweepProbe(const FVector& Start, const FVector& End, const FQuat& Rotation, FHitResult& OutHit) const;
+	bool ProbeDown(const FVector& Start, const FVector& End, FHitResult& OutHit);
 	
 	// ==============================================================================
 	// Helpers
 	// ==============================================================================
-	bool IsTransitioning() const;
 	UFUNCTION(BlueprintCallable, Category="Helpers")
 	bool HitWall() const;
-	bool ChangedGround() const;
-	bool FellOffWall() const;
 	void PlaySound(UAudioComponent* Sound, bool Condition);
 	void StopAllSounds();
 	
@@ -0,0 +1,199 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "FireflyCaptureSubsystem.h"
+
+#include "FireflyFragments.h"
+#include "MassCommonFragments.h"
+#include "MassEntitySubsystem.h"
+#include "MassMovementFragments.h"
+#include "GameFramework/Actor.h"
+
+void UFireflyCaptureSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_EntitySubsystem = Collection.InitializeDependency<UMassEntitySubsystem>();
+}
+
+void UFireflyCaptureSubsystem::Deinitialize()
+{
+	for (const FFirefly& Firefly : m_Fireflies)
+		DestroyEntity(Firefly);
+
+	m_Fireflies.Reset();
+	Super::Deinitialize();
+}
+
+void UFireflyCaptureSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (m_EntitySubsystem == nullptr || m_Fireflies.IsEmpty())
+		return;
+
+	FMassEntityManager& EntityManager{ m_EntitySubsystem->GetMutableEntityManager() };
+
+	// Mass has run the capture and break processors by now, gather what changed before telling anyone,
+	// Blueprint listeners may register or unregister fireflies
+	struct FCaptured
+	{
+		AActor* Actor{};
+		int32 Segment{ INDEX_NONE };
+		FVector AttachPoint{};
+	};
+	TArray<FCaptured> Captured{};
+	TArray<TPair<AActor*, int32>> Broke{};
+	TArray<AActor*> Freed{};
+
+	for (int32 Index{ m_Fireflies.Num() - 1 }; Index >= 0; --Index)
+	{
+		FFirefly& Firefly{ m_Fireflies[Index] };
+		AActor* Actor{ Firefly.Actor.Get() };
+		if (Actor == nullptr || !EntityManager.IsEntityValid(Firefly.Entity))
+		{
+			DestroyEntity(Firefly);
+			m_Fireflies.RemoveAtSwap(Index, 1, false);
+			continue;
+		}
+
+		FFireflyWebFragment& Web{ EntityManager.GetFragmentDataChecked<FFireflyWebFragment>(Firefly.Entity) };
+		if (Web.TornSegment != INDEX_NONE)
+		{
+			Broke.Emplace(Actor, Web.TornSegment);
+			Web.TornSegment = INDEX_NONE;
+		}
+
+		if (Web.Segment != Firefly.Segment)
+		{
+			if (Firefly.Segment != INDEX_NONE)
+				Freed.Add(Actor);
+			if (Web.Segment != INDEX_NONE)
+				Captured.Add({ Actor, Web.Segment, Web.AttachPoint });
+			Firefly.Segment = Web.Segment;
+		}
+
+		// Next Mass update tests where the actor is now, its own movement stays in charge
+		EntityManager.GetFragmentDataChecked<FTransformFragment>(Firefly.Entity).GetMutableTransform().SetLocation(Actor->GetActorLocation());
+	}
+
+	for (const TPair<AActor*, int32>& Pair : Broke)
+		OnFireflyBrokeWeb.Broadcast(Pair.Key, Pair.Value);
+	for (AActor* Actor : Freed)
+		OnFireflyFreed.Broadcast(Actor);
+	for (const FCaptured& Capture : Captured)
+		OnFireflyCaptured.Broadcast(Capture.Actor, Capture.Segment, Capture.AttachPoint);
+}
+
+TStatId UFireflyCaptureSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UFireflyCaptureSubsystem, STATGROUP_Tickables);
+}
+
+void UFireflyCaptureSubsystem::RegisterFirefly(AActor* Firefly, float CaptureRadius, float BreakRate, float BreakStrength)
+{
+	if (Firefly == nullptr || m_EntitySubsystem == nullptr || FindFirefly(Firefly) != INDEX_NONE)
+		return;
+
+	FMassEntityManager& EntityManager{ m_EntitySubsystem->GetMutableEntityManager() };
+
+	// No target fragment or actor fragment, so Mass steering and actor sync leave the actor alone
+	if (!m_Archetype.IsValid())
+	{
+		FMassArchetypeCompositionDescriptor Composition{};
+		Composition.Fragments.Add<FTransformFragment>();
+		Composition.Fragments.Add<FMassVelocityFragment>();
+		Composition.Fragments.Add<FFireflyWebFragment>();
+		Composition.Fragments.Add<FFireflyBreakDamageFragment>();
+		Composition.Tags.Add<FFireflyTag>();
+		Composition.ConstSharedFragments.Add<FFireflyParameters>();
+		m_Archetype = EntityManager.CreateArchetype(Composition, TEXT("ActorFirefly"));
+	}
+
+	// Fireflies registered with the same values share one parameters fragment
+	FFireflyParameters Parameters{};
+	Parameters.CaptureRadius = CaptureRadius;
+	Parameters.BreakRate = BreakRate;
+	Parameters.BreakStrength = FMath::Max(BreakStrength, UE_KINDA_SMALL_NUMBER);
+
+	FMassArchetypeSharedFragmentValues SharedValues{};
+	SharedValues.AddConstSharedFragment(EntityManager.GetOrCreateConstSharedFragment(Parameters));
+	SharedValues.Sort();
+
+	FFirefly& Entry{ m_Fireflies.AddDefaulted_GetRef() };
+	Entry.Actor = Firefly;
+	Entry.Entity = EntityManager.CreateEntity(m_Archetype, SharedValues);
+	Entry.BreakStrength = Parameters.BreakStrength;
+	EntityManager.GetFragmentDataChecked<FTransformFragment>(Entry.Entity).SetTransform(Firefly->GetActorTransform());
+}
+
+void UFireflyCaptureSubsystem::UnregisterFirefly(AActor* Firefly)
+{
+	const int32 Index{ FindFirefly(Firefly) };
+	if (Index == INDEX_NONE)
+		return;
+
+	DestroyEntity(m_Fireflies[Index]);
+	m_Fireflies.RemoveAtSwap(Index, 1, false);
+}
+
+bool UFireflyCaptureSubsystem::IsStuck(const AActor* Firefly) const
+{
+	const int32 Index{ FindFirefly(Firefly) };
+	return Index != INDEX_NONE && m_Fireflies[Index].Segment != INDEX_NONE;
+}
+
+float UFireflyCaptureSubsystem::GetBreakProgress(const AActor* Firefly) const
+{
+	const int32 Index{ FindFirefly(Firefly) };
+	if (Index == INDEX_NONE || m_Fireflies[Index].Segment == INDEX_NONE || m_EntitySubsystem == nullptr)
+		return 0.f;
+
+	const FFirefly& Entry{ m_Fireflies[Index] };
+	const FMassEntityManager& EntityManager{ m_EntitySubsystem->GetEntityManager() };
+	if (!EntityManager.IsEntityValid(Entry.Entity))
+		return 0.f;
+
+	return FMath::Min(EntityManager.GetFragmentDataChecked<FFireflyBreakDamageFragment>(Entry.Entity).Damage / Entry.BreakStrength, 1.f);
+}
+
+void UFireflyCaptureSubsystem::FreeFirefly(AActor* Firefly)
+{
+	const int32 Index{ FindFirefly(Firefly) };
+	if (Index == INDEX_NONE || m_EntitySubsystem == nullptr)
+		return;
+
+	FFirefly& Entry{ m_Fireflies[Index] };
+	FMassEntityManager& EntityManager{ m_EntitySubsystem->GetMutableEntityManager() };
+	if (!EntityManager.IsEntityValid(Entry.Entity))
+		return;
+
+	// Same as the break processor letting go, without tearing the strand
+	FFireflyWebFragment& Web{ EntityManager.GetFragmentDataChecked<FFireflyWebFragment>(Entry.Entity) };
+	// Called from a web break in the middle of Mass processing, the tag waits for the next flush
+	if (Web.Segment != INDEX_NONE && EntityManager.IsProcessing())
+		EntityManager.Defer().RemoveTag<FFireflyStuckTag>(Entry.Entity);
+	else if (Web.Segment != INDEX_NONE)
+		EntityManager.RemoveTagFromEntity(Entry.Entity, FFireflyStuckTag::StaticStruct());
+	Web.Segment = INDEX_NONE;
+	EntityManager.GetFragmentDataChecked<FFireflyBreakDamageFragment>(Entry.Entity).Damage = 0.f;
+	EntityManager.GetFragmentDataChecked<FTransformFragment>(Entry.Entity).GetMutableTransform().SetLocation(Firefly->GetActorLocation());
+
+	const bool WasStuck{ Entry.Segment != INDEX_NONE };
+	Entry.Segment = INDEX_NONE;
+	if (WasStuck)
+		OnFireflyFreed.Broadcast(Firefly);
+}
+
+int32 UFireflyCaptureSubsystem::FindFirefly(const AActor* Firefly) const
+{
+	return m_Fireflies.IndexOfByPredicate([Firefly](const FFirefly& Entry) { return Entry.Actor == Firefly; });
+}
+
+void UFireflyCaptureSubsystem::DestroyEntity(const FFirefly& Firefly) const
+{
+	if (m_EntitySubsystem == nullptr)
+		return;
+
+	FMassEntityManager& EntityManager{ m_EntitySubsystem->GetMutableEntityManager() };
+	if (EntityManager.IsEntityValid(Firefly.Entity))
+		EntityManager.DestroyEntity(Firefly.Entity);
+}
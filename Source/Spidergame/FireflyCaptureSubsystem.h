@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FireflyCaptureSubsystem.generated.h"
+
+class UMassEntitySubsystem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FFireflyCapturedSignature, AActor*, Firefly, int32, Segment, FVector, AttachPoint);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FFireflyBrokeWebSignature, AActor*, Firefly, int32, Segment);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FFireflyFreedSignature, AActor*, Firefly);
+
+/**
+ * Lets firefly actors be caught by the same Mass processors as the Mass fireflies.
+ * Every registered actor gets an entity the web capture and break processors pick up, its location is copied in once a frame
+ * and what the processors did with it is reported back through the delegates, so there is one capture and break rule for both.
+ */
+UCLASS()
+class SPIDERGAME_API UFireflyCaptureSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	UFUNCTION(BlueprintCallable, Category="Firefly")
+	void RegisterFirefly(AActor* Firefly, float CaptureRadius = 20.f, float BreakRate = 1.f, float BreakStrength = 5.f);
+	UFUNCTION(BlueprintCallable, Category="Firefly")
+	void UnregisterFirefly(AActor* Firefly);
+
+	UFUNCTION(BlueprintPure, Category="Firefly")
+	bool IsStuck(const AActor* Firefly) const;
+	// 0 when free, reaches 1 when the strand tears
+	UFUNCTION(BlueprintPure, Category="Firefly")
+	float GetBreakProgress(const AActor* Firefly) const;
+	// Lets a stuck firefly go without breaking its strand (eaten, released to the pool)
+	UFUNCTION(BlueprintCallable, Category="Firefly")
+	void FreeFirefly(AActor* Firefly);
+
+	UPROPERTY(BlueprintAssignable, Category="Firefly")
+	FFireflyCapturedSignature OnFireflyCaptured{};
+	UPROPERTY(BlueprintAssignable, Category="Firefly")
+	FFireflyBrokeWebSignature OnFireflyBrokeWeb{};
+	// Strand the firefly hung on is gone, torn by itself or anything else
+	UPROPERTY(BlueprintAssignable, Category="Firefly")
+	FFireflyFreedSignature OnFireflyFreed{};
+
+private:
+	struct FFirefly
+	{
+		TWeakObjectPtr<AActor> Actor{};
+		FMassEntityHandle Entity{};
+		float BreakStrength{};
+		// Strand after the last Mass update, a change is a capture or a free
+		int32 Segment{ INDEX_NONE };
+	};
+
+	UPROPERTY(Transient)
+	TObjectPtr<UMassEntitySubsystem> m_EntitySubsystem{};
+
+	TArray<FFirefly> m_Fireflies{};
+	FMassArchetypeHandle m_Archetype{};
+
+	int32 FindFirefly(const AActor* Firefly) const;
+	void DestroyEntity(const FFirefly& Firefly) const;
+};
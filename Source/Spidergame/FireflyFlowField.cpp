@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "FireflyFlowField.h"
+
+namespace
+{
+	constexpr uint32 BYTE_MASK{ 0xFF };
+	constexpr int32 MAX_CLEARANCE{ 0xFF };
+
+	int8 ToSignedByte(double Value)
+	{
+		return static_cast<int8>(FMath::Clamp(FMath::RoundToInt(Value * MAX_int8), -MAX_int8, MAX_int8));
+	}
+
+	double FromSignedByte(uint32 Bits)
+	{
+		return static_cast<double>(static_cast<int8>(Bits & BYTE_MASK)) / MAX_int8;
+	}
+}
+
+bool FFireflyFlowField::IsEmpty() const
+{
+	return Cells.IsEmpty();
+}
+
+bool FFireflyFlowField::Contains(const FVector& Location) const
+{
+	const FIntVector Cell{ ToCell(Location) };
+	return !IsEmpty() && Cell.X >= 0 && Cell.Y >= 0 && Cell.Z >= 0 && Cell.X < Dimensions.X && Cell.Y < Dimensions.Y && Cell.Z < Dimensions.Z;
+}
+
+bool FFireflyFlowField::Sample(const FVector& Location, FFireflyFlowSample& OutSample) const
+{
+	if (!Contains(Location))
+		return false;
+
+	const FIntVector Cell{ ToCell(Location) };
+	const uint32 Packed{ Cells[ToIndex(Cell)] };
+	OutSample.Flow = UnpackFlow(Packed);
+	OutSample.Clearance = UnpackClearance(Packed) * CellSize;
+
+	// Clearance grows away from walls, its gradient is the way out. Edges of the field reuse the cell itself
+	const auto ClearanceAt = [this, &Cell](const FIntVector& Offset)
+	{
+		const FIntVector Neighbour{
+			FMath::Clamp(Cell.X + Offset.X, 0, Dimensions.X - 1),
+			FMath::Clamp(Cell.Y + Offset.Y, 0, Dimensions.Y - 1),
+			FMath::Clamp(Cell.Z + Offset.Z, 0, Dimensions.Z - 1)
+		};
+		return static_cast<double>(UnpackClearance(Cells[ToIndex(Neighbour)]));
+	};
+
+	OutSample.Away = FVector{
+		ClearanceAt({ 1, 0, 0 }) - ClearanceAt({ -1, 0, 0 }),
+		ClearanceAt({ 0, 1, 0 }) - ClearanceAt({ 0, -1, 0 }),
+		ClearanceAt({ 0, 0, 1 }) - ClearanceAt({ 0, 0, -1 })
+	}.GetSafeNormal();
+	return true;
+}
+
+FVector FFireflyFlowField::Steer(const FVector& Location, const FVector& Desired, float FlowWeight, float AvoidDistance) const
+{
+	FFireflyFlowSample FlowSample{};
+	if (!Sample(Location, FlowSample))
+		return Desired;
+
+	// Baked toward the level's goals, it never pulls a firefly off its own heading
+	FVector Direction{ Desired + FlowSample.Flow * (FlowWeight * FMath::Max(FlowSample.Flow | Desired, 0.0)) };
+
+	// Pushed harder the closer the wall, a firefly inside geometry only wants out
+	if (AvoidDistance > 0.f && FlowSample.Clearance < AvoidDistance)
+		Direction += FlowSample.Away * (2.f * (1.f - FlowSample.Clearance / AvoidDistance));
+
+	return Direction.GetSafeNormal(UE_SMALL_NUMBER, Desired);
+}
+
+void FFireflyFlowField::TraceStreamline(const FVector& Start, int32 MaxPoints, TArray<FVector>& OutPoints) const
+{
+	OutPoints.Reset();
+	const double StepLength{ CellSize * 0.5 };
+
+	FVector Point{ Start };
+	FFireflyFlowSample FlowSample{};
+	while (OutPoints.Num() < MaxPoints && Sample(Point, FlowSample))
+	{
+		OutPoints.Add(Point);
+		if (FlowSample.Flow.IsNearlyZero())
+			break;
+
+		Point += FlowSample.Flow.GetSafeNormal() * StepLength;
+	}
+}
+
+int32 FFireflyFlowField::GetNumStreamlines() const
+{
+	return FMath::Max(StreamlineOffsets.Num() - 1, 0);
+}
+
+void FFireflyFlowField::GetStreamline(int32 Line, TArray<FVector>& OutPoints) const
+{
+	OutPoints.Reset();
+	if (Line < 0 || Line >= GetNumStreamlines())
+		return;
+
+	for (int32 Point{ StreamlineOffsets[Line] }; Point < StreamlineOffsets[Line + 1]; ++Point)
+		OutPoints.Add(FVector{ StreamlinePoints[Point] });
+}
+
+void FFireflyFlowField::Reset()
+{
+	Origin = {};
+	Dimensions = {};
+	Cells.Reset();
+	StreamlinePoints.Reset();
+	StreamlineOffsets.Reset();
+}
+
+int32 FFireflyFlowField::ToIndex(const FIntVector& Cell) const
+{
+	return (Cell.Z * Dimensions.Y + Cell.Y) * Dimensions.X + Cell.X;
+}
+
+FIntVector FFireflyFlowField::ToCell(const FVector& Location) const
+{
+	const FVector Local{ (Location - FVector{ Origin }) / CellSize };
+	return { FMath::FloorToInt32(Local.X), FMath::FloorToInt32(Local.Y), FMath::FloorToInt32(Local.Z) };
+}
+
+FVector FFireflyFlowField::GetCellCenter(const FIntVector& Cell) const
+{
+	return FVector{ Origin } + (FVector{ Cell } + 0.5) * CellSize;
+}
+
+uint32 FFireflyFlowField::PackCell(const FVector& Flow, int32 Clearance)
+{
+	const FVector Direction{ Flow.GetSafeNormal() };
+	return static_cast<uint8>(ToSignedByte(Direction.X))
+		| static_cast<uint32>(static_cast<uint8>(ToSignedByte(Direction.Y))) << 8
+		| static_cast<uint32>(static_cast<uint8>(ToSignedByte(Direction.Z))) << 16
+		| static_cast<uint32>(FMath::Clamp(Clearance, 0, MAX_CLEARANCE)) << 24;
+}
+
+FVector FFireflyFlowField::UnpackFlow(uint32 Cell)
+{
+	return { FromSignedByte(Cell), FromSignedByte(Cell >> 8), FromSignedByte(Cell >> 16) };
+}
+
+int32 FFireflyFlowField::UnpackClearance(uint32 Cell)
+{
+	return static_cast<int32>(Cell >> 24);
+}
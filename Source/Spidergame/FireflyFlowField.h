@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FireflyFlowField.generated.h"
+
+// What a firefly reads from the field where it is
+struct FFireflyFlowSample
+{
+	// Towards the field's goals around the geometry, zero where there is no way or no goal
+	FVector Flow{};
+	// Away from the closest geometry
+	FVector Away{};
+	// Distance to the closest geometry, rounded to cells
+	float Clearance{};
+};
+
+/**
+ * Steering for fireflies on a regular grid, built offline by AFireflyFlowFieldActor.
+ * Every cell is one uint32: the flow direction as three signed bytes and the clearance in cells as the fourth,
+ * so a sample is a single read (and six more for the way away from walls). Streamlines traced at build time are kept
+ * for FX_Path to draw. Nothing here changes after loading, it can be read from any thread.
+ */
+USTRUCT()
+struct SPIDERGAME_API FFireflyFlowField
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector3f Origin{};
+	UPROPERTY()
+	float CellSize{ 100.f };
+	UPROPERTY()
+	FIntVector Dimensions{};
+	UPROPERTY()
+	TArray<uint32> Cells{};
+
+	// Every streamline's points one after the other, each starts at StreamlineOffsets[Line]
+	UPROPERTY()
+	TArray<FVector3f> StreamlinePoints{};
+	// One more entry than there are streamlines
+	UPROPERTY()
+	TArray<int32> StreamlineOffsets{};
+
+	bool IsEmpty() const;
+	bool Contains(const FVector& Location) const;
+	// False outside the field
+	bool Sample(const FVector& Location, FFireflyFlowSample& OutSample) const;
+	// Desired (unit length) bent along the flow by FlowWeight where the two agree, and away from geometry closer than AvoidDistance
+	FVector Steer(const FVector& Location, const FVector& Desired, float FlowWeight, float AvoidDistance) const;
+	// Follows the flow from Start until it stops or leaves the field
+	void TraceStreamline(const FVector& Start, int32 MaxPoints, TArray<FVector>& OutPoints) const;
+
+	int32 GetNumStreamlines() const;
+	void GetStreamline(int32 Line, TArray<FVector>& OutPoints) const;
+
+	void Reset();
+
+	int32 ToIndex(const FIntVector& Cell) const;
+	FIntVector ToCell(const FVector& Location) const;
+	FVector GetCellCenter(const FIntVector& Cell) const;
+
+	static uint32 PackCell(const FVector& Flow, int32 Clearance);
+	static FVector UnpackFlow(uint32 Cell);
+	static int32 UnpackClearance(uint32 Cell);
+};
@@ -0,0 +1,292 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "FireflyFlowFieldActor.h"
+
+#include "FireflyFlowSubsystem.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFireflyFlow, Log, All);
+
+AFireflyFlowFieldActor::AFireflyFlowFieldActor()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	Bounds = CreateDefaultSubobject<UBoxComponent>(TEXT("Bounds"));
+	Bounds->SetBoxExtent({ 2000.f, 2000.f, 1000.f });
+	Bounds->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = Bounds;
+}
+
+void AFireflyFlowFieldActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UFireflyFlowSubsystem* Flow{ GetWorld()->GetSubsystem<UFireflyFlowSubsystem>() })
+		Flow->RegisterField(this);
+}
+
+void AFireflyFlowFieldActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UFireflyFlowSubsystem* Flow{ GetWorld()->GetSubsystem<UFireflyFlowSubsystem>() })
+		Flow->UnregisterField(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AFireflyFlowFieldActor::Build()
+{
+#if WITH_EDITOR
+	const double StartTime{ FPlatformTime::Seconds() };
+
+	const FBox Box{ Bounds->Bounds.GetBox() };
+	const float Size{ FMath::Max(CellSize, 10.f) };
+	const FIntVector Dimensions{
+		FMath::Max(FMath::CeilToInt32(Box.GetSize().X / Size), 1),
+		FMath::Max(FMath::CeilToInt32(Box.GetSize().Y / Size), 1),
+		FMath::Max(FMath::CeilToInt32(Box.GetSize().Z / Size), 1)
+	};
+
+	const int64 NumCells{ int64{ Dimensions.X } * Dimensions.Y * Dimensions.Z };
+	if (NumCells > MAX_CELLS)
+	{
+		UE_LOG(LogFireflyFlow, Error, TEXT("%s: %lld cells is too many, raise the cell size"), *GetName(), NumCells);
+		return;
+	}
+
+	Modify();
+	m_Field.Reset();
+	m_Field.Origin = FVector3f{ Box.Min };
+	m_Field.CellSize = Size;
+	m_Field.Dimensions = Dimensions;
+
+	TBitArray<> Blocked{};
+	TArray<int32> Clearance{};
+	TArray<FVector> Flow{};
+	FindBlockedCells(Blocked);
+	MeasureClearance(Blocked, Clearance);
+	FloodFromGoals(Blocked, Clearance, Flow);
+
+	m_Field.Cells.SetNumUninitialized(static_cast<int32>(NumCells));
+	for (int32 Index{}; Index < NumCells; ++Index)
+		m_Field.Cells[Index] = FFireflyFlowField::PackCell(Flow[Index], Clearance[Index]);
+
+	TraceStreamlines();
+
+	UE_LOG(LogFireflyFlow, Log, TEXT("%s: built %dx%dx%d cells (%d KB) and %d streamlines in %.2fs"), *GetName(),
+		Dimensions.X, Dimensions.Y, Dimensions.Z, static_cast<int32>(m_Field.Cells.GetAllocatedSize() / 1024), m_Field.GetNumStreamlines(),
+		FPlatformTime::Seconds() - StartTime);
+#endif
+}
+
+int32 AFireflyFlowFieldActor::GetNumStreamlines() const
+{
+	return m_Field.GetNumStreamlines();
+}
+
+void AFireflyFlowFieldActor::GetStreamline(int32 Line, TArray<FVector>& OutPoints) const
+{
+	m_Field.GetStreamline(Line, OutPoints);
+}
+
+const FFireflyFlowField& AFireflyFlowFieldActor::GetField() const
+{
+	return m_Field;
+}
+
+#if WITH_EDITOR
+void AFireflyFlowFieldActor::FindBlockedCells(TBitArray<>& OutBlocked) const
+{
+	const FIntVector& Dimensions{ m_Field.Dimensions };
+	OutBlocked.Init(false, Dimensions.X * Dimensions.Y * Dimensions.Z);
+
+	// A firefly in the middle of the cell would touch the level
+	const FCollisionShape Shape{ FCollisionShape::MakeSphere(m_Field.CellSize * 0.5f) };
+	const FCollisionQueryParams Params{ SCENE_QUERY_STAT(FireflyFlowBuild), true };
+	for (int32 Z{}; Z < Dimensions.Z; ++Z)
+		for (int32 Y{}; Y < Dimensions.Y; ++Y)
+			for (int32 X{}; X < Dimensions.X; ++X)
+			{
+				const FIntVector Cell{ X, Y, Z };
+				if (GetWorld()->OverlapAnyTestByObjectType(m_Field.GetCellCenter(Cell), FQuat::Identity, ECC_WorldStatic, Shape, Params))
+					OutBlocked[m_Field.ToIndex(Cell)] = true;
+			}
+}
+
+void AFireflyFlowFieldActor::MeasureClearance(const TBitArray<>& Blocked, TArray<int32>& OutClearance) const
+{
+	static const FIntVector FACES[]{ { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	const FIntVector& Dimensions{ m_Field.Dimensions };
+
+	// Breadth first from every blocked cell at once, the first visit is the closest wall
+	OutClearance.Init(MAX_int32, Blocked.Num());
+	TArray<FIntVector> Queue{};
+	for (TConstSetBitIterator<> It{ Blocked }; It; ++It)
+	{
+		const int32 Index{ It.GetIndex() };
+		OutClearance[Index] = 0;
+		Queue.Add({ Index % Dimensions.X, Index / Dimensions.X % Dimensions.Y, Index / (Dimensions.X * Dimensions.Y) });
+	}
+
+	for (int32 Next{}; Next < Queue.Num(); ++Next)
+	{
+		const FIntVector Cell{ Queue[Next] };
+		const int32 Clearance{ OutClearance[m_Field.ToIndex(Cell)] + 1 };
+		for (const FIntVector& Face : FACES)
+		{
+			const FIntVector Neighbour{ Cell + Face };
+			if (Neighbour.X < 0 || Neighbour.Y < 0 || Neighbour.Z < 0 || Neighbour.X >= Dimensions.X || Neighbour.Y >= Dimensions.Y || Neighbour.Z >= Dimensions.Z)
+				continue;
+
+			int32& NeighbourClearance{ OutClearance[m_Field.ToIndex(Neighbour)] };
+			if (NeighbourClearance <= Clearance)
+				continue;
+
+			NeighbourClearance = Clearance;
+			Queue.Add(Neighbour);
+		}
+	}
+}
+
+void AFireflyFlowFieldActor::FloodFromGoals(const TBitArray<>& Blocked, const TArray<int32>& Clearance, TArray<FVector>& OutFlow) const
+{
+	const FIntVector& Dimensions{ m_Field.Dimensions };
+	OutFlow.Init(FVector::ZeroVector, Blocked.Num());
+
+	TArray<FIntVector> Offsets{};
+	for (int32 X{ -1 }; X <= 1; ++X)
+		for (int32 Y{ -1 }; Y <= 1; ++Y)
+			for (int32 Z{ -1 }; Z <= 1; ++Z)
+			{
+				if (X != 0 || Y != 0 || Z != 0)
+					Offsets.Add({ X, Y, Z });
+			}
+
+	const auto IsInside = [&Dimensions](const FIntVector& Cell)
+	{
+		return Cell.X >= 0 && Cell.Y >= 0 && Cell.Z >= 0 && Cell.X < Dimensions.X && Cell.Y < Dimensions.Y && Cell.Z < Dimensions.Z;
+	};
+
+	// A diagonal step between cells that are blocked on every face it passes would cut through the wall's edge
+	const auto IsSqueezed = [this, &Blocked](const FIntVector& Cell, const FIntVector& Offset)
+	{
+		int32 Axes{};
+		int32 BlockedFaces{};
+		for (int32 Axis{}; Axis < 3; ++Axis)
+		{
+			if (Offset[Axis] == 0)
+				continue;
+
+			FIntVector Face{ Cell };
+			Face[Axis] += Offset[Axis];
+			++Axes;
+			BlockedFaces += Blocked[m_Field.ToIndex(Face)] ? 1 : 0;
+		}
+		return Axes > 1 && BlockedFaces == Axes;
+	};
+
+	// Dijkstra from all goals, every cell ends up knowing its cost to the closest one
+	struct FOpenCell
+	{
+		double Cost{};
+		FIntVector Cell{};
+		bool operator<(const FOpenCell& Other) const { return Cost < Other.Cost; }
+	};
+
+	TArray<double> Costs{};
+	Costs.Init(TNumericLimits<double>::Max(), Blocked.Num());
+	TArray<FOpenCell> Open{};
+	for (const FVector& Goal : Goals)
+	{
+		const FIntVector Cell{ m_Field.ToCell(GetActorTransform().TransformPosition(Goal)) };
+		if (!IsInside(Cell) || Blocked[m_Field.ToIndex(Cell)])
+		{
+			UE_LOG(LogFireflyFlow, Warning, TEXT("%s: goal %s is outside the box or in the level"), *GetName(), *Goal.ToString());
+			continue;
+		}
+
+		Costs[m_Field.ToIndex(Cell)] = 0.0;
+		Open.HeapPush({ 0.0, Cell });
+	}
+
+	while (!Open.IsEmpty())
+	{
+		FOpenCell Current{};
+		Open.HeapPop(Current, false);
+		if (Current.Cost > Costs[m_Field.ToIndex(Current.Cell)])
+			continue;
+
+		for (const FIntVector& Offset : Offsets)
+		{
+			const FIntVector Neighbour{ Current.Cell + Offset };
+			if (!IsInside(Neighbour))
+				continue;
+
+			const int32 Index{ m_Field.ToIndex(Neighbour) };
+			if (Blocked[Index] || IsSqueezed(Current.Cell, Offset))
+				continue;
+
+			const double Cost{ Current.Cost + FVector{ Offset }.Length() * (1.0 + WallPenalty / FMath::Max(Clearance[Index], 1)) };
+			if (Cost >= Costs[Index])
+				continue;
+
+			Costs[Index] = Cost;
+			Open.HeapPush({ Cost, Neighbour });
+		}
+	}
+
+	// Downhill to the cheapest neighbour, then averaged with the neighbours so the 26 directions blend into a smooth flow
+	TArray<FVector> Downhill{};
+	Downhill.Init(FVector::ZeroVector, Blocked.Num());
+	for (int32 Index{}; Index < Blocked.Num(); ++Index)
+	{
+		if (Blocked[Index] || Costs[Index] == TNumericLimits<double>::Max())
+			continue;
+
+		const FIntVector Cell{ Index % Dimensions.X, Index / Dimensions.X % Dimensions.Y, Index / (Dimensions.X * Dimensions.Y) };
+		double BestCost{ Costs[Index] };
+		for (const FIntVector& Offset : Offsets)
+		{
+			const FIntVector Neighbour{ Cell + Offset };
+			if (!IsInside(Neighbour) || Costs[m_Field.ToIndex(Neighbour)] >= BestCost || IsSqueezed(Cell, Offset))
+				continue;
+
+			BestCost = Costs[m_Field.ToIndex(Neighbour)];
+			Downhill[Index] = FVector{ Offset }.GetSafeNormal();
+		}
+	}
+
+	for (int32 Index{}; Index < Blocked.Num(); ++Index)
+	{
+		if (Downhill[Index].IsZero())
+			continue;
+
+		const FIntVector Cell{ Index % Dimensions.X, Index / Dimensions.X % Dimensions.Y, Index / (Dimensions.X * Dimensions.Y) };
+		FVector Sum{ Downhill[Index] };
+		for (const FIntVector& Offset : Offsets)
+		{
+			const FIntVector Neighbour{ Cell + Offset };
+			if (IsInside(Neighbour))
+				Sum += Downhill[m_Field.ToIndex(Neighbour)];
+		}
+
+		OutFlow[Index] = Sum.GetSafeNormal();
+	}
+}
+
+void AFireflyFlowFieldActor::TraceStreamlines()
+{
+	m_Field.StreamlineOffsets.Add(0);
+
+	TArray<FVector> Points{};
+	for (const FVector& Seed : StreamlineSeeds)
+	{
+		m_Field.TraceStreamline(GetActorTransform().TransformPosition(Seed), MaxStreamlinePoints, Points);
+		if (Points.Num() < 2)
+			continue;
+
+		for (const FVector& Point : Points)
+			m_Field.StreamlinePoints.Add(FVector3f{ Point });
+		m_Field.StreamlineOffsets.Add(m_Field.StreamlinePoints.Num());
+	}
+}
+#endif
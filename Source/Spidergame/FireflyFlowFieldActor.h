@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "FireflyFlowField.h"
+#include "FireflyFlowFieldActor.generated.h"
+
+class UBoxComponent;
+
+/**
+ * Firefly flow field for one level. Build marks the grid cells inside the box that overlap the level,
+ * measures every cell's distance to them and floods the rest from the goals, cells close to walls cost more
+ * so the flow keeps to the middle of tunnels. Streamlines from the seeds are traced once for FX_Path.
+ * The field is saved with the level and handed to UFireflyFlowSubsystem on BeginPlay.
+ */
+UCLASS()
+class SPIDERGAME_API AFireflyFlowFieldActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AFireflyFlowFieldActor();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Flow")
+	TObjectPtr<UBoxComponent> Bounds{};
+
+	UPROPERTY(EditAnywhere, Category="Flow", meta=(ClampMin=10))
+	float CellSize{ 100.f };
+	// Where the flow leads, relative to the actor. Fixed at build time, fireflies wandering elsewhere only use the flow where it goes their way
+	UPROPERTY(EditAnywhere, Category="Flow", meta=(MakeEditWidget))
+	TArray<FVector> Goals{};
+	// Extra cost of a cell right next to a wall, falls off with the distance
+	UPROPERTY(EditAnywhere, Category="Flow", meta=(ClampMin=0))
+	float WallPenalty{ 4.f };
+
+	// A streamline is traced from each, relative to the actor
+	UPROPERTY(EditAnywhere, Category="Streamlines", meta=(MakeEditWidget))
+	TArray<FVector> StreamlineSeeds{};
+	UPROPERTY(EditAnywhere, Category="Streamlines", meta=(ClampMin=2))
+	int32 MaxStreamlinePoints{ 256 };
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION(CallInEditor, Category="Flow")
+	void Build();
+
+	// For FX_Path, the same lines the fireflies follow
+	UFUNCTION(BlueprintPure, Category="Streamlines")
+	int32 GetNumStreamlines() const;
+	UFUNCTION(BlueprintCallable, Category="Streamlines")
+	void GetStreamline(int32 Line, TArray<FVector>& OutPoints) const;
+
+	const FFireflyFlowField& GetField() const;
+
+private:
+	// Past this the build refuses, the cell size is too small for the box
+	static constexpr int64 MAX_CELLS{ 1 << 22 };
+
+	UPROPERTY()
+	FFireflyFlowField m_Field{};
+
+#if WITH_EDITOR
+	void FindBlockedCells(TBitArray<>& OutBlocked) const;
+	void MeasureClearance(const TBitArray<>& Blocked, TArray<int32>& OutClearance) const;
+	void FloodFromGoals(const TBitArray<>& Blocked, const TArray<int32>& Clearance, TArray<FVector>& OutFlow) const;
+	void TraceStreamlines();
+#endif
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "FireflyFlowSubsystem.h"
+
+#include "FireflyFlowFieldActor.h"
+
+void UFireflyFlowSubsystem::Deinitialize()
+{
+	m_Field.Reset();
+	m_FieldActor.Reset();
+	Super::Deinitialize();
+}
+
+void UFireflyFlowSubsystem::RegisterField(const AFireflyFlowFieldActor* FieldActor)
+{
+	if (FieldActor == nullptr || FieldActor->GetField().IsEmpty())
+		return;
+
+	// Copied once so steering never reads the level's copy
+	m_FieldActor = FieldActor;
+	m_Field = MakeShared<const FFireflyFlowField, ESPMode::ThreadSafe>(FieldActor->GetField());
+}
+
+void UFireflyFlowSubsystem::UnregisterField(const AFireflyFlowFieldActor* FieldActor)
+{
+	if (m_FieldActor != FieldActor)
+		return;
+
+	m_FieldActor.Reset();
+	m_Field.Reset();
+}
+
+TSharedPtr<const FFireflyFlowField, ESPMode::ThreadSafe> UFireflyFlowSubsystem::GetField() const
+{
+	return m_Field;
+}
+
+bool UFireflyFlowSubsystem::HasField() const
+{
+	return m_Field.IsValid();
+}
+
+FVector UFireflyFlowSubsystem::GetSteeringDirection(const FVector& Location, const FVector& Desired, float FlowWeight, float AvoidDistance) const
+{
+	const FVector Direction{ Desired.GetSafeNormal() };
+	return m_Field.IsValid() ? m_Field->Steer(Location, Direction, FlowWeight, AvoidDistance) : Direction;
+}
+
+bool UFireflyFlowSubsystem::SampleFlow(const FVector& Location, FVector& OutFlow, FVector& OutAway, float& OutClearance) const
+{
+	FFireflyFlowSample FlowSample{};
+	if (!m_Field.IsValid() || !m_Field->Sample(Location, FlowSample))
+		return false;
+
+	OutFlow = FlowSample.Flow;
+	OutAway = FlowSample.Away;
+	OutClearance = FlowSample.Clearance;
+	return true;
+}
+
+void UFireflyFlowSubsystem::TraceStreamline(const FVector& Start, TArray<FVector>& OutPoints, int32 MaxPoints) const
+{
+	OutPoints.Reset();
+	if (m_Field.IsValid())
+		m_Field->TraceStreamline(Start, MaxPoints, OutPoints);
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FireflyFlowField.h"
+#include "FireflyFlowSubsystem.generated.h"
+
+class AFireflyFlowFieldActor;
+
+/**
+ * Holds the level's firefly flow field. Mass steering reads it from worker threads, the Blueprint functions
+ * are for the actor fireflies' behaviour trees and FX_Path.
+ */
+UCLASS()
+class SPIDERGAME_API UFireflyFlowSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	void RegisterField(const AFireflyFlowFieldActor* FieldActor);
+	void UnregisterField(const AFireflyFlowFieldActor* FieldActor);
+	// Null without a field, keep the pointer for as long as it's read
+	TSharedPtr<const FFireflyFlowField, ESPMode::ThreadSafe> GetField() const;
+
+	UFUNCTION(BlueprintPure, Category="Firefly|Flow")
+	bool HasField() const;
+
+	// Desired direction bent along the flow and away from close geometry, Desired itself outside the field
+	UFUNCTION(BlueprintPure, Category="Firefly|Flow")
+	FVector GetSteeringDirection(const FVector& Location, const FVector& Desired, float FlowWeight = 1.f, float AvoidDistance = 150.f) const;
+
+	// False outside the field
+	UFUNCTION(BlueprintPure, Category="Firefly|Flow")
+	bool SampleFlow(const FVector& Location, FVector& OutFlow, FVector& OutAway, float& OutClearance) const;
+
+	UFUNCTION(BlueprintCallable, Category="Firefly|Flow")
+	void TraceStreamline(const FVector& Start, TArray<FVector>& OutPoints, int32 MaxPoints = 256) const;
+
+private:
+	TWeakObjectPtr<const AFireflyFlowFieldActor> m_FieldActor{};
+	// Shared with running Mass chunks, a new field never changes one in use
+	TSharedPtr<const FFireflyFlowField, ESPMode::ThreadSafe> m_Field{};
+};
@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTypes.h"
+#include "FireflyFragments.generated.h"
+
+// Marks Mass entities simulated as fireflies
+USTRUCT()
+struct SPIDERGAME_API FFireflyTag : public FMassTag
+{
+	GENERATED_BODY()
+};
+
+// Added while the firefly hangs in a web, steering skips these
+USTRUCT()
+struct SPIDERGAME_API FFireflyStuckTag : public FMassTag
+{
+	GENERATED_BODY()
+};
+
+// Shared by every firefly spawned from the same config
+USTRUCT()
+struct SPIDERGAME_API FFireflyParameters : public FMassConstSharedFragment
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, Category="Movement")
+	float MaxSpeed{ 300.f };
+	UPROPERTY(EditAnywhere, Category="Movement")
+	float Acceleration{ 600.f };
+	// Targets are picked in this radius around where the firefly spawned
+	UPROPERTY(EditAnywhere, Category="Movement")
+	float WanderRadius{ 800.f };
+	UPROPERTY(EditAnywhere, Category="Movement")
+	float ArriveDistance{ 50.f };
+	// How much the level's flow field bends the way to the target, zero ignores the flow but still avoids walls.
+	// The flow leads to the field's baked goals, not to wander targets, so it only adds where it heads the same way
+	UPROPERTY(EditAnywhere, Category="Movement")
+	float FlowWeight{ 0.5f };
+	// Pushed away from geometry closer than this, zero turns it off
+	UPROPERTY(EditAnywhere, Category="Movement")
+	float AvoidDistance{ 150.f };
+
+	// Distance to a web strand that gets the firefly stuck
+	UPROPERTY(EditAnywhere, Category="Web")
+	float CaptureRadius{ 20.f };
+	// Break damage per second while stuck
+	UPROPERTY(EditAnywhere, Category="Web")
+	float BreakRate{ 1.f };
+	// Break damage needed to tear the strand
+	UPROPERTY(EditAnywhere, Category="Web")
+	float BreakStrength{ 5.f };
+};
+
+USTRUCT()
+struct SPIDERGAME_API FFireflyTargetFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	FVector Home{};
+	FVector Target{};
+	FRandomStream Random{};
+	bool HasTarget{ false };
+};
+
+USTRUCT()
+struct SPIDERGAME_API FFireflyBreakDamageFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	float Damage{};
+};
+
+USTRUCT()
+struct SPIDERGAME_API FFireflyWebFragment : public FMassFragment
+{
+	GENERATED_BODY()
+
+	// Web graph segment the firefly is stuck to, INDEX_NONE when flying
+	int32 Segment{ INDEX_NONE };
+	FVector AttachPoint{};
+	// Set when the firefly tore its own strand, read back by UFireflyCaptureSubsystem for actor fireflies
+	int32 TornSegment{ INDEX_NONE };
+};
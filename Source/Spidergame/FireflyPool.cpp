@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "FireflyPool.h"
+
+#include "ActorSignificanceSubsystem.h"
+#include "AIController.h"
+#include "BrainComponent.h"
+#include "FireflyCaptureSubsystem.h"
+#include "PooledActor.h"
+#include "BehaviorTree/BlackboardComponent.h"
+#include "BehaviorTree/BlackboardData.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PawnMovementComponent.h"
+
+void UFireflyPool::Initialize(TSubclassOf<APawn> FireflyClass)
+{
+	m_FireflyClass = FireflyClass;
+}
+
+void UFireflyPool::Prewarm(int32 Count)
+{
+	while (m_Pooled.Num() < Count)
+	{
+		APawn* Firefly{ SpawnFirefly(FTransform::Identity) };
+		if (Firefly == nullptr)
+			break;
+
+		Deactivate(Firefly);
+		m_Pooled.Add(Firefly);
+	}
+
+	UpdateCounts();
+}
+
+APawn* UFireflyPool::Acquire(const FTransform& Transform)
+{
+	++m_Stats.Acquires;
+
+	APawn* Firefly{};
+	while (Firefly == nullptr && !m_Pooled.IsEmpty())
+		Firefly = m_Pooled.Pop(false);
+
+	if (Firefly)
+	{
+		++m_Stats.Hits;
+		Activate(Firefly, Transform);
+	}
+	else
+	{
+		Firefly = SpawnFirefly(Transform);
+	}
+
+	if (Firefly)
+		m_Active.Add(Firefly);
+
+	UpdateCounts();
+	return Firefly;
+}
+
+void UFireflyPool::Release(APawn* Firefly)
+{
+	if (Firefly == nullptr)
+		return;
+
+	if (m_Active.Remove(Firefly) == 0)
+	{
+		// Already pooled or never ours
+		if (!m_Pooled.Contains(Firefly))
+			Firefly->Destroy();
+		return;
+	}
+
+	++m_Stats.Releases;
+	Deactivate(Firefly);
+	m_Pooled.Add(Firefly);
+	UpdateCounts();
+}
+
+const FFireflyPoolStats& UFireflyPool::GetStats() const
+{
+	return m_Stats;
+}
+
+float UFireflyPool::GetHitRate() const
+{
+	return m_Stats.Acquires > 0 ? static_cast<float>(m_Stats.Hits) / m_Stats.Acquires : 1.f;
+}
+
+APawn* UFireflyPool::SpawnFirefly(const FTransform& Transform)
+{
+	UWorld* World{ GetWorld() };
+	if (World == nullptr || m_FireflyClass == nullptr)
+		return nullptr;
+
+	FActorSpawnParameters SpawnParams{};
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	APawn* Firefly{ World->SpawnActor<APawn>(m_FireflyClass, Transform, SpawnParams) };
+	if (Firefly == nullptr)
+		return nullptr;
+
+	// Pawns placed with AutoPossessAI already got one, this covers the rest
+	if (Firefly->GetController() == nullptr)
+		Firefly->SpawnDefaultController();
+
+	Firefly->OnDestroyed.AddDynamic(this, &UFireflyPool::HandleFireflyDestroyed);
+	if (UActorSignificanceSubsystem* Significance{ World->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->RegisterFirefly(Firefly);
+	return Firefly;
+}
+
+void UFireflyPool::Activate(APawn* Firefly, const FTransform& Transform)
+{
+	Firefly->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	Firefly->SetActorHiddenInGame(false);
+	Firefly->SetActorEnableCollision(true);
+	Firefly->SetActorTickEnabled(true);
+
+	if (UPawnMovementComponent* Movement{ Firefly->GetMovementComponent() })
+		Movement->Activate(true);
+
+	if (const AAIController* Controller{ Cast<AAIController>(Firefly->GetController()) })
+	{
+		if (UBrainComponent* Brain{ Controller->GetBrainComponent() })
+			Brain->RestartLogic();
+	}
+
+	if (UActorSignificanceSubsystem* Significance{ Firefly->GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->RegisterFirefly(Firefly);
+
+	if (Firefly->Implements<UPooledActor>())
+		IPooledActor::Execute_OnAcquiredFromPool(Firefly);
+}
+
+void UFireflyPool::Deactivate(APawn* Firefly)
+{
+	// Significance would turn the tick back on
+	if (UActorSignificanceSubsystem* Significance{ Firefly->GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->Unregister(Firefly);
+
+	Firefly->SetActorHiddenInGame(true);
+	Firefly->SetActorEnableCollision(false);
+	Firefly->SetActorTickEnabled(false);
+
+	if (UPawnMovementComponent* Movement{ Firefly->GetMovementComponent() })
+	{
+		Movement->StopMovementImmediately();
+		Movement->Deactivate();
+	}
+
+	if (AAIController* Controller{ Cast<AAIController>(Firefly->GetController()) })
+	{
+		Controller->StopMovement();
+
+		if (UBrainComponent* Brain{ Controller->GetBrainComponent() })
+			Brain->StopLogic(TEXT("Released to pool"));
+
+		// Forget targets and break damage, the self key has to keep pointing at the pawn
+		if (UBlackboardComponent* Blackboard{ Controller->GetBlackboardComponent() })
+		{
+			for (const UBlackboardData* Data{ Blackboard->GetBlackboardAsset() }; Data; Data = Data->Parent)
+			{
+				for (const FBlackboardEntry& Entry : Data->Keys)
+				{
+					if (Entry.EntryName != FBlackboard::KeySelf)
+						Blackboard->ClearValue(Entry.EntryName);
+				}
+			}
+		}
+	}
+
+	// Eaten fireflies can still be hanging in a web
+	if (UFireflyCaptureSubsystem* Captures{ Firefly->GetWorld()->GetSubsystem<UFireflyCaptureSubsystem>() })
+		Captures->FreeFirefly(Firefly);
+
+	if (Firefly->Implements<UPooledActor>())
+		IPooledActor::Execute_OnReleasedToPool(Firefly);
+}
+
+void UFireflyPool::UpdateCounts()
+{
+	m_Stats.Active = m_Active.Num();
+	m_Stats.Pooled = m_Pooled.Num();
+}
+
+void UFireflyPool::HandleFireflyDestroyed(AActor* Firefly)
+{
+	if (UActorSignificanceSubsystem* Significance{ Firefly->GetWorld()->GetSubsystem<UActorSignificanceSubsystem>() })
+		Significance->Unregister(Firefly);
+
+	APawn* Pawn{ Cast<APawn>(Firefly) };
+	m_Active.Remove(Pawn);
+	m_Pooled.RemoveSingleSwap(Pawn, false);
+	UpdateCounts();
+}
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "FireflyPool.generated.h"
+
+USTRUCT(BlueprintType)
+struct FFireflyPoolStats
+{
+	GENERATED_BODY()
+
+	// Fireflies alive in the world
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Active{};
+	// Fireflies hidden and ready to be handed out
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Pooled{};
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Acquires{};
+	// Acquires served from the pool instead of spawning
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Hits{};
+	UPROPERTY(BlueprintReadOnly, Category="Pool")
+	int32 Releases{};
+};
+
+/**
+ * Keeps firefly pawns and their AI controllers alive between lives.
+ * Released fireflies are hidden, stop their behavior tree and get a clean blackboard,
+ * acquiring one moves it into place and restarts its logic instead of spawning and possessing a new pawn.
+ */
+UCLASS()
+class SPIDERGAME_API UFireflyPool : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	void Initialize(TSubclassOf<APawn> FireflyClass);
+	// Spawns fireflies until Count are pooled
+	void Prewarm(int32 Count);
+
+	// Pooled firefly at Transform, spawns a new one when the pool is empty
+	APawn* Acquire(const FTransform& Transform);
+	// Hands the firefly back, fireflies not made by this pool are destroyed
+	void Release(APawn* Firefly);
+
+	const FFireflyPoolStats& GetStats() const;
+	float GetHitRate() const;
+
+private:
+	UPROPERTY()
+	TSubclassOf<APawn> m_FireflyClass{};
+	UPROPERTY()
+	TArray<TObjectPtr<APawn>> m_Pooled{};
+	UPROPERTY()
+	TSet<TObjectPtr<APawn>> m_Active{};
+
+	FFireflyPoolStats m_Stats{};
+
+	APawn* SpawnFirefly(const FTransform& Transform);
+	void Activate(APawn* Firefly, const FTransform& Transform);
+	void Deactivate(APawn* Firefly);
+	void UpdateCounts();
+
+	UFUNCTION()
+	void HandleFireflyDestroyed(AActor* Firefly);
+};
@@ -0,0 +1,389 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "FireflyProcessors.h"
+
+#include "FireflyFlowSubsystem.h"
+#include "FireflyFragments.h"
+#include "MassActorSubsystem.h"
+#include "MassCommonFragments.h"
+#include "MassCommonTypes.h"
+#include "MassExecutionContext.h"
+#include "MassMovementFragments.h"
+#include "MassSimulationLOD.h"
+#include "WebGraphSubsystem.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	// Distant chunks tick less often and get the time they skipped
+	float GetEntityDeltaTime(const FMassExecutionContext& Context, const TConstArrayView<FMassSimulationVariableTickFragment>& TickFragments, int32 Index)
+	{
+		return TickFragments.IsEmpty() ? Context.GetDeltaTimeSeconds() : TickFragments[Index].DeltaTime;
+	}
+
+	void AddLODRequirements(FMassEntityQuery& Query)
+	{
+		Query.AddRequirement<FMassSimulationVariableTickFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::Optional);
+		Query.AddChunkRequirement<FMassSimulationVariableTickChunkFragment>(EMassFragmentAccess::ReadOnly, EMassFragmentPresence::Optional);
+		Query.SetChunkFilter(&FMassSimulationVariableTickChunkFragment::ShouldTickChunkThisFrame);
+	}
+
+	FIntVector ToCell(const FVector& Location, float CellSize)
+	{
+		return {
+			FMath::FloorToInt32(Location.X / CellSize),
+			FMath::FloorToInt32(Location.Y / CellSize),
+			FMath::FloorToInt32(Location.Z / CellSize)
+		};
+	}
+}
+
+#pragma region Steering
+// ==============================================================================
+// Steering
+// ==============================================================================
+
+UFireflySteeringProcessor::UFireflySteeringProcessor()
+	: m_EntityQuery{ *this }
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::Movement;
+}
+
+void UFireflySteeringProcessor::ConfigureQueries()
+{
+	m_EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddRequirement<FMassVelocityFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddRequirement<FFireflyTargetFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddConstSharedRequirement<FFireflyParameters>();
+	m_EntityQuery.AddTagRequirement<FFireflyTag>(EMassFragmentPresence::All);
+	m_EntityQuery.AddTagRequirement<FFireflyStuckTag>(EMassFragmentPresence::None);
+	AddLODRequirements(m_EntityQuery);
+}
+
+void UFireflySteeringProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	// Held for the whole pass in case the level's field is swapped meanwhile
+	const UWorld* World{ EntityManager.GetWorld() };
+	const UFireflyFlowSubsystem* FlowSubsystem{ World ? World->GetSubsystem<UFireflyFlowSubsystem>() : nullptr };
+	const TSharedPtr<const FFireflyFlowField, ESPMode::ThreadSafe> Field{ FlowSubsystem ? FlowSubsystem->GetField() : nullptr };
+
+	m_EntityQuery.ForEachEntityChunk(EntityManager, Context, [&Field](FMassExecutionContext& Context)
+	{
+		const FFireflyParameters& Parameters{ Context.GetConstSharedFragment<FFireflyParameters>() };
+		const TArrayView<FTransformFragment> Transforms{ Context.GetMutableFragmentView<FTransformFragment>() };
+		const TArrayView<FMassVelocityFragment> Velocities{ Context.GetMutableFragmentView<FMassVelocityFragment>() };
+		const TArrayView<FFireflyTargetFragment> Targets{ Context.GetMutableFragmentView<FFireflyTargetFragment>() };
+		const TConstArrayView<FMassSimulationVariableTickFragment> TickFragments{ Context.GetFragmentView<FMassSimulationVariableTickFragment>() };
+
+		for (int32 Index{}; Index < Context.GetNumEntities(); ++Index)
+		{
+			const float DeltaTime{ GetEntityDeltaTime(Context, TickFragments, Index) };
+			FTransform& Transform{ Transforms[Index].GetMutableTransform() };
+			FVector& Velocity{ Velocities[Index].Value };
+			FFireflyTargetFragment& Target{ Targets[Index] };
+
+			const FVector Location{ Transform.GetLocation() };
+			const auto PickTarget = [&Target, &Parameters]()
+			{
+				Target.Target = Target.Home + Target.Random.VRand() * Target.Random.FRandRange(0.f, Parameters.WanderRadius);
+			};
+
+			if (!Target.HasTarget)
+			{
+				Target.Home = Location;
+				Target.Random.Initialize(Context.GetEntity(Index).Index);
+				PickTarget();
+				Target.HasTarget = true;
+			}
+
+			// Wander to a new spot around home once this one is reached
+			FVector ToTarget{ Target.Target - Location };
+			if (ToTarget.SizeSquared() < FMath::Square(Parameters.ArriveDistance))
+			{
+				PickTarget();
+				ToTarget = Target.Target - Location;
+			}
+
+			FVector Direction{ ToTarget.GetSafeNormal() };
+			if (Field.IsValid())
+				Direction = Field->Steer(Location, Direction, Parameters.FlowWeight, Parameters.AvoidDistance);
+
+			const FVector DesiredVelocity{ Direction * Parameters.MaxSpeed };
+			Velocity += (DesiredVelocity - Velocity).GetClampedToMaxSize(Parameters.Acceleration * DeltaTime);
+
+			Transform.SetLocation(Location + Velocity * DeltaTime);
+			if (!Velocity.IsNearlyZero())
+				Transform.SetRotation(Velocity.ToOrientationQuat());
+		}
+	});
+}
+
+#pragma endregion Steering
+
+#pragma region WebCapture
+// ==============================================================================
+// Web capture
+// ==============================================================================
+
+UFireflyWebCaptureProcessor::UFireflyWebCaptureProcessor()
+	: m_EntityQuery{ *this }
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteAfter.Add(UE::Mass::ProcessorGroupNames::Movement);
+	// Only reads the web graph, the break processor after it is the one that changes it on the game thread
+	bRequiresGameThreadExecution = false;
+}
+
+void UFireflyWebCaptureProcessor::ConfigureQueries()
+{
+	m_EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	m_EntityQuery.AddRequirement<FMassVelocityFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddRequirement<FFireflyWebFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddRequirement<FFireflyBreakDamageFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddConstSharedRequirement<FFireflyParameters>();
+	m_EntityQuery.AddTagRequirement<FFireflyTag>(EMassFragmentPresence::All);
+	m_EntityQuery.AddTagRequirement<FFireflyStuckTag>(EMassFragmentPresence::None);
+	AddLODRequirements(m_EntityQuery);
+}
+
+void UFireflyWebCaptureProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	const UWorld* World{ EntityManager.GetWorld() };
+	const UWebGraphSubsystem* WebGraph{ World ? World->GetSubsystem<UWebGraphSubsystem>() : nullptr };
+	if (WebGraph == nullptr || WebGraph->GetNumSegments() == 0)
+		return;
+
+	// Gathered in query order, the results are handed back in the same order below
+	m_Fireflies.Reset();
+	float MaxCaptureRadius{};
+	m_EntityQuery.ForEachEntityChunk(EntityManager, Context, [this, &MaxCaptureRadius](FMassExecutionContext& Context)
+	{
+		const FFireflyParameters& Parameters{ Context.GetConstSharedFragment<FFireflyParameters>() };
+		const TConstArrayView<FTransformFragment> Transforms{ Context.GetFragmentView<FTransformFragment>() };
+		MaxCaptureRadius = FMath::Max(MaxCaptureRadius, Parameters.CaptureRadius);
+
+		for (int32 Index{}; Index < Context.GetNumEntities(); ++Index)
+			m_Fireflies.Add({ Transforms[Index].GetTransform().GetLocation(), Parameters.CaptureRadius });
+	});
+
+	if (m_Fireflies.IsEmpty())
+		return;
+
+	const float CellSize{ FMath::Max(MIN_CELL_SIZE, MaxCaptureRadius * 2.f) };
+	BinSegments(*WebGraph, CellSize);
+	FindCaptures(CellSize);
+
+	int32 Next{};
+	m_EntityQuery.ForEachEntityChunk(EntityManager, Context, [this, &Next](FMassExecutionContext& Context)
+	{
+		const TArrayView<FMassVelocityFragment> Velocities{ Context.GetMutableFragmentView<FMassVelocityFragment>() };
+		const TArrayView<FFireflyWebFragment> Webs{ Context.GetMutableFragmentView<FFireflyWebFragment>() };
+		const TArrayView<FFireflyBreakDamageFragment> BreakDamages{ Context.GetMutableFragmentView<FFireflyBreakDamageFragment>() };
+
+		for (int32 Index{}; Index < Context.GetNumEntities(); ++Index)
+		{
+			const FFirefly& Firefly{ m_Fireflies[Next++] };
+			if (Firefly.Segment == INDEX_NONE)
+				continue;
+
+			Webs[Index].Segment = Firefly.Segment;
+			Webs[Index].AttachPoint = Firefly.AttachPoint;
+			Velocities[Index].Value = FVector::ZeroVector;
+			BreakDamages[Index].Damage = 0.f;
+			Context.Defer().AddTag<FFireflyStuckTag>(Context.GetEntity(Index));
+		}
+	});
+}
+
+void UFireflyWebCaptureProcessor::BinSegments(const UWebGraphSubsystem& WebGraph, float CellSize)
+{
+	m_Segments.Reset();
+	m_SegmentCells.Reset();
+
+	TArray<int32> Handles{};
+	WebGraph.GetSegments(Handles);
+	for (const int32 Handle : Handles)
+	{
+		const FVector& Start{ WebGraph.GetSegmentStart(Handle) };
+		const FVector& End{ WebGraph.GetSegmentEnd(Handle) };
+		const int32 Segment{ m_Segments.Add({ Start, End, Handle }) };
+
+		// Sampled every half cell, any firefly within its capture radius of the strand has one of these cells around it
+		const int32 Samples{ FMath::Max(FMath::CeilToInt32(FVector::Dist(Start, End) / (CellSize * 0.5)), 1) };
+		FIntVector LastCell{};
+		for (int32 Sample{}; Sample <= Samples; ++Sample)
+		{
+			const FIntVector Cell{ ToCell(FMath::Lerp(Start, End, static_cast<double>(Sample) / Samples), CellSize) };
+			if (Sample > 0 && Cell == LastCell)
+				continue;
+
+			LastCell = Cell;
+			m_SegmentCells.FindOrAdd(Cell).Add(Segment);
+		}
+	}
+}
+
+void UFireflyWebCaptureProcessor::FindCaptures(float CellSize)
+{
+	m_FireflyCells.Reset();
+	for (int32 Index{}; Index < m_Fireflies.Num(); ++Index)
+		m_FireflyCells.FindOrAdd(ToCell(m_Fireflies[Index].Location, CellSize)).Add(Index);
+
+	TArray<const TPair<FIntVector, TArray<int32>>*> Cells{};
+	Cells.Reserve(m_FireflyCells.Num());
+	for (const TPair<FIntVector, TArray<int32>>& Pair : m_FireflyCells)
+		Cells.Add(&Pair);
+
+	// Reads the hash and writes only the fireflies of its own cell
+	ParallelFor(Cells.Num(), [this, &Cells](int32 CellIndex)
+	{
+		// Fireflies sharing a cell share the strands around it
+		const FIntVector& Cell{ Cells[CellIndex]->Key };
+		TArray<int32, TInlineAllocator<64>> Candidates{};
+		for (int32 X{ -1 }; X <= 1; ++X)
+			for (int32 Y{ -1 }; Y <= 1; ++Y)
+				for (int32 Z{ -1 }; Z <= 1; ++Z)
+				{
+					if (const TArray<int32>* Segments{ m_SegmentCells.Find(Cell + FIntVector{ X, Y, Z }) })
+						Candidates.Append(*Segments);
+				}
+
+		if (Candidates.IsEmpty())
+			return;
+
+		for (const int32 Index : Cells[CellIndex]->Value)
+		{
+			FFirefly& Firefly{ m_Fireflies[Index] };
+			double ClosestDistanceSquared{ FMath::Square(Firefly.CaptureRadius) };
+			for (const int32 Segment : Candidates)
+			{
+				const FSegment& Candidate{ m_Segments[Segment] };
+				const FVector Closest{ FMath::ClosestPointOnSegment(Firefly.Location, Candidate.Start, Candidate.End) };
+				const double DistanceSquared{ FVector::DistSquared(Firefly.Location, Closest) };
+				if (DistanceSquared > ClosestDistanceSquared)
+					continue;
+
+				ClosestDistanceSquared = DistanceSquared;
+				Firefly.Segment = Candidate.Handle;
+				Firefly.AttachPoint = Closest;
+			}
+		}
+	}, Cells.Num() < MIN_PARALLEL_CELLS ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+#pragma endregion WebCapture
+
+#pragma region WebBreak
+// ==============================================================================
+// Web break
+// ==============================================================================
+
+UFireflyWebBreakProcessor::UFireflyWebBreakProcessor()
+	: m_EntityQuery{ *this }
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteAfter.Add(UFireflyWebCaptureProcessor::StaticClass()->GetFName());
+	// Breaking removes segments from the web graph
+	bRequiresGameThreadExecution = true;
+}
+
+void UFireflyWebBreakProcessor::ConfigureQueries()
+{
+	m_EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddRequirement<FFireflyWebFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddRequirement<FFireflyBreakDamageFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddConstSharedRequirement<FFireflyParameters>();
+	m_EntityQuery.AddTagRequirement<FFireflyTag>(EMassFragmentPresence::All);
+	m_EntityQuery.AddTagRequirement<FFireflyStuckTag>(EMassFragmentPresence::All);
+	AddLODRequirements(m_EntityQuery);
+}
+
+void UFireflyWebBreakProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	const UWorld* World{ EntityManager.GetWorld() };
+	UWebGraphSubsystem* WebGraph{ World ? World->GetSubsystem<UWebGraphSubsystem>() : nullptr };
+	if (WebGraph == nullptr)
+		return;
+
+	// Removed once the chunks are done, removal reaches Blueprint listeners and the capture subsystem
+	TArray<int32> Torn{};
+	m_EntityQuery.ForEachEntityChunk(EntityManager, Context, [WebGraph, &Torn](FMassExecutionContext& Context)
+	{
+		const FFireflyParameters& Parameters{ Context.GetConstSharedFragment<FFireflyParameters>() };
+		const TArrayView<FTransformFragment> Transforms{ Context.GetMutableFragmentView<FTransformFragment>() };
+		const TArrayView<FFireflyWebFragment> Webs{ Context.GetMutableFragmentView<FFireflyWebFragment>() };
+		const TArrayView<FFireflyBreakDamageFragment> BreakDamages{ Context.GetMutableFragmentView<FFireflyBreakDamageFragment>() };
+		const TConstArrayView<FMassSimulationVariableTickFragment> TickFragments{ Context.GetFragmentView<FMassSimulationVariableTickFragment>() };
+
+		for (int32 Index{}; Index < Context.GetNumEntities(); ++Index)
+		{
+			FFireflyWebFragment& Web{ Webs[Index] };
+			float& Damage{ BreakDamages[Index].Damage };
+
+			// Hang on the strand while tearing at it
+			Transforms[Index].GetMutableTransform().SetLocation(Web.AttachPoint);
+			Damage += Parameters.BreakRate * GetEntityDeltaTime(Context, TickFragments, Index);
+
+			const bool StrandGone{ !WebGraph->IsValidSegment(Web.Segment) };
+			if (!StrandGone && Damage < Parameters.BreakStrength)
+				continue;
+
+			if (!StrandGone)
+			{
+				Torn.AddUnique(Web.Segment);
+				Web.TornSegment = Web.Segment;
+			}
+
+			Web.Segment = INDEX_NONE;
+			Damage = 0.f;
+			Context.Defer().RemoveTag<FFireflyStuckTag>(Context.GetEntity(Index));
+		}
+	});
+
+	for (const int32 Segment : Torn)
+		WebGraph->RemoveSegment(Segment);
+}
+
+#pragma endregion WebBreak
+
+#pragma region ActorSync
+// ==============================================================================
+// Actor sync
+// ==============================================================================
+
+UFireflyActorSyncProcessor::UFireflyActorSyncProcessor()
+	: m_EntityQuery{ *this }
+{
+	ExecutionFlags = static_cast<int32>(EProcessorExecutionFlags::All);
+	ExecutionOrder.ExecuteInGroup = UE::Mass::ProcessorGroupNames::UpdateWorldFromMass;
+	bRequiresGameThreadExecution = true;
+}
+
+void UFireflyActorSyncProcessor::ConfigureQueries()
+{
+	m_EntityQuery.AddRequirement<FTransformFragment>(EMassFragmentAccess::ReadOnly);
+	m_EntityQuery.AddRequirement<FMassActorFragment>(EMassFragmentAccess::ReadWrite);
+	m_EntityQuery.AddTagRequirement<FFireflyTag>(EMassFragmentPresence::All);
+}
+
+void UFireflyActorSyncProcessor::Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context)
+{
+	m_EntityQuery.ForEachEntityChunk(EntityManager, Context, [](FMassExecutionContext& Context)
+	{
+		const TConstArrayView<FTransformFragment> Transforms{ Context.GetFragmentView<FTransformFragment>() };
+		const TArrayView<FMassActorFragment> Actors{ Context.GetMutableFragmentView<FMassActorFragment>() };
+
+		for (int32 Index{}; Index < Context.GetNumEntities(); ++Index)
+		{
+			// Only fireflies close enough for the high detail representation have an actor
+			AActor* Actor{ Actors[Index].GetMutable() };
+			if (Actor == nullptr)
+				continue;
+
+			const FTransform& Transform{ Transforms[Index].GetTransform() };
+			Actor->SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation());
+		}
+	});
+}
+
+#pragma endregion ActorSync
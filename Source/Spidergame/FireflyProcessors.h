@@ -0,0 +1,110 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassProcessor.h"
+#include "FireflyProcessors.generated.h"
+
+// Flies free fireflies toward wander targets around their home, at their simulation LOD tick rate
+UCLASS()
+class SPIDERGAME_API UFireflySteeringProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UFireflySteeringProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery m_EntityQuery;
+};
+
+class UWebGraphSubsystem;
+
+/**
+ * Sticks free fireflies that fly into a web strand to it.
+ * Strands and fireflies are binned into one spatial hash each frame, every occupied firefly cell is then tested
+ * against the strands around it in a ParallelFor. Only reads the web graph, so it runs off the game thread.
+ */
+UCLASS()
+class SPIDERGAME_API UFireflyWebCaptureProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UFireflyWebCaptureProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	struct FSegment
+	{
+		FVector Start{};
+		FVector End{};
+		int32 Handle{ INDEX_NONE };
+	};
+
+	struct FFirefly
+	{
+		FVector Location{};
+		float CaptureRadius{};
+		// Found by the pass, INDEX_NONE when nothing is close enough
+		int32 Segment{ INDEX_NONE };
+		FVector AttachPoint{};
+	};
+
+	// Cells are at least twice the largest capture radius, so a firefly only looks at its own cell and the ones around it
+	static constexpr float MIN_CELL_SIZE{ 200.f };
+	static constexpr int32 MIN_PARALLEL_CELLS{ 8 };
+
+	FMassEntityQuery m_EntityQuery;
+
+	// Rebuilt every frame, kept to reuse the memory
+	TArray<FSegment> m_Segments{};
+	TMap<FIntVector, TArray<int32>> m_SegmentCells{};
+	TArray<FFirefly> m_Fireflies{};
+	TMap<FIntVector, TArray<int32>> m_FireflyCells{};
+
+	void BinSegments(const UWebGraphSubsystem& WebGraph, float CellSize);
+	void FindCaptures(float CellSize);
+};
+
+// Stuck fireflies tear at their strand until it breaks and frees them
+UCLASS()
+class SPIDERGAME_API UFireflyWebBreakProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UFireflyWebBreakProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery m_EntityQuery;
+};
+
+// Moves the actors of fireflies close enough to be represented by BP_BaseFirefly
+UCLASS()
+class SPIDERGAME_API UFireflyActorSyncProcessor : public UMassProcessor
+{
+	GENERATED_BODY()
+
+public:
+	UFireflyActorSyncProcessor();
+
+protected:
+	virtual void ConfigureQueries() override;
+	virtual void Execute(FMassEntityManager& EntityManager, FMassExecutionContext& Context) override;
+
+private:
+	FMassEntityQuery m_EntityQuery;
+};
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "FireflyTrait.h"
+
+#include "MassCommonFragments.h"
+#include "MassEntityTemplateRegistry.h"
+#include "MassEntityUtils.h"
+#include "MassMovementFragments.h"
+
+void UFireflyTrait::BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const
+{
+	FMassEntityManager& EntityManager{ UE::Mass::Utils::GetEntityManagerChecked(World) };
+
+	BuildContext.AddTag<FFireflyTag>();
+	BuildContext.AddFragment<FTransformFragment>();
+	BuildContext.AddFragment<FMassVelocityFragment>();
+	BuildContext.AddFragment<FFireflyTargetFragment>();
+	BuildContext.AddFragment<FFireflyBreakDamageFragment>();
+	BuildContext.AddFragment<FFireflyWebFragment>();
+
+	const FConstSharedStruct ParametersFragment{ EntityManager.GetOrCreateConstSharedFragment(Parameters) };
+	BuildContext.AddConstSharedFragment(ParametersFragment);
+}
@@ -0,0 +1,25 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MassEntityTraitBase.h"
+#include "FireflyFragments.h"
+#include "FireflyTrait.generated.h"
+
+/**
+ * Turns a Mass entity config into a firefly.
+ * Pair it with the Simulation LOD trait for lower tick rates at distance
+ * and a visualization trait that swaps nearby fireflies to BP_BaseFirefly actors.
+ */
+UCLASS(meta=(DisplayName="Firefly"))
+class SPIDERGAME_API UFireflyTrait : public UMassEntityTraitBase
+{
+	GENERATED_BODY()
+
+protected:
+	UPROPERTY(EditAnywhere, Category="Firefly")
+	FFireflyParameters Parameters{};
+
+	virtual void BuildTemplate(FMassEntityTemplateBuildContext& BuildContext, const UWorld& World) const override;
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "PooledActor.generated.h"
+
+UINTERFACE(MinimalAPI, Blueprintable)
+class UPooledActor : public UInterface
+{
+	GENERATED_BODY()
+};
+
+/**
+ * Actors handed out by an actor pool. BeginPlay only runs once per actor,
+ * so per-life state (travelled distance, break damage, ...) has to be reset in OnReleasedToPool.
+ */
+class SPIDERGAME_API IPooledActor
+{
+	GENERATED_BODY()
+
+public:
+	// Actor is visible and ticking again at its new spawn transform
+	UFUNCTION(BlueprintNativeEvent, Category="Pool")
+	void OnAcquiredFromPool();
+	// Actor is hidden and waiting in the pool
+	UFUNCTION(BlueprintNativeEvent, Category="Pool")
+	void OnReleasedToPool();
+};
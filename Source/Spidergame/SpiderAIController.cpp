@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderAIController.h"
+
+#include "BaseSpider.h"
+#include "SpiderNavSubsystem.h"
+#include "Engine/World.h"
+
+ASpiderAIController::ASpiderAIController()
+{
+	PrimaryActorTick.bCanEverTick = true;
+
+	// The body yaw is ours to set, it is relative to whatever surface the spider is on
+	bSetControlRotationFromPawnOrientation = false;
+}
+
+void ASpiderAIController::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	ABaseSpider* Spider{ Cast<ABaseSpider>(GetPawn()) };
+	if (Spider == nullptr || !m_Path.IsValidIndex(m_PathIndex))
+		return;
+
+	const FSpiderNavPoint& Point{ m_Path[m_PathIndex] };
+	const float Distance{ static_cast<float>(FVector::Dist(Spider->GetActorLocation(), Point.Location)) };
+	if (Distance <= AcceptanceRadius)
+	{
+		if (++m_PathIndex == m_Path.Num())
+		{
+			Finish(true);
+			return;
+		}
+
+		m_ClosestDistance = TNumericLimits<float>::Max();
+		m_StuckTimer = 0.f;
+		return;
+	}
+
+	// Walls, missed jumps and broken strands, search again from here
+	if (Distance < m_ClosestDistance)
+	{
+		m_ClosestDistance = Distance;
+		m_StuckTimer = 0.f;
+	}
+	else if ((m_StuckTimer += DeltaTime) > StuckTime && !m_Searching)
+	{
+		if (!RequestPath(Spider->GetActorLocation()))
+			Finish(false);
+		return;
+	}
+
+	Steer(*Spider, Point.Location);
+}
+
+bool ASpiderAIController::MoveAlongSurfaces(const FVector& Goal)
+{
+	const APawn* Spider{ GetPawn() };
+	if (Spider == nullptr)
+		return false;
+
+	m_Goal = Goal;
+	m_Path.Reset();
+	return RequestPath(Spider->GetActorLocation());
+}
+
+void ASpiderAIController::StopMovingAlongSurfaces()
+{
+	++m_Request;
+	m_Searching = false;
+	m_Path.Reset();
+}
+
+bool ASpiderAIController::IsMovingAlongSurfaces() const
+{
+	return m_Searching || m_Path.IsValidIndex(m_PathIndex);
+}
+
+void ASpiderAIController::OnPossess(APawn* InPawn)
+{
+	Super::OnPossess(InPawn);
+
+	// Input has to be there before the spider consumes it
+	if (InPawn)
+		InPawn->AddTickPrerequisiteActor(this);
+}
+
+bool ASpiderAIController::RequestPath(const FVector& Start)
+{
+	USpiderNavSubsystem* Navigation{ GetWorld()->GetSubsystem<USpiderNavSubsystem>() };
+	if (Navigation == nullptr)
+		return false;
+
+	const int32 Request{ ++m_Request };
+	m_Searching = Navigation->FindPathAsync(Start, m_Goal, FSpiderPathFound::CreateUObject(this, &ASpiderAIController::HandlePathFound, Request));
+	return m_Searching;
+}
+
+void ASpiderAIController::HandlePathFound(bool Found, const TArray<FSpiderNavPoint>& Path, int32 Request)
+{
+	if (Request != m_Request)
+		return;
+
+	m_Searching = false;
+	if (!Found)
+	{
+		Finish(false);
+		return;
+	}
+
+	m_Path = Path;
+	m_PathIndex = 0;
+	m_ClosestDistance = TNumericLimits<float>::Max();
+	m_StuckTimer = 0.f;
+}
+
+void ASpiderAIController::Finish(bool Success)
+{
+	m_Path.Reset();
+	m_PathIndex = 0;
+	OnSurfaceMoveFinished.Broadcast(Success);
+}
+
+void ASpiderAIController::Steer(ABaseSpider& Spider, const FVector& Target)
+{
+	// Yaw in the frame of the surface the spider stands on, that's what its body turns by
+	const FVector Local{ Spider.GetActorQuat().UnrotateVector(Target - Spider.GetActorLocation()) };
+	SetControlRotation({ 0.f, FMath::RadiansToDegrees(FMath::Atan2(Local.Y, Local.X)), 0.f });
+
+	// Spiders walk on the Y axis of their input, same as the player's forward key
+	Spider.AddMovementInput(FVector::UnitY());
+}
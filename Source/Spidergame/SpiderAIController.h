@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AIController.h"
+#include "SpiderNavGraph.h"
+#include "SpiderAIController.generated.h"
+
+class ABaseSpider;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FSpiderSurfaceMoveFinished, bool, Success);
+
+/**
+ * Walks a spider over the surface navigation graph, floors, walls, ceilings and web strands alike.
+ * Paths are searched off the game thread, following one turns the spider's body towards the next point
+ * and pushes it forward through the same movement input a player would.
+ */
+UCLASS()
+class SPIDERGAME_API ASpiderAIController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	ASpiderAIController();
+
+	// Close enough to a path point to head for the next one
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Navigation")
+	float AcceptanceRadius{ 80.f };
+	// Searches again from where the spider is when it got no closer to the next point for this long
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Navigation")
+	float StuckTime{ 2.f };
+
+	UPROPERTY(BlueprintAssignable, Category="Navigation")
+	FSpiderSurfaceMoveFinished OnSurfaceMoveFinished{};
+
+	virtual void Tick(float DeltaTime) override;
+
+	// Returns false when there is no surface graph or nothing near the spider or the goal
+	UFUNCTION(BlueprintCallable, Category="Navigation")
+	bool MoveAlongSurfaces(const FVector& Goal);
+	UFUNCTION(BlueprintCallable, Category="Navigation")
+	void StopMovingAlongSurfaces();
+	UFUNCTION(BlueprintPure, Category="Navigation")
+	bool IsMovingAlongSurfaces() const;
+
+protected:
+	virtual void OnPossess(APawn* InPawn) override;
+
+private:
+	TArray<FSpiderNavPoint> m_Path{};
+	int32 m_PathIndex{};
+	FVector m_Goal{};
+	// Callbacks for anything but the latest request are dropped
+	int32 m_Request{};
+	bool m_Searching{ false };
+
+	float m_ClosestDistance{};
+	float m_StuckTimer{};
+
+	bool RequestPath(const FVector& Start);
+	void HandlePathFound(bool Found, const TArray<FSpiderNavPoint>& Path, int32 Request);
+	void Finish(bool Success);
+	void Steer(ABaseSpider& Spider, const FVector& Target);
+};
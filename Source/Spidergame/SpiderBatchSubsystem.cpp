@@ -0,0 +1,89 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderBatchSubsystem.h"
+
+#include "BaseSpider.h"
+#include "SpiderStats.h"
+#include "Async/ParallelFor.h"
+
+static TAutoConsoleVariable<bool> CVarSpiderBatch(
+	TEXT("Spider.Batch.Enabled"),
+	true,
+	TEXT("Simulate spiders not controlled by a local player together in one batch after the actor ticks"));
+
+void USpiderBatchSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (m_Queued.IsEmpty())
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SpiderSimulate);
+	CSV_SCOPED_TIMING_STAT(Spider, Simulate);
+
+	// Gather, input and fixed step accumulators are read off each spider once
+	m_Spiders.Reset();
+	m_Steps.Reset();
+	int32 MaxSteps{};
+	for (int32 Index{}; Index < m_Queued.Num(); ++Index)
+	{
+		ABaseSpider* Spider{ m_Queued[Index].Get() };
+		if (Spider == nullptr)
+			continue;
+
+		Spider->BeginSimulate(m_QueuedDeltaTimes[Index]);
+		m_Spiders.Add(Spider);
+		m_Steps.Add(Spider->m_FrameSteps);
+		MaxSteps = FMath::Max(MaxSteps, Spider->m_FrameSteps);
+	}
+
+	m_Queued.Reset();
+	m_QueuedDeltaTimes.Reset();
+	m_Integrated.SetNumUninitialized(m_Spiders.Num(), false);
+	SET_DWORD_STAT(STAT_SpiderBatched, m_Spiders.Num());
+
+	for (int32 Step{}; Step < MaxSteps; ++Step)
+	{
+		// Integrate, every spider only touches its own simulation state. Jumps and lerps finish here,
+		// falls get their gravity and drag for every substep so the game thread only sweeps
+		{
+			SCOPE_CYCLE_COUNTER(STAT_SpiderBatchIntegrate);
+			ParallelFor(m_Spiders.Num(), [this, Step](int32 Index)
+			{
+				m_Integrated[Index] = Step < m_Steps[Index] && m_Spiders[Index]->IntegrateStep();
+			}, m_Spiders.Num() < MIN_PARALLEL_SPIDERS ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+		}
+
+		// Decide, traces, state changes and sweeps stay on the game thread
+		SCOPE_CYCLE_COUNTER(STAT_SpiderBatchDecide);
+		for (int32 Index{}; Index < m_Spiders.Num(); ++Index)
+		{
+			if (Step < m_Steps[Index])
+				m_Spiders[Index]->FinishStep(m_Integrated[Index]);
+		}
+	}
+
+	// Move, every actor gets its transform once
+	SCOPE_CYCLE_COUNTER(STAT_SpiderBatchMove);
+	for (ABaseSpider* Spider : m_Spiders)
+		Spider->EndSimulate();
+
+	m_Spiders.Reset();
+}
+
+TStatId USpiderBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USpiderBatchSubsystem, STATGROUP_Tickables);
+}
+
+bool USpiderBatchSubsystem::ShouldBatch(const ABaseSpider* Spider) const
+{
+	// The player's spider keeps its own tick, the camera and input follow it the same frame.
+	// AI controllers are local too, only a local player is left out
+	return CVarSpiderBatch.GetValueOnGameThread() && !(Spider->IsPlayerControlled() && Spider->IsLocallyControlled());
+}
+
+void USpiderBatchSubsystem::Queue(ABaseSpider* Spider, float DeltaTime)
+{
+	m_Queued.Add(Spider);
+	m_QueuedDeltaTimes.Add(DeltaTime);
+}
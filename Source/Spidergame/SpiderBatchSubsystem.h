@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SpiderBatchSubsystem.generated.h"
+
+class ABaseSpider;
+
+/**
+ * Simulates every spider not controlled by a local player together instead of one actor tick at a time.
+ * Spiders queue themselves from their tick (so significance throttling still applies), the batch runs after the actor ticks:
+ * every fixed step integrates the pure math steps (transition lerps, jump rises) of all spiders in a ParallelFor,
+ * then decides the rest on the game thread where traces are allowed, and finally moves all actors in one pass.
+ * Walking, falling and riding strands stay on the game thread, every one of their steps is built around probes and sweeps.
+ */
+UCLASS()
+class SPIDERGAME_API USpiderBatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	bool ShouldBatch(const ABaseSpider* Spider) const;
+	// Simulated with the rest of the batch this frame, DeltaTime is what the spider's own tick got
+	void Queue(ABaseSpider* Spider, float DeltaTime);
+
+private:
+	// Below this the worker threads cost more than they save
+	static constexpr int32 MIN_PARALLEL_SPIDERS{ 16 };
+
+	TArray<TWeakObjectPtr<ABaseSpider>> m_Queued{};
+	TArray<float> m_QueuedDeltaTimes{};
+
+	// Contiguous per frame state, indices match
+	TArray<ABaseSpider*> m_Spiders{};
+	TArray<int32> m_Steps{};
+	TArray<bool> m_Integrated{};
+};
@@ -0,0 +1,359 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderBenchmarkCommandlet.h"
+
+#include "AIController.h"
+#include "BaseSpider.h"
+#include "EngineUtils.h"
+#include "SpiderProbeSubsystem.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerStart.h"
+#include "GameFramework/WorldSettings.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSpiderBenchmark, Log, All);
+
+namespace
+{
+	const TCHAR* DEFAULT_SPIDER_CLASS{ TEXT("/Game/Dynamic/Blueprints/Pawns/Player/BP_BaseSpider.BP_BaseSpider_C") };
+	const TCHAR* DEFAULT_MAPS{ TEXT("/Game/Dynamic/Levels/Test+/Game/Dynamic/Levels/TightTunnel") };
+	const TCHAR* DEFAULT_SPIDER_COUNTS{ TEXT("1+8+32") };
+	const TCHAR* STATE_NAMES[SPIDER_STATE_COUNT]{ TEXT("Grounded"), TEXT("Transition"), TEXT("Falling"), TEXT("OnWeb"), TEXT("Jumping") };
+}
+
+USpiderBenchmarkCommandlet::USpiderBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 USpiderBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString SpiderClassPath{ DEFAULT_SPIDER_CLASS };
+	FString Maps{ DEFAULT_MAPS };
+	FString SpiderCounts{ DEFAULT_SPIDER_COUNTS };
+	FString OutputPath{ FPaths::ProfilingDir() / TEXT("SpiderBenchmark") / FString::Printf(TEXT("SpiderBenchmark-%s.csv"), *FDateTime::Now().ToString()) };
+
+	FParse::Value(*Params, TEXT("SpiderClass="), SpiderClassPath);
+	FParse::Value(*Params, TEXT("Maps="), Maps);
+	FParse::Value(*Params, TEXT("Spiders="), SpiderCounts);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	FParse::Value(*Params, TEXT("Frames="), m_Frames);
+	FParse::Value(*Params, TEXT("Warmup="), m_WarmupFrames);
+	FParse::Value(*Params, TEXT("DeltaTime="), m_DeltaTime);
+
+	// A recording brings its own map
+	TSharedPtr<FSpiderRecording> Recording{};
+	FString ReplayPath{};
+	if (FParse::Value(*Params, TEXT("Replay="), ReplayPath))
+	{
+		Recording = MakeShared<FSpiderRecording>();
+		if (!Recording->Load(ReplayPath))
+		{
+			UE_LOG(LogSpiderBenchmark, Error, TEXT("Could not read recording %s"), *ReplayPath);
+			return 1;
+		}
+		if (!FParse::Value(*Params, TEXT("Maps="), Maps))
+			Maps = Recording->MapPath;
+	}
+
+	m_SpiderClass = LoadClass<ABaseSpider>(nullptr, *SpiderClassPath);
+	if (m_SpiderClass == nullptr)
+	{
+		UE_LOG(LogSpiderBenchmark, Error, TEXT("Could not load spider class %s"), *SpiderClassPath);
+		return 1;
+	}
+
+	TArray<FString> MapPaths{};
+	Maps.ParseIntoArray(MapPaths, TEXT("+"));
+
+	TArray<FString> CountStrings{};
+	SpiderCounts.ParseIntoArray(CountStrings, TEXT("+"));
+
+	TArray<FRunResult> Results{};
+	for (const FString& MapPath : MapPaths)
+	{
+		UWorld* World{ LoadWorld(MapPath) };
+		if (World == nullptr)
+		{
+			UE_LOG(LogSpiderBenchmark, Error, TEXT("Could not load map %s"), *MapPath);
+			continue;
+		}
+
+		if (Recording)
+		{
+			FRunResult& Result{ Results.AddDefaulted_GetRef() };
+			if (!RunReplay(World, MapPath, Recording.ToSharedRef(), Result))
+				Results.Pop();
+		}
+		else
+		{
+			for (const FString& CountString : CountStrings)
+			{
+				FRunResult& Result{ Results.AddDefaulted_GetRef() };
+				if (!Run(World, MapPath, FCString::Atoi(*CountString), Result))
+					Results.Pop();
+			}
+		}
+
+		UnloadWorld(World);
+	}
+
+	if (!WriteCsv(OutputPath, Results))
+	{
+		UE_LOG(LogSpiderBenchmark, Error, TEXT("Could not write %s"), *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(LogSpiderBenchmark, Display, TEXT("Wrote %d runs to %s"), Results.Num(), *OutputPath);
+	return 0;
+}
+
+#pragma region World
+// ==============================================================================
+// World
+// ==============================================================================
+
+UWorld* USpiderBenchmarkCommandlet::LoadWorld(const FString& MapPath) const
+{
+	UPackage* Package{ LoadPackage(nullptr, *MapPath, LOAD_None) };
+	UWorld* World{ Package ? UWorld::FindWorldInPackage(Package) : nullptr };
+	if (World == nullptr)
+		return nullptr;
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Game;
+
+	FWorldContext& WorldContext{ GEngine->CreateNewWorldContext(EWorldType::Game) };
+	WorldContext.SetCurrentWorld(World);
+
+	if (!World->bIsWorldInitialized)
+		World->InitWorld();
+
+	// No game mode, spiders don't need one and the menu game mode wants a viewport
+	World->InitializeActorsForPlay(FURL{});
+	World->GetWorldSettings()->NotifyBeginPlay();
+	return World;
+}
+
+void USpiderBenchmarkCommandlet::UnloadWorld(UWorld* World) const
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+	CollectGarbage(RF_NoFlags);
+}
+
+#pragma endregion World
+
+#pragma region Run
+// ==============================================================================
+// Run
+// ==============================================================================
+
+bool USpiderBenchmarkCommandlet::Run(UWorld* World, const FString& MapPath, int32 SpiderCount, FRunResult& OutResult) const
+{
+	if (SpiderCount <= 0)
+		return false;
+
+	TArray<FScriptedSpider> Spiders{ SpawnSpiders(World, SpiderCount) };
+
+	OutResult.Map = FPaths::GetBaseFilename(MapPath);
+	OutResult.Spiders = Spiders.Num();
+
+	FSpiderStateTimings Timings{};
+	FSpiderMovement::SetTimingSink(&Timings);
+
+	for (int32 Frame{}; Frame < m_WarmupFrames + m_Frames; ++Frame)
+	{
+		for (FScriptedSpider& Scripted : Spiders)
+			DriveSpider(Scripted);
+
+		TickFrame(World, m_DeltaTime, Frame >= m_WarmupFrames, Timings, OutResult);
+	}
+
+	FSpiderMovement::SetTimingSink(nullptr);
+
+	for (const FScriptedSpider& Scripted : Spiders)
+	{
+		Scripted.Controller->UnPossess();
+		World->DestroyActor(Scripted.Controller);
+		World->DestroyActor(Scripted.Spider);
+	}
+
+	UE_LOG(LogSpiderBenchmark, Display, TEXT("%s, %d spiders: %.3f ms mean, %.3f ms p99"),
+		*OutResult.Map, OutResult.Spiders, Mean(OutResult.FrameMs), Percentile(OutResult.FrameMs, 99.0));
+	return true;
+}
+
+bool USpiderBenchmarkCommandlet::RunReplay(UWorld* World, const FString& MapPath, const TSharedRef<const FSpiderRecording>& Recording, FRunResult& OutResult) const
+{
+	FActorSpawnParameters SpawnParams{};
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	const FSpiderSimState& Start{ Recording->Snapshots[0].State };
+	ABaseSpider* Spider{ World->SpawnActor<ABaseSpider>(m_SpiderClass, Start.Location, Start.SurfaceRotation.Rotator(), SpawnParams) };
+	if (Spider == nullptr)
+		return false;
+
+	// The controller only carries the recorded control rotation
+	AAIController* Controller{ World->SpawnActor<AAIController>(Start.Location, FRotator::ZeroRotator, SpawnParams) };
+	Controller->bSetControlRotationFromPawnOrientation = false;
+	Controller->Possess(Spider);
+	if (!Spider->StartReplay(Recording))
+		return false;
+
+	OutResult.Map = FPaths::GetBaseFilename(MapPath) + TEXT(" replay");
+	OutResult.Spiders = 1;
+
+	FSpiderStateTimings Timings{};
+	FSpiderMovement::SetTimingSink(&Timings);
+
+	for (int32 Frame{}; Frame < Recording->Frames.Num(); ++Frame)
+		TickFrame(World, Recording->Frames[Frame].DeltaTime, Frame >= m_WarmupFrames, Timings, OutResult);
+
+	FSpiderMovement::SetTimingSink(nullptr);
+
+	OutResult.Divergences = Spider->GetReplayDivergences();
+	Spider->StopReplay();
+	Controller->UnPossess();
+	World->DestroyActor(Controller);
+	World->DestroyActor(Spider);
+
+	UE_LOG(LogSpiderBenchmark, Display, TEXT("%s, %d frames: %.3f ms mean, %.3f ms p99, %d diverged snapshots"),
+		*OutResult.Map, Recording->Frames.Num(), Mean(OutResult.FrameMs), Percentile(OutResult.FrameMs, 99.0), OutResult.Divergences);
+	return true;
+}
+
+void USpiderBenchmarkCommandlet::TickFrame(UWorld* World, float DeltaTime, bool Measured, FSpiderStateTimings& Timings, FRunResult& OutResult) const
+{
+	USpiderProbeSubsystem* Probes{ World->GetSubsystem<USpiderProbeSubsystem>() };
+	Timings.Reset();
+	Probes->ResetTraceCounts();
+
+	const uint64 StartCycles{ FPlatformTime::Cycles64() };
+	World->Tick(LEVELTICK_All, DeltaTime);
+	const uint64 FrameCycles{ FPlatformTime::Cycles64() - StartCycles };
+
+	if (!Measured)
+		return;
+
+	OutResult.FrameMs.Add(FPlatformTime::ToMilliseconds64(FrameCycles));
+	for (int32 State{}; State < SPIDER_STATE_COUNT; ++State)
+		OutResult.StateMs[State].Add(FPlatformTime::ToMilliseconds64(Timings.Cycles[State]));
+	OutResult.TracesPerFrame.Add(Probes->GetSyncTraceCount() + Probes->GetAsyncTraceCount());
+}
+
+TArray<USpiderBenchmarkCommandlet::FScriptedSpider> USpiderBenchmarkCommandlet::SpawnSpiders(UWorld* World, int32 SpiderCount) const
+{
+	// Spread the spiders over the player starts, or the origin when the map has none
+	TArray<FVector> SpawnPoints{};
+	for (TActorIterator<APlayerStart> It{ World }; It; ++It)
+		SpawnPoints.Add(It->GetActorLocation());
+	if (SpawnPoints.IsEmpty())
+		SpawnPoints.Add(FVector::ZeroVector);
+
+	FActorSpawnParameters SpawnParams{};
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	TArray<FScriptedSpider> Spiders{};
+	for (int32 Index{}; Index < SpiderCount; ++Index)
+	{
+		const FVector Center{ SpawnPoints[Index % SpawnPoints.Num()] };
+		const float Angle{ 2.f * PI * Index / SpiderCount };
+		const FVector Location{ Center + FVector{ FMath::Cos(Angle), FMath::Sin(Angle), 0.f } * SPAWN_RADIUS };
+
+		ABaseSpider* Spider{ World->SpawnActor<ABaseSpider>(m_SpiderClass, Location, FRotator::ZeroRotator, SpawnParams) };
+		if (Spider == nullptr)
+			continue;
+
+		AAIController* Controller{ World->SpawnActor<AAIController>(Location, FRotator::ZeroRotator, SpawnParams) };
+		Controller->bSetControlRotationFromPawnOrientation = false;
+		Controller->Possess(Spider);
+
+		// Loop around the spawn point, every spider starting at a different waypoint
+		FScriptedSpider& Scripted{ Spiders.AddDefaulted_GetRef() };
+		Scripted.Spider = Spider;
+		Scripted.Controller = Controller;
+		Scripted.NextPoint = Index % PATH_POINTS;
+		Scripted.JumpTimer = JUMP_INTERVAL * Index / SpiderCount;
+		for (int32 Point{}; Point < PATH_POINTS; ++Point)
+		{
+			const float PointAngle{ 2.f * PI * Point / PATH_POINTS };
+			Scripted.Path.Add(Center + FVector{ FMath::Cos(PointAngle), FMath::Sin(PointAngle), 0.f } * PATH_RADIUS);
+		}
+	}
+
+	return Spiders;
+}
+
+void USpiderBenchmarkCommandlet::DriveSpider(FScriptedSpider& Scripted) const
+{
+	ABaseSpider* Spider{ Scripted.Spider };
+	const FVector ToPoint{ Scripted.Path[Scripted.NextPoint] - Spider->GetActorLocation() };
+	if (ToPoint.SizeSquared2D() < WAYPOINT_RADIUS * WAYPOINT_RADIUS)
+		Scripted.NextPoint = (Scripted.NextPoint + 1) % Scripted.Path.Num();
+
+	// Same input path as the player, yaw through the controller and forward on Y
+	Scripted.Controller->SetControlRotation({ 0, ToPoint.Rotation().Yaw, 0 });
+	Spider->AddMovementInput(FVector::YAxisVector);
+
+	Scripted.JumpTimer -= m_DeltaTime;
+	if (Scripted.JumpTimer < 0.f)
+	{
+		Spider->Jump(JUMP_POWER);
+		Scripted.JumpTimer = JUMP_INTERVAL;
+	}
+}
+
+#pragma endregion Run
+
+#pragma region Report
+// ==============================================================================
+// Report
+// ==============================================================================
+
+double USpiderBenchmarkCommandlet::Mean(const TArray<double>& Samples)
+{
+	if (Samples.IsEmpty())
+		return 0.0;
+
+	double Sum{};
+	for (const double Sample : Samples)
+		Sum += Sample;
+	return Sum / Samples.Num();
+}
+
+double USpiderBenchmarkCommandlet::Percentile(TArray<double> Samples, double Percent)
+{
+	if (Samples.IsEmpty())
+		return 0.0;
+
+	Samples.Sort();
+	const int32 Index{ FMath::Clamp(FMath::CeilToInt32(Percent / 100.0 * Samples.Num()) - 1, 0, Samples.Num() - 1) };
+	return Samples[Index];
+}
+
+bool USpiderBenchmarkCommandlet::WriteCsv(const FString& Path, const TArray<FRunResult>& Results)
+{
+	FString Csv{ TEXT("Map,Spiders,Frames,FrameMeanMs,FrameP99Ms") };
+	for (const TCHAR* StateName : STATE_NAMES)
+		Csv += FString::Printf(TEXT(",%sMeanMs,%sP99Ms"), StateName, StateName);
+	Csv += TEXT(",TracesMean,TracesP99,Divergences\n");
+
+	for (const FRunResult& Result : Results)
+	{
+		Csv += FString::Printf(TEXT("%s,%d,%d,%.4f,%.4f"), *Result.Map, Result.Spiders, Result.FrameMs.Num(),
+			Mean(Result.FrameMs), Percentile(Result.FrameMs, 99.0));
+		for (const TArray<double>& StateMs : Result.StateMs)
+			Csv += FString::Printf(TEXT(",%.4f,%.4f"), Mean(StateMs), Percentile(StateMs, 99.0));
+		Csv += FString::Printf(TEXT(",%.2f,%.2f,%d\n"), Mean(Result.TracesPerFrame), Percentile(Result.TracesPerFrame, 99.0), Result.Divergences);
+	}
+
+	return FFileHelper::SaveStringToFile(Csv, *Path);
+}
+
+#pragma endregion Report
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "SpiderMovement.h"
+#include "SpiderRecording.h"
+#include "SpiderBenchmarkCommandlet.generated.h"
+
+class AAIController;
+class ABaseSpider;
+
+/**
+ * Loads the gameplay maps headless, drives 1..N scripted spiders and writes game thread cost per movement state to CSV.
+ *
+ * UnrealEditor-Cmd Spidergame.uproject -run=SpiderBenchmark -nullrhi -unattended
+ *		[-Maps=/Game/Dynamic/Levels/Test+/Game/Dynamic/Levels/TightTunnel] [-Spiders=1+8+32]
+ *		[-Frames=600] [-Warmup=60] [-DeltaTime=0.0166] [-Output=Path.csv]
+ *
+ * With -Replay=Path.spiderrec one spider replays a recorded session instead, in the recorded map unless -Maps is given,
+ * ticked with the recorded frame times so every run steps exactly the same.
+ */
+UCLASS()
+class SPIDERGAME_API USpiderBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USpiderBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	struct FScriptedSpider
+	{
+		TObjectPtr<ABaseSpider> Spider{};
+		TObjectPtr<AAIController> Controller{};
+		TArray<FVector> Path{};
+		int32 NextPoint{};
+		float JumpTimer{};
+	};
+
+	struct FRunResult
+	{
+		FString Map{};
+		int32 Spiders{};
+		TArray<double> FrameMs{};
+		TArray<double> StateMs[SPIDER_STATE_COUNT]{};
+		TArray<double> TracesPerFrame{};
+		// Replays only, snapshots the replay didn't match
+		int32 Divergences{};
+	};
+
+	static constexpr float SPAWN_RADIUS{ 150.f };
+	static constexpr float WAYPOINT_RADIUS{ 100.f };
+	static constexpr float PATH_RADIUS{ 600.f };
+	static constexpr int32 PATH_POINTS{ 8 };
+	static constexpr float JUMP_INTERVAL{ 2.5f };
+	static constexpr float JUMP_POWER{ 1200.f };
+
+	TSubclassOf<ABaseSpider> m_SpiderClass{};
+	int32 m_Frames{ 600 };
+	int32 m_WarmupFrames{ 60 };
+	float m_DeltaTime{ 1.f / 60.f };
+
+	UWorld* LoadWorld(const FString& MapPath) const;
+	void UnloadWorld(UWorld* World) const;
+
+	bool Run(UWorld* World, const FString& MapPath, int32 SpiderCount, FRunResult& OutResult) const;
+	bool RunReplay(UWorld* World, const FString& MapPath, const TSharedRef<const FSpiderRecording>& Recording, FRunResult& OutResult) const;
+	// Ticks the world once, adding the frame to OutResult when Measured
+	void TickFrame(UWorld* World, float DeltaTime, bool Measured, FSpiderStateTimings& Timings, FRunResult& OutResult) const;
+	TArray<FScriptedSpider> SpawnSpiders(UWorld* World, int32 SpiderCount) const;
+	void DriveSpider(FScriptedSpider& Scripted) const;
+
+	static double Mean(const TArray<double>& Samples);
+	static double Percentile(TArray<double> Samples, double Percent);
+	static bool WriteCsv(const FString& Path, const TArray<FRunResult>& Results);
+};
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CollisionQueryParams.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/HitResult.h"
+#include "GameFramework/Actor.h"
+
+// Object channels from DefaultEngine.ini, keep them in sync with the [/Script/Engine.CollisionProfile] section
+constexpr ECollisionChannel ECC_WEB_LINE{ ECC_GameTraceChannel1 };
+constexpr ECollisionChannel ECC_WEB{ ECC_GameTraceChannel2 };
+
+// Collision profiles for web components, set on the component instead of tagging the actor
+const FName WEB_LINE_PROFILE{ TEXT("WebLine") };
+const FName WEB_PROFILE{ TEXT("Web") };
+// Actor tags of Blueprint webs saved before the web profiles, UWebGraphSubsystem moves those onto the profiles once when they spawn
+const FName WEB_TAG{ TEXT("Web") };
+const FName WEB_LINE_TAG{ TEXT("WebLine") };
+
+enum class ESpiderSurface : uint8
+{
+	None,
+	Ground,
+	// Big web structures, walked on like ground
+	Web,
+	// Single strands the spider mounts
+	WebLine
+};
+
+// Read off the object type of the hit component, no tag or actor lookups
+inline ESpiderSurface GetSpiderSurface(const FHitResult& HitResult)
+{
+	const UPrimitiveComponent* Component{ HitResult.GetComponent() };
+	if (!HitResult.bBlockingHit || Component == nullptr)
+		return ESpiderSurface::None;
+
+	switch (Component->GetCollisionObjectType())
+	{
+	// Only the fall sweep sees these, they stop the body but aren't stood on
+	case ECC_Pawn:
+	case ECC_PhysicsBody:
+		return ESpiderSurface::None;
+	case ECC_WEB_LINE:
+		return ESpiderSurface::WebLine;
+	case ECC_WEB:
+		return ESpiderSurface::Web;
+	default:
+		return ESpiderSurface::Ground;
+	}
+}
+
+// What spider surface probes can stand on, pawns and physics bodies are left out
+inline FCollisionObjectQueryParams MakeSpiderSurfaceQuery(bool IncludeWebs = true)
+{
+	FCollisionObjectQueryParams Query{};
+	Query.AddObjectTypesToQuery(ECC_WorldStatic);
+	Query.AddObjectTypesToQuery(ECC_WorldDynamic);
+	if (IncludeWebs)
+	{
+		Query.AddObjectTypesToQuery(ECC_WEB_LINE);
+		Query.AddObjectTypesToQuery(ECC_WEB);
+	}
+	return Query;
+}
+
+// The falling body also stops at pawns and physics bodies, it just can't land on them
+inline FCollisionObjectQueryParams MakeSpiderFallQuery()
+{
+	FCollisionObjectQueryParams Query{ MakeSpiderSurfaceQuery() };
+	Query.AddObjectTypesToQuery(ECC_Pawn);
+	Query.AddObjectTypesToQuery(ECC_PhysicsBody);
+	return Query;
+}
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderContactCache.h"
+
+#include "Components/PrimitiveComponent.h"
+#include "PhysicsEngine/BodySetup.h"
+
+static TAutoConsoleVariable<bool> CVarSpiderContactCache(
+	TEXT("Spider.ContactCache.Enabled"),
+	true,
+	TEXT("Answer spider down probes from the cached ground plane while walking on static geometry"));
+
+static TAutoConsoleVariable<float> CVarSpiderContactDistanceBudget(
+	TEXT("Spider.ContactCache.DistanceBudget"),
+	100.f,
+	TEXT("Distance a spider may walk on a cached plane before it traces again"));
+
+static TAutoConsoleVariable<float> CVarSpiderContactEdgeMargin(
+	TEXT("Spider.ContactCache.EdgeMargin"),
+	30.f,
+	TEXT("Trace again when the ray lands closer than this to the edge of the primitive's collision box"));
+
+namespace
+{
+	// A single box is flat over each face, curved, convex or complex collision is traced every step
+	bool GetCollisionBox(const UPrimitiveComponent& Component, FTransform& OutTransform, FBox& OutBox)
+	{
+		const UBodySetup* BodySetup{ Component.GetBodySetup() };
+		if (BodySetup == nullptr || BodySetup->CollisionTraceFlag == CTF_UseComplexAsSimple)
+			return false;
+
+		const FKAggregateGeom& Geometry{ BodySetup->AggGeom };
+		if (Geometry.BoxElems.Num() != 1 || Geometry.GetElementCount() != 1)
+			return false;
+
+		const FKBoxElem& Box{ Geometry.BoxElems[0] };
+		const FVector Extent{ Box.X * 0.5, Box.Y * 0.5, Box.Z * 0.5 };
+		OutTransform = Box.GetTransform() * Component.GetComponentTransform();
+		OutBox = FBox{ -Extent, Extent };
+		return true;
+	}
+}
+
+bool FSpiderContactCache::TryHit(const FVector& Start, const FVector& End, FHitResult& OutHit)
+{
+	if (!m_Valid)
+		return false;
+
+	if (!CVarSpiderContactCache.GetValueOnGameThread())
+	{
+		Invalidate();
+		return false;
+	}
+
+	m_Travelled += FVector::Dist(Start, m_LastStart);
+	m_LastStart = Start;
+	if (m_Travelled > CVarSpiderContactDistanceBudget.GetValueOnGameThread())
+		return false;
+
+	const UPrimitiveComponent* Component{ m_Component.Get() };
+	if (Component == nullptr || !Component->GetComponentTransform().Equals(m_ComponentTransform))
+		return false;
+
+	// Ray has to come at the plane from the front
+	const FVector Ray{ End - Start };
+	const FVector& Normal{ m_HitResult.ImpactNormal };
+	const double Facing{ Ray.Dot(Normal) };
+	if (Facing >= 0.0)
+		return false;
+
+	const double Time{ (m_HitResult.ImpactPoint - Start).Dot(Normal) / Facing };
+	if (Time < 0.0 || Time > 1.0)
+		return false;
+
+	// Near an edge of the box the plane ends, let a real trace decide
+	const FVector Point{ Start + Ray * Time };
+	const float EdgeMargin{ CVarSpiderContactEdgeMargin.GetValueOnGameThread() };
+	FVector TangentA{};
+	FVector TangentB{};
+	Normal.FindBestAxisVectors(TangentA, TangentB);
+
+	const FBox Box{ m_Box.ExpandBy(1.0) };
+	const auto IsOnBox = [this, &Box](const FVector& Location) { return Box.IsInside(m_BoxTransform.InverseTransformPosition(Location)); };
+	if (!IsOnBox(Point + TangentA * EdgeMargin) || !IsOnBox(Point - TangentA * EdgeMargin)
+		|| !IsOnBox(Point + TangentB * EdgeMargin) || !IsOnBox(Point - TangentB * EdgeMargin))
+		return false;
+
+	OutHit = m_HitResult;
+	OutHit.Time = static_cast<float>(Time);
+	OutHit.Distance = static_cast<float>(Ray.Length() * Time);
+	OutHit.Location = Point;
+	OutHit.ImpactPoint = Point;
+	OutHit.TraceStart = Start;
+	OutHit.TraceEnd = End;
+	return true;
+}
+
+void FSpiderContactCache::Store(const FVector& Start, const FHitResult& HitResult, bool Cacheable)
+{
+	UPrimitiveComponent* Component{ HitResult.GetComponent() };
+	m_Valid = Cacheable && HitResult.bBlockingHit && Component != nullptr && Component->Mobility == EComponentMobility::Static
+		&& CVarSpiderContactCache.GetValueOnGameThread() && GetCollisionBox(*Component, m_BoxTransform, m_Box);
+	if (!m_Valid)
+		return;
+
+	m_HitResult = HitResult;
+	m_Component = Component;
+	m_ComponentTransform = Component->GetComponentTransform();
+	m_LastStart = Start;
+	m_Travelled = 0.f;
+}
+
+void FSpiderContactCache::Invalidate()
+{
+	m_Valid = false;
+	m_Component.Reset();
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+
+class UPrimitiveComponent;
+
+/**
+ * Remembers the plane under a spider so walking on flat static geometry doesn't need a down trace every step.
+ * Only primitives whose collision is a single box are cached, anything else can curve away from the plane.
+ * Rays are answered by intersecting the cached plane until the ray leaves the box,
+ * the primitive moves or the spider walked further than the distance budget since the last real trace.
+ */
+class SPIDERGAME_API FSpiderContactCache
+{
+public:
+	// Answers the ray from the cached plane, false when it needs a real trace
+	bool TryHit(const FVector& Start, const FVector& End, FHitResult& OutHit);
+	// Caches a real trace, Cacheable is false for surfaces that move on their own (webs)
+	void Store(const FVector& Start, const FHitResult& HitResult, bool Cacheable);
+	void Invalidate();
+
+private:
+	bool m_Valid{ false };
+	FHitResult m_HitResult{};
+	TWeakObjectPtr<UPrimitiveComponent> m_Component{};
+	FTransform m_ComponentTransform{};
+	// Collision box, local to m_BoxTransform
+	FTransform m_BoxTransform{};
+	FBox m_Box{};
+	FVector m_LastStart{};
+	float m_Travelled{};
+};
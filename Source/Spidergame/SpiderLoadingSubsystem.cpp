@@ -0,0 +1,362 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderLoadingSubsystem.h"
+
+#include "MoviePlayer.h"
+#include "SpiderPreloadData.h"
+#include "Engine/AssetManager.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/GameMapsSettings.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Styling/CoreStyle.h"
+#include "Widgets/Images/SThrobber.h"
+#include "Widgets/Layout/SBorder.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSpiderLoading, Log, All);
+
+static TAutoConsoleVariable<bool> CVarLoadingPreloadMap(
+	TEXT("Spider.Loading.PreloadMap"),
+	true,
+	TEXT("Also load the map package in the background before travelling, not just its preload bundles"));
+
+static TAutoConsoleVariable<float> CVarLoadingMinScreenTime(
+	TEXT("Spider.Loading.MinScreenTime"),
+	0.f,
+	TEXT("Seconds the loading screen stays up at least, so it doesn't flash on fast loads"));
+
+namespace
+{
+	const TCHAR* DEFAULT_BENCHMARK_MAP{ TEXT("/Game/Dynamic/Levels/TightTunnel") };
+
+	// Package paths work too, the asset name is the package's short name for maps
+	FSoftObjectPath ToLevelPath(const FString& Map)
+	{
+		if (Map.Contains(TEXT(".")))
+			return FSoftObjectPath{ Map };
+
+		return FSoftObjectPath{ Map + TEXT(".") + FPackageName::GetShortName(Map) };
+	}
+
+	FSoftObjectPath GetLevelPath(const UWorld* World)
+	{
+		const FString Package{ UWorld::RemovePIEPrefix(World->GetOutermost()->GetName()) };
+		return ToLevelPath(Package);
+	}
+}
+
+void USpiderLoadingSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddUObject(this, &USpiderLoadingSubsystem::ShowLoadingScreen);
+	m_PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &USpiderLoadingSubsystem::HandlePostLoadMap);
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("SpiderStartupBenchmark")))
+		StartBenchmark();
+}
+
+void USpiderLoadingSubsystem::Deinitialize()
+{
+	FCoreUObjectDelegates::PreLoadMap.Remove(m_PreLoadMapHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(m_PostLoadMapHandle);
+	FTSTicker::GetCoreTicker().RemoveTicker(m_BenchmarkTicker);
+
+	CancelPreload();
+	if (m_ResidentHandle.IsValid())
+		m_ResidentHandle->ReleaseHandle();
+	m_ResidentHandle.Reset();
+
+	Super::Deinitialize();
+}
+
+#pragma region Preload
+// ==============================================================================
+// Preload
+// ==============================================================================
+
+void USpiderLoadingSubsystem::PreloadLevel(TSoftObjectPtr<UWorld> Level)
+{
+	const FSoftObjectPath Path{ Level.ToSoftObjectPath() };
+	if (Path.IsNull() || Path == m_Level)
+		return;
+
+	CancelPreload();
+	m_Level = Path;
+	const uint32 PreloadId{ ++m_PreloadId };
+	m_PreloadStartTime = FPlatformTime::Seconds();
+	m_BundlesPending = true;
+
+	// PIE travels to a duplicate of the map, loading the real package would only waste memory
+	const UWorld* World{ GetGameInstance()->GetWorld() };
+	m_MapPending = CVarLoadingPreloadMap.GetValueOnGameThread() && !(World && World->IsPlayInEditor());
+	if (m_MapPending)
+	{
+		LoadPackageAsync(Path.GetLongPackageName(), FLoadPackageAsyncDelegate::CreateWeakLambda(this,
+			[this, PreloadId](const FName& PackageName, UPackage* Package, EAsyncLoadingResult::Type Result)
+			{
+				if (PreloadId != m_PreloadId)
+					return;
+
+				if (Result != EAsyncLoadingResult::Succeeded)
+					UE_LOG(LogSpiderLoading, Warning, TEXT("Could not preload %s, the travel will load it"), *PackageName.ToString());
+
+				m_MapPackage = Result == EAsyncLoadingResult::Succeeded ? Package : nullptr;
+				m_MapPending = false;
+				FinishPreloadPart(PreloadId);
+			}));
+	}
+
+	// The data assets are tiny, their bundles decide which ones are for this level
+	m_DataHandle = UAssetManager::Get().LoadPrimaryAssetsWithType(USpiderPreloadData::PRIMARY_ASSET_TYPE, {},
+		FStreamableDelegate::CreateUObject(this, &USpiderLoadingSubsystem::LoadBundles, PreloadId));
+	if (!m_DataHandle.IsValid() || m_DataHandle->HasLoadCompleted())
+		LoadBundles(PreloadId);
+}
+
+void USpiderLoadingSubsystem::OpenLevel(TSoftObjectPtr<UWorld> Level)
+{
+	PreloadLevel(Level);
+	if (IsPreloaded(Level))
+		Travel();
+	else
+		m_OpenWhenPreloaded = true;
+}
+
+bool USpiderLoadingSubsystem::IsPreloaded(TSoftObjectPtr<UWorld> Level) const
+{
+	return !m_Level.IsNull() && Level.ToSoftObjectPath() == m_Level && !m_BundlesPending && !m_MapPending;
+}
+
+float USpiderLoadingSubsystem::GetPreloadProgress() const
+{
+	if (m_Level.IsNull())
+		return 0.f;
+
+	float BundleProgress{ m_BundlesPending ? 0.f : 1.f };
+	if (m_BundlesPending && m_BundleHandle.IsValid())
+		BundleProgress = m_BundleHandle->GetProgress();
+
+	float MapProgress{ 1.f };
+	if (m_MapPending)
+		MapProgress = FMath::Max(GetAsyncLoadPercentage(*m_Level.GetLongPackageName()), 0.f) / 100.f;
+
+	return (BundleProgress + MapProgress) * 0.5f;
+}
+
+void USpiderLoadingSubsystem::LoadBundles(uint32 PreloadId)
+{
+	// The handle can call back after it already completed on the spot
+	if (PreloadId != m_PreloadId || !m_BundlesPending || m_BundleHandle.IsValid())
+		return;
+
+	UAssetManager& Manager{ UAssetManager::Get() };
+	TArray<FPrimaryAssetId> AllIds{};
+	Manager.GetPrimaryAssetIdList(USpiderPreloadData::PRIMARY_ASSET_TYPE, AllIds);
+
+	TArray<FPrimaryAssetId> LevelIds{};
+	for (const FPrimaryAssetId& Id : AllIds)
+	{
+		const USpiderPreloadData* Data{ Manager.GetPrimaryAssetObject<USpiderPreloadData>(Id) };
+		if (Data && Data->IsForLevel(m_Level))
+			LevelIds.Add(Id);
+	}
+
+	m_BundleHandle = Manager.LoadPrimaryAssets(LevelIds, { USpiderPreloadData::GAME_BUNDLE }, FStreamableDelegate::CreateWeakLambda(this, [this, PreloadId]()
+	{
+		if (PreloadId != m_PreloadId || !m_BundlesPending)
+			return;
+
+		m_BundlesPending = false;
+		FinishPreloadPart(PreloadId);
+	}));
+
+	// Nothing to load, or all of it was already in memory
+	if (!m_BundleHandle.IsValid() || m_BundleHandle->HasLoadCompleted())
+	{
+		m_BundlesPending = false;
+		FinishPreloadPart(PreloadId);
+	}
+}
+
+void USpiderLoadingSubsystem::FinishPreloadPart(uint32 PreloadId)
+{
+	if (PreloadId != m_PreloadId || m_BundlesPending || m_MapPending)
+		return;
+
+	m_PreloadTime = FPlatformTime::Seconds() - m_PreloadStartTime;
+	UE_LOG(LogSpiderLoading, Display, TEXT("Preloaded %s in %.2f s"), *m_Level.GetLongPackageName(), m_PreloadTime);
+
+	OnPreloadComplete.Broadcast();
+
+	if (m_OpenWhenPreloaded)
+		Travel();
+}
+
+void USpiderLoadingSubsystem::CancelPreload()
+{
+	++m_PreloadId;
+	if (m_BundleHandle.IsValid())
+		m_BundleHandle->CancelHandle();
+
+	m_BundleHandle.Reset();
+	m_DataHandle.Reset();
+	m_MapPackage = nullptr;
+	m_BundlesPending = false;
+	m_MapPending = false;
+	m_OpenWhenPreloaded = false;
+	m_Level.Reset();
+}
+
+void USpiderLoadingSubsystem::Travel()
+{
+	m_OpenWhenPreloaded = false;
+	m_TravelStartTime = FPlatformTime::Seconds();
+	UGameplayStatics::OpenLevelBySoftObjectPtr(GetGameInstance(), TSoftObjectPtr<UWorld>{ m_Level });
+}
+
+#pragma endregion Preload
+
+#pragma region Travel
+// ==============================================================================
+// Travel
+// ==============================================================================
+
+void USpiderLoadingSubsystem::ShowLoadingScreen(const FString& MapName)
+{
+	if (IsRunningDedicatedServer() || !IsMoviePlayerEnabled())
+		return;
+
+	// Slate only, a UMG widget would tick its Blueprint on the loading thread
+	FLoadingScreenAttributes Attributes{};
+	Attributes.bAutoCompleteWhenLoadingCompletes = true;
+	Attributes.MinimumLoadingScreenDisplayTime = CVarLoadingMinScreenTime.GetValueOnGameThread();
+	Attributes.WidgetLoadingScreen = SNew(SBorder)
+		.BorderImage(FCoreStyle::Get().GetBrush(TEXT("BlackBrush")))
+		.HAlign(HAlign_Right)
+		.VAlign(VAlign_Bottom)
+		.Padding(48.f)
+		[
+			SNew(SThrobber)
+		];
+
+	GetMoviePlayer()->SetupLoadingScreen(Attributes);
+}
+
+void USpiderLoadingSubsystem::HandlePostLoadMap(UWorld* World)
+{
+	if (World == nullptr || World->GetGameInstance() != GetGameInstance())
+		return;
+
+	// What the last level needed can go, unless this is the same level again
+	if (m_ResidentHandle.IsValid())
+		m_ResidentHandle->ReleaseHandle();
+	m_ResidentHandle.Reset();
+
+	const FSoftObjectPath Level{ GetLevelPath(World) };
+	if (!m_Level.IsNull() && Level == m_Level)
+	{
+		m_TravelTime = FPlatformTime::Seconds() - m_TravelStartTime;
+		UE_LOG(LogSpiderLoading, Display, TEXT("Loaded %s in %.2f s after travelling"), *m_Level.GetLongPackageName(), m_TravelTime);
+
+		// The map is loaded for real now, its bundles stay until the next level
+		m_ResidentHandle = m_BundleHandle;
+		m_BundleHandle.Reset();
+		m_DataHandle.Reset();
+		m_MapPackage = nullptr;
+		m_Level.Reset();
+	}
+
+	// Back in the menu, get the next level going while the player looks at it
+	if (m_BenchmarkStage == EBenchmarkStage::Off && Level == ToLevelPath(UGameMapsSettings::GetGameDefaultMap()))
+		PreloadLevel(MenuPreloadLevel);
+
+	switch (m_BenchmarkStage)
+	{
+	case EBenchmarkStage::Menu:
+		m_MenuTime = FPlatformTime::Seconds() - GStartTime;
+		m_BenchmarkStage = EBenchmarkStage::Loading;
+		OpenLevel(TSoftObjectPtr<UWorld>{ m_BenchmarkLevel });
+		break;
+	case EBenchmarkStage::Loading:
+		if (Level == m_BenchmarkLevel)
+			m_BenchmarkStage = EBenchmarkStage::WaitingForPawn;
+		break;
+	default:
+		break;
+	}
+}
+
+#pragma endregion Travel
+
+#pragma region Benchmark
+// ==============================================================================
+// Benchmark
+// ==============================================================================
+
+void USpiderLoadingSubsystem::StartBenchmark()
+{
+	FString Map{ DEFAULT_BENCHMARK_MAP };
+	FParse::Value(FCommandLine::Get(), TEXT("StartupMap="), Map);
+	m_BenchmarkLevel = ToLevelPath(Map);
+
+	m_BenchmarkOutput = FPaths::ProfilingDir() / TEXT("SpiderStartup") / FString::Printf(TEXT("SpiderStartup-%s.csv"), *FDateTime::Now().ToString());
+	FParse::Value(FCommandLine::Get(), TEXT("Output="), m_BenchmarkOutput);
+
+	m_BenchmarkStage = EBenchmarkStage::Menu;
+	m_BenchmarkTicker = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &USpiderLoadingSubsystem::TickBenchmark));
+
+	UE_LOG(LogSpiderLoading, Display, TEXT("Startup benchmark to %s"), *m_BenchmarkLevel.ToString());
+}
+
+bool USpiderLoadingSubsystem::TickBenchmark(float DeltaTime)
+{
+	const double Now{ FPlatformTime::Seconds() - GStartTime };
+	if (Now > BENCHMARK_TIMEOUT)
+	{
+		FinishBenchmark(false, Now);
+		return false;
+	}
+
+	if (m_BenchmarkStage != EBenchmarkStage::WaitingForPawn)
+		return true;
+
+	// Playable once the level runs and the player has a spider to steer
+	const UWorld* World{ GetGameInstance()->GetWorld() };
+	const APlayerController* Controller{ GetGameInstance()->GetFirstLocalPlayerController(World) };
+	if (World == nullptr || !World->HasBegunPlay() || Controller == nullptr || Controller->GetPawn() == nullptr)
+		return true;
+
+	FinishBenchmark(true, Now);
+	return false;
+}
+
+void USpiderLoadingSubsystem::FinishBenchmark(bool Success, double FirstPlayableTime)
+{
+	m_BenchmarkStage = EBenchmarkStage::Done;
+	m_BenchmarkTicker.Reset();
+
+	if (Success)
+	{
+		UE_LOG(LogSpiderLoading, Display, TEXT("First playable frame of %s after %.2f s (menu %.2f s, preload %.2f s, travel %.2f s)"),
+			*m_BenchmarkLevel.GetLongPackageName(), FirstPlayableTime, m_MenuTime, m_PreloadTime, m_TravelTime);
+	}
+	else
+	{
+		UE_LOG(LogSpiderLoading, Error, TEXT("No playable frame of %s after %.0f s"), *m_BenchmarkLevel.GetLongPackageName(), FirstPlayableTime);
+	}
+
+	const FString Csv{ FString::Printf(TEXT("Map,Success,MenuSeconds,PreloadSeconds,TravelSeconds,FirstPlayableSeconds\n%s,%d,%.3f,%.3f,%.3f,%.3f\n"),
+		*m_BenchmarkLevel.GetLongPackageName(), Success ? 1 : 0, m_MenuTime, m_PreloadTime, m_TravelTime, FirstPlayableTime) };
+	if (FFileHelper::SaveStringToFile(Csv, *m_BenchmarkOutput))
+		UE_LOG(LogSpiderLoading, Display, TEXT("Wrote %s"), *m_BenchmarkOutput);
+	else
+		UE_LOG(LogSpiderLoading, Error, TEXT("Could not write %s"), *m_BenchmarkOutput);
+
+	FPlatformMisc::RequestExitWithStatus(false, Success ? 0 : 1);
+}
+
+#pragma endregion Benchmark
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "Containers/Ticker.h"
+#include "SpiderLoadingSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FSpiderPreloadCompleteSignature);
+
+/**
+ * Menu to gameplay transitions without the stall.
+ * PreloadLevel starts streaming the SpiderPreload bundles for a level and the map package itself while the menu is up,
+ * OpenLevel travels once that is done. The blocking part of the travel runs behind a MoviePlayer loading screen,
+ * which draws on its own thread. Preloaded assets stay resident until the next level is loaded.
+ * The menu level (GameDefaultMap) preloads MenuPreloadLevel on its own, so the menu's plain OpenLevel finds it in memory.
+ *
+ * -SpiderStartupBenchmark runs boot, menu, preload and travel without input and logs time to the first playable frame:
+ * UnrealEditor-Cmd Spidergame.uproject -game -nullrhi -unattended -SpiderStartupBenchmark [-StartupMap=/Game/Dynamic/Levels/TightTunnel] [-Output=Path.csv]
+ */
+UCLASS(Config=Game)
+class SPIDERGAME_API USpiderLoadingSubsystem : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Level the main menu leads to, preloaded as soon as the menu is up
+	UPROPERTY(Config, EditAnywhere, Category="Loading")
+	TSoftObjectPtr<UWorld> MenuPreloadLevel{};
+
+	// Safe to call again for the same level, a different level cancels the previous preload
+	UFUNCTION(BlueprintCallable, Category="Loading")
+	void PreloadLevel(TSoftObjectPtr<UWorld> Level);
+	// Preloads first if that hasn't been done, travels once everything is in memory
+	UFUNCTION(BlueprintCallable, Category="Loading")
+	void OpenLevel(TSoftObjectPtr<UWorld> Level);
+
+	UFUNCTION(BlueprintPure, Category="Loading")
+	bool IsPreloaded(TSoftObjectPtr<UWorld> Level) const;
+	// 0 to 1, for a progress bar in the menu
+	UFUNCTION(BlueprintPure, Category="Loading")
+	float GetPreloadProgress() const;
+
+	UPROPERTY(BlueprintAssignable, Category="Loading")
+	FSpiderPreloadCompleteSignature OnPreloadComplete{};
+
+private:
+	enum class EBenchmarkStage : uint8
+	{
+		Off,
+		Menu,
+		Loading,
+		WaitingForPawn,
+		Done
+	};
+
+	static constexpr double BENCHMARK_TIMEOUT{ 300.0 };
+
+	FSoftObjectPath m_Level{};
+	// First the data assets, then their Game bundles
+	TSharedPtr<FStreamableHandle> m_DataHandle{};
+	TSharedPtr<FStreamableHandle> m_BundleHandle{};
+	// Keeps the loaded map package from being collected before the travel picks it up
+	UPROPERTY(Transient)
+	TObjectPtr<UPackage> m_MapPackage{};
+	bool m_MapPending{ false };
+	bool m_BundlesPending{ false };
+	bool m_OpenWhenPreloaded{ false };
+	// Bumped by every new preload so callbacks for older ones are ignored
+	uint32 m_PreloadId{};
+
+	// Bundles of the level that is playing, released when the next one is loaded
+	TSharedPtr<FStreamableHandle> m_ResidentHandle{};
+
+	FDelegateHandle m_PreLoadMapHandle{};
+	FDelegateHandle m_PostLoadMapHandle{};
+
+	EBenchmarkStage m_BenchmarkStage{ EBenchmarkStage::Off };
+	FSoftObjectPath m_BenchmarkLevel{};
+	FString m_BenchmarkOutput{};
+	double m_MenuTime{};
+	double m_PreloadStartTime{};
+	double m_PreloadTime{};
+	double m_TravelStartTime{};
+	double m_TravelTime{};
+	FTSTicker::FDelegateHandle m_BenchmarkTicker{};
+
+	void LoadBundles(uint32 PreloadId);
+	void FinishPreloadPart(uint32 PreloadId);
+	void CancelPreload();
+	void Travel();
+
+	void ShowLoadingScreen(const FString& MapName);
+	void HandlePostLoadMap(UWorld* World);
+
+	void StartBenchmark();
+	bool TickBenchmark(float DeltaTime);
+	void FinishBenchmark(bool Success, double FirstPlayableTime);
+};
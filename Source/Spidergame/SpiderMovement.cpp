@@ -0,0 +1,849 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderMovement.h"
+
+#include "SpiderStats.h"
+
+static FSpiderStateTimings* GSpiderStateTimings{ nullptr };
+
+void FSpiderStateTimings::Reset()
+{
+	*this = {};
+}
+
+void FSpiderMovement::Step(float DeltaTime, const FSpiderMovementInput& Input, ISpiderMovementWorld& World)
+{
+	// Fresh probes before the jump, its ground check must not see where the spider stood last step
+	BeginStep(Input);
+
+	// Part of the input so a replayed step jumps exactly where the original did
+	if (Input.JumpPower > 0.f)
+		Jump(Input.JumpPower, World);
+
+	if (Integrate(DeltaTime, Input))
+	{
+		FinishIntegrate(DeltaTime, World);
+		return;
+	}
+
+	// Time is booked on the state the step started in
+	const ESpiderState StepState{ m_Sim.State };
+	const uint64 StartCycles{ GSpiderStateTimings ? FPlatformTime::Cycles64() : 0 };
+
+	switch (m_Sim.State)
+	{
+	case ESpiderState::Ground:
+		Grounded(DeltaTime, World);
+		break;
+	case ESpiderState::Transition:
+		Transition(DeltaTime, World);
+		break;
+	case ESpiderState::Fall:
+		Falling(DeltaTime, World);
+		break;
+	case ESpiderState::OnWeb:
+		OnWeb(DeltaTime, World);
+		break;
+	case ESpiderState::Jumping:
+		Jumping(DeltaTime);
+		break;
+	default:
+		Falling(DeltaTime, World);
+		break;
+	}
+
+	EndStep(DeltaTime, StepState, GSpiderStateTimings ? FPlatformTime::Cycles64() - StartCycles : 0, World);
+}
+
+bool FSpiderMovement::Integrate(float DeltaTime, const FSpiderMovementInput& Input)
+{
+	// Mid lerp and jumps only move the body, anything that could land or stick needs the world.
+	// A jump running out only turns into a fall, the sweep in FinishIntegrate takes it from there
+	const bool Lerping{ m_Sim.State == ESpiderState::Transition && IsTransitioning() };
+	const bool Jumped{ m_Sim.State == ESpiderState::Jumping };
+	if (Input.JumpPower > 0.f)
+		return false;
+
+	// Falls still sweep on the game thread, only along velocities that are already known
+	if (m_Sim.State == ESpiderState::Fall && !m_FallPlanned)
+		PlanFall(DeltaTime);
+
+	if (!Lerping && !Jumped)
+		return false;
+
+	BeginStep(Input);
+	m_IntegratedState = m_Sim.State;
+	const uint64 StartCycles{ GSpiderStateTimings ? FPlatformTime::Cycles64() : 0 };
+
+	if (Lerping)
+		LerpTransition(DeltaTime);
+	else
+		Jumping(DeltaTime);
+
+	m_IntegratedCycles = GSpiderStateTimings ? FPlatformTime::Cycles64() - StartCycles : 0;
+	return true;
+}
+
+void FSpiderMovement::FinishIntegrate(float DeltaTime, ISpiderMovementWorld& World)
+{
+	if (m_Sim.State == ESpiderState::Transition)
+		World.StopWalkSound();
+
+	EndStep(DeltaTime, m_IntegratedState, m_IntegratedCycles, World);
+}
+
+void FSpiderMovement::BeginStep(const FSpiderMovementInput& Input)
+{
+	m_Input = Input;
+	m_DownProbed = false;
+	m_ForwardProbed = false;
+	m_Placed = false;
+}
+
+void FSpiderMovement::EndStep(float DeltaTime, ESpiderState StepState, uint64 Cycles, ISpiderMovementWorld& World)
+{
+	// Planned for this step only, a wall or a jump may have left it unused
+	m_FallPlanned = false;
+
+	// Anything but riding a strand lets go of it
+	if (m_Sim.State != ESpiderState::OnWeb)
+	{
+		m_Sim.WebAttached = false;
+		m_IdleAtEnd = false;
+	}
+	if (!m_Placed)
+		m_Sim.Location = World.Sweep(m_Sim.Location, m_Sim.Velocity * DeltaTime, m_Sim.SurfaceRotation);
+
+	if (m_Sim.State != StepState)
+		BookStateChange(StepState);
+
+	if (GSpiderStateTimings)
+	{
+		const int32 StateIndex{ static_cast<int32>(StepState) };
+		GSpiderStateTimings->Cycles[StateIndex] += Cycles;
+		++GSpiderStateTimings->Steps[StateIndex];
+	}
+}
+
+bool FSpiderMovement::Jump(float JumpPower, ISpiderMovementWorld& World)
+{
+	if (!CheckGrounded(World))
+		return false;
+
+	FVector& Velocity{ m_Sim.Velocity };
+
+	// Jump more forward if moving forward
+	if (Velocity.SquaredLength() != 0)
+		Velocity.Normalize();
+
+	Velocity += GetUpVector();
+	Velocity.Normalize();
+	Velocity *= JumpPower;
+
+	m_Sim.JumpImmuneTimer = Params.JumpImmuneTime;
+
+	World.StopAllSounds();
+	const ESpiderState OldState{ m_Sim.State };
+	m_Sim.State = ESpiderState::Jumping;
+	if (OldState != m_Sim.State)
+		BookStateChange(OldState);
+	return true;
+}
+
+void FSpiderMovement::SetClosestWeb(const FVector& Start, const FVector& End, int32 Strand)
+{
+	m_Sim.StartLinePoint = Start;
+	m_Sim.EndLinePoint = End;
+	m_Sim.WebStrand = Strand;
+	m_Sim.WebAttached = false;
+}
+
+const FSpiderSimState& FSpiderMovement::GetSimState() const
+{
+	return m_Sim;
+}
+
+void FSpiderMovement::SetSimState(const FSpiderSimState& SimState)
+{
+	m_Sim = SimState;
+	m_FallPlanned = false;
+}
+
+void FSpiderMovement::Teleport(const FVector& Location, const FQuat& SurfaceRotation)
+{
+	m_Sim.Location = Location;
+	m_Sim.SurfaceRotation = SurfaceRotation;
+}
+
+void FSpiderMovement::BookStateChange(ESpiderState OldState) const
+{
+	INC_DWORD_STAT(STAT_SpiderStateChanges);
+	CSV_CUSTOM_STAT(Spider, StateChanges, 1, ECsvCustomStatOp::Accumulate);
+	TRACE_SPIDER_STATE_CHANGE(TraceId, OldState, m_Sim.State);
+}
+
+void FSpiderMovement::SetTimingSink(FSpiderStateTimings* Sink)
+{
+	GSpiderStateTimings = Sink;
+}
+
+#pragma region States
+// ==============================================================================
+// States
+// ==============================================================================
+
+void FSpiderMovement::Transition(float DeltaTime, ISpiderMovementWorld& World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderTransition);
+
+	World.StopWalkSound();
+	m_Sim.Velocity = {};
+
+	if (!IsTransitioning())
+	{
+		m_Sim.State = IsOnWeb(World) ? ESpiderState::OnWeb : ESpiderState::Ground;
+		StickToSurface();
+		return;
+	}
+
+	LerpTransition(DeltaTime);
+}
+
+void FSpiderMovement::LerpTransition(float DeltaTime)
+{
+	m_Sim.Velocity = {};
+	TransitionSurfaces(DeltaTime);
+
+	m_Sim.OldState = ESpiderState::Transition;
+}
+
+void FSpiderMovement::Grounded(float DeltaTime, ISpiderMovementWorld& World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderGround);
+
+	// Reset velocity later, used in state switching checking
+	CheckGrounded(World);
+	CheckWall(World);
+
+	// Different ground check
+	if (ChangedGround())
+	{
+		SetTransition(m_DownHitResult);
+		m_Sim.State = ESpiderState::Transition;
+		m_Sim.Velocity = {};
+		World.StopAllSounds();
+		return;
+	}
+
+	if (HitWall() && IsMoving())
+	{
+		SetTransition(m_ForwardHitResult);
+		m_Sim.State = ESpiderState::Transition;
+		m_Sim.Velocity = {};
+		World.StopAllSounds();
+		return;
+	}
+
+	if (!IsGrounded())
+	{
+		m_Sim.State = ESpiderState::Fall;
+		m_Sim.Velocity = {};
+		World.StopAllSounds();
+		return;
+	}
+
+	m_Sim.Velocity = {};
+
+	// Turn body
+	RotateBody();
+
+	HandleMove(GetForwardVector());
+	if (IsMoving())
+	{
+		StickToSurface();
+
+		// The body moved, the probes from before are stale for the web check
+		const bool Changed{ ChangedGround() };
+		m_DownProbed = false;
+		m_ForwardProbed = false;
+		if (Changed && IsOnWeb(World))
+		{
+			m_Sim.State = ESpiderState::OnWeb;
+			m_Sim.Velocity = {};
+			return;
+		}
+	}
+
+	// Play web walking sound if on a big web
+	World.PlayWalkSound(World.IsWeb(m_DownHitResult), m_Sim.Velocity.SquaredLength() > 0);
+
+	m_Sim.OldState = ESpiderState::Ground;
+}
+
+void FSpiderMovement::OnWeb(float DeltaTime, ISpiderMovementWorld& World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderOnWeb);
+
+	m_Sim.Velocity = {};
+
+	// Strands swing and snap, follow the one we're on and drop with it once a break cuts it off from the level
+	if (m_Sim.WebStrand != INDEX_NONE
+		&& (!World.GetWebStrand(m_Sim.WebStrand, m_Sim.StartLinePoint, m_Sim.EndLinePoint) || World.IsWebStrandDetached(m_Sim.WebStrand)))
+	{
+		m_Sim.WebStrand = INDEX_NONE;
+		m_Sim.State = ESpiderState::Fall;
+		World.StopAllSounds();
+		return;
+	}
+
+	// Lines set from Blueprint without a registered strand can't be followed, only a probe tells whether they're still there
+	if (m_Sim.WebStrand == INDEX_NONE && !CheckGrounded(World))
+	{
+		m_Sim.State = ESpiderState::Fall;
+		World.StopAllSounds();
+		return;
+	}
+
+	if (!m_Sim.WebAttached)
+		AttachToStrand();
+
+	RotateBody();
+
+	// Move on web back and forth based on looking direction, along the strand without any traces
+	FVector Direction{ (m_Sim.EndLinePoint - m_Sim.StartLinePoint).GetSafeNormal() };
+	const double Sign{ FMath::Sign(GetForwardVector().Dot(Direction)) };
+	const double Speed{ Sign * m_Input.Forward * Params.MovementSpeed };
+	double Distance{ m_Sim.WebDistance + Speed * DeltaTime };
+
+	// Only the ends of a strand need the collision system
+	bool ReachedEnd{ false };
+	for (int32 Junction{}; Distance < 0.0 || Distance > FVector::Dist(m_Sim.StartLinePoint, m_Sim.EndLinePoint); ++Junction)
+	{
+		if (Junction == MAX_JUNCTIONS_PER_STEP || !CrossJunction(Distance, World))
+		{
+			Distance = FMath::Clamp(Distance, 0.0, FVector::Dist(m_Sim.StartLinePoint, m_Sim.EndLinePoint));
+			ReachedEnd = true;
+			break;
+		}
+	}
+
+	Direction = (m_Sim.EndLinePoint - m_Sim.StartLinePoint).GetSafeNormal();
+	m_Sim.WebDistance = static_cast<float>(Distance);
+	m_Sim.Location = m_Sim.StartLinePoint + Direction * Distance + m_Sim.WebOffset;
+	m_Sim.Velocity = Direction * Speed;
+	m_Placed = true;
+
+	m_IdleAtEnd = m_IdleAtEnd && ReachedEnd;
+	if (ReachedEnd)
+	{
+		ReachStrandEnd(World);
+		if (m_Sim.State != ESpiderState::OnWeb)
+			return;
+	}
+
+	World.PlayWalkSound(true, m_Sim.Velocity.SquaredLength() > 0);
+
+	m_Sim.OldState = ESpiderState::OnWeb;
+}
+
+void FSpiderMovement::Falling(float DeltaTime, ISpiderMovementWorld& World)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderFall);
+
+	World.StopWalkSound();
+
+	if (CheckWall(World))
+	{
+		SetTransition(m_ForwardHitResult);
+		m_Sim.State = ESpiderState::Transition;
+		m_Sim.Velocity = {};
+		World.PlayLandingSound();
+		return;
+	}
+
+	if (SweepFall(DeltaTime, World))
+	{
+		m_Sim.Velocity = {};
+		if(ChangedGround())
+		{
+			SetTransition(m_DownHitResult);
+			m_Sim.State = ESpiderState::Transition;
+		}
+		else
+		{
+			StickToSurface();
+			m_Sim.State = ESpiderState::Ground;
+		}
+
+		World.PlayLandingSound();
+		return;
+	}
+
+	RotateToWorld(DeltaTime);
+
+	// Standard falling, gravity and drag were applied while sweeping
+	RotateBody();
+
+	m_Sim.OldState = ESpiderState::Fall;
+}
+
+void FSpiderMovement::Jumping(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderJumping);
+
+	m_Sim.JumpImmuneTimer -= DeltaTime;
+	if (m_Sim.JumpImmuneTimer < 0)
+	{
+		m_Sim.State = ESpiderState::Fall;
+		return;
+	}
+	RotateToWorld(DeltaTime);
+
+	// Standard falling
+	RotateBody();
+
+	ApplyGravity(DeltaTime);
+	ApplyDrag(DeltaTime);
+
+	m_Sim.OldState = ESpiderState::Jumping;
+}
+
+#pragma endregion States
+
+#pragma region Controls
+// ==============================================================================
+// Controls
+// ==============================================================================
+
+void FSpiderMovement::RotateBody()
+{
+	m_Sim.BodyYaw = m_Input.BodyYaw;
+}
+
+void FSpiderMovement::HandleMove(const FVector& Direction)
+{
+	const double Length{ m_Input.Forward * Params.MovementSpeed };
+
+	m_Sim.Velocity += Direction * Length;
+}
+
+#pragma endregion Controls
+
+#pragma region Physics
+// ==============================================================================
+// Physics
+// ==============================================================================
+
+void FSpiderMovement::ApplyGravity(float DeltaTime)
+{
+	m_Sim.Velocity.Z -= Params.Gravity * DeltaTime;
+}
+
+void FSpiderMovement::ApplyDrag(float DeltaTime)
+{
+	m_Sim.Velocity -= m_Sim.Velocity * Params.Drag * DeltaTime;
+}
+
+void FSpiderMovement::PlanFall(float DeltaTime)
+{
+	// Fast falls are cut into more pieces, about one capsule radius each
+	const double Travel{ m_Sim.Velocity.Length() * DeltaTime };
+	const int32 Substeps{ FMath::Clamp(FMath::CeilToInt32(Travel / FMath::Max(Params.CapsuleRadius, 1.f)), 1, FMath::Max(Params.MaxFallSubsteps, 1)) };
+	m_FallSubstepTime = DeltaTime / Substeps;
+
+	// Same gravity and drag as applying them substep by substep, the body's velocity is put back after
+	const FVector Velocity{ m_Sim.Velocity };
+	m_FallVelocities.Reset(Substeps);
+	for (int32 Substep{}; Substep < Substeps; ++Substep)
+	{
+		ApplyGravity(m_FallSubstepTime);
+		ApplyDrag(m_FallSubstepTime);
+		m_FallVelocities.Add(m_Sim.Velocity);
+	}
+	m_Sim.Velocity = Velocity;
+	m_FallPlanned = true;
+}
+#pragma endregion Physics
+
+#pragma region SurfaceSticking
+// ==============================================================================
+// Surface sticking
+// ==============================================================================
+
+void FSpiderMovement::SetTransition(const FHitResult& HitResult)
+{
+	CalcSurfaceStickPoint(HitResult);
+	CalcLerpRatio();
+	m_Sim.LerpTimer = 0.f;
+}
+
+void FSpiderMovement::TransitionSurfaces(float DeltaTime)
+{
+	// Ratio to get the correct Lerp values
+	// Allows player to stop the lerp themselves
+	const double LerpStep{ m_Sim.LerpRatio * DeltaTime / Params.WallInterpolateTime };
+
+	m_Sim.LerpTimer += LerpStep;
+
+	m_Sim.Location += m_Sim.StickPosition * LerpStep;
+	m_Sim.SurfaceRotation = FQuat{ m_Sim.StickRotation * LerpStep } * m_Sim.SurfaceRotation;
+}
+
+void FSpiderMovement::CalcSurfaceStickPoint(const FHitResult& HitResult)
+{
+	// Size needs to be increased to position the player just above ground
+	constexpr float SizeScalar{ 1.05f };
+	const float Size { Params.CapsuleRadius * SizeScalar };
+
+	// Already lined up with the surface on flat ground, skip the rotation
+	const FVector Up{ GetUpVector() };
+	m_Sim.StickRotation = Up.Equals(HitResult.ImpactNormal, UE_KINDA_SMALL_NUMBER) ? FRotator::ZeroRotator : FQuat::FindBetweenVectors(Up, HitResult.ImpactNormal).Rotator();
+	m_Sim.StickPosition = (HitResult.Location + HitResult.ImpactNormal * Size) - m_Sim.Location;
+}
+
+void FSpiderMovement::CalcLerpRatio()
+{
+	// Change the lerp ratio to slow it down if the angle is too big
+	// Avoid player nausea + snappy
+	constexpr float CustomRatioThreshold{ 90.f };
+	const double Angle{ FMath::Acos(GetUpVector().Dot(m_ForwardHitResult.ImpactNormal)) };
+
+	if (Angle < CustomRatioThreshold)
+		m_Sim.LerpRatio = 1.f / Params.WallInterpolateTime;
+	else
+		m_Sim.LerpRatio = 1.f / (Params.WallInterpolateTime * (CustomRatioThreshold / Angle) * Params.LargeLerpCompensation); // Slows down lerps if an angle is too big
+}
+
+void FSpiderMovement::StickToSurface()
+{
+	CalcSurfaceStickPoint(m_DownHitResult);
+	m_Sim.Location += m_Sim.StickPosition;
+	if (!m_Sim.StickRotation.IsZero())
+		m_Sim.SurfaceRotation = FQuat{ m_Sim.StickRotation } * m_Sim.SurfaceRotation;
+}
+
+void FSpiderMovement::RotateToWorld(float DeltaTime)
+{
+	if (FellOffWall())
+	{
+		m_Sim.StickRotation = FQuat::FindBetweenVectors(GetUpVector(), FVector::UnitZ()).Rotator();
+		m_Sim.StickPosition = {};
+		m_Sim.LerpTimer = 0.f;
+		m_Sim.LerpRatio = 1.f;
+	}
+	if (IsTransitioning())
+		TransitionSurfaces(DeltaTime);
+}
+#pragma endregion SurfaceSticking
+
+#pragma region WebStrands
+// ==============================================================================
+// Web strands
+// ==============================================================================
+
+void FSpiderMovement::AttachToStrand()
+{
+	// Keep the body where it is relative to the strand, only the distance along it changes from here on
+	const FVector Line{ m_Sim.EndLinePoint - m_Sim.StartLinePoint };
+	const double Length{ Line.Length() };
+	const FVector Direction{ Length > UE_KINDA_SMALL_NUMBER ? Line / Length : FVector::ZeroVector };
+	const double Distance{ FMath::Clamp((m_Sim.Location - m_Sim.StartLinePoint).Dot(Direction), 0.0, Length) };
+
+	m_Sim.WebDistance = static_cast<float>(Distance);
+	m_Sim.WebOffset = m_Sim.Location - (m_Sim.StartLinePoint + Direction * Distance);
+	m_Sim.WebAttached = true;
+}
+
+bool FSpiderMovement::CrossJunction(double& Distance, ISpiderMovementWorld& World)
+{
+	if (m_Sim.WebStrand == INDEX_NONE)
+		return false;
+
+	const double Length{ FVector::Dist(m_Sim.StartLinePoint, m_Sim.EndLinePoint) };
+	const bool PastEnd{ Distance > Length };
+	const FVector Point{ PastEnd ? m_Sim.EndLinePoint : m_Sim.StartLinePoint };
+	const FVector Heading{ (PastEnd ? m_Sim.EndLinePoint - m_Sim.StartLinePoint : m_Sim.StartLinePoint - m_Sim.EndLinePoint).GetSafeNormal() };
+
+	const int32 Next{ World.FindWebJunction(m_Sim.WebStrand, Point, Heading) };
+	FVector NextStart{};
+	FVector NextEnd{};
+	if (Next == INDEX_NONE || !World.GetWebStrand(Next, NextStart, NextEnd))
+		return false;
+
+	// Carry what is left of the step onto the next strand, from whichever of its ends is at the junction
+	const double Leftover{ PastEnd ? Distance - Length : -Distance };
+	const bool FromStart{ FVector::DistSquared(Point, NextStart) <= FVector::DistSquared(Point, NextEnd) };
+	Distance = FromStart ? Leftover : FVector::Dist(NextStart, NextEnd) - Leftover;
+
+	m_Sim.WebStrand = Next;
+	m_Sim.StartLinePoint = NextStart;
+	m_Sim.EndLinePoint = NextEnd;
+	return true;
+}
+
+void FSpiderMovement::ReachStrandEnd(ISpiderMovementWorld& World)
+{
+	// Still pushing against the same end, nothing was there last step either
+	const FQuat Rotation{ GetBodyRotation() };
+	if (m_IdleAtEnd && m_Sim.Location.Equals(m_IdleEndLocation, 1.0) && Rotation.Equals(m_IdleEndRotation))
+	{
+		m_Sim.Velocity = {};
+		return;
+	}
+
+	// Loose end or anchor, see whether there is something to climb onto
+	CheckWall(World);
+	CheckGrounded(World);
+
+	if (HitWall() && IsMoving())
+	{
+		SetTransition(m_ForwardHitResult);
+		m_Sim.State = ESpiderState::Transition;
+		m_Sim.Velocity = {};
+		World.StopAllSounds();
+		return;
+	}
+
+	if (IsGrounded() && !World.IsWebLine(m_DownHitResult))
+	{
+		SetTransition(m_DownHitResult);
+		m_Sim.State = ESpiderState::Transition;
+		m_Sim.Velocity = {};
+		World.StopAllSounds();
+		return;
+	}
+
+	// Nowhere to go, wait at the end
+	m_Sim.Velocity = {};
+	m_IdleAtEnd = true;
+	m_IdleEndLocation = m_Sim.Location;
+	m_IdleEndRotation = Rotation;
+}
+#pragma endregion WebStrands
+
+#pragma region HitDetection
+// ==============================================================================
+// Hit detection
+// ==============================================================================
+
+bool FSpiderMovement::CheckGrounded(ISpiderMovementWorld& World)
+{
+	// Already traced this step
+	if (m_DownProbed)
+		return IsGrounded();
+
+	// Trace downwards checking for anything
+	const FVector Start{ m_Sim.Location };
+	const FVector End{ Start - GetUpVector() * RAYCAST_LENGTH };
+
+	// Raycast
+	World.Probe(ESpiderProbe::Down, Start, End, m_DownHitResult);
+	m_DownProbed = true;
+
+	return IsGrounded();
+}
+
+bool FSpiderMovement::CheckWall(ISpiderMovementWorld& World)
+{
+	// Raycast with forward hit result instead of temp (HitWall uses forward hit result)
+	FHitResult Temp{};
+
+	// Already traced this step, m_ForwardHitResult only survives if it hit a wall
+	if (m_ForwardProbed)
+		return HitWall();
+
+	// Trace forward checking for obstacls
+	const FVector Start{ m_Sim.Location };
+	const FVector End{ Start + GetForwardVector() * RAYCAST_LENGTH };
+
+	// Raycast
+	World.Probe(ESpiderProbe::Forward, Start, End, m_ForwardHitResult);
+	m_ForwardProbed = true;
+
+	if (HitWall())
+		return true;
+
+	m_ForwardHitResult = Temp;
+	return false;
+}
+
+bool FSpiderMovement::SweepFall(float DeltaTime, ISpiderMovementWorld& World)
+{
+	// Batched spiders planned this in the parallel integrate pass
+	if (!m_FallPlanned)
+		PlanFall(DeltaTime);
+
+	const int32 Substeps{ m_FallVelocities.Num() };
+	const float SubstepTime{ m_FallSubstepTime };
+	// Planned velocities hold until a hit pushes or slides the body, after that they are applied as it goes
+	bool OnPlan{ true };
+
+	for (int32 Substep{}; Substep < Substeps; ++Substep)
+	{
+		if (OnPlan)
+		{
+			m_Sim.Velocity = m_FallVelocities[Substep];
+		}
+		else
+		{
+			ApplyGravity(SubstepTime);
+			ApplyDrag(SubstepTime);
+		}
+
+		const FVector End{ m_Sim.Location + m_Sim.Velocity * SubstepTime };
+		FHitResult HitResult{};
+		if (!World.SweepProbe(m_Sim.Location, End, m_Sim.SurfaceRotation, HitResult) || !HitResult.bBlockingHit)
+		{
+			m_Sim.Location = End;
+			continue;
+		}
+
+		// Started inside something (a pawn walked into us, a strand swung through), push out and fall on from there
+		if (HitResult.bStartPenetrating)
+		{
+			m_Sim.Location += HitResult.Normal * (HitResult.PenetrationDepth + DEPENETRATION_MARGIN);
+			m_Sim.Velocity -= HitResult.Normal * FMath::Min(m_Sim.Velocity.Dot(HitResult.Normal), 0.0);
+			OnPlan = false;
+			continue;
+		}
+
+		// Pawns and physics bodies stop the body, it slides off them instead of landing
+		if (!World.CanStandOn(HitResult))
+		{
+			m_Sim.Location = HitResult.Location;
+			m_Sim.Velocity = FVector::VectorPlaneProject(m_Sim.Velocity, HitResult.Normal);
+			OnPlan = false;
+			continue;
+		}
+
+		// Stop at the time of impact and stand on what the capsule touched, as if the down probe found it
+		m_Sim.Location = HitResult.Location;
+		m_DownHitResult = HitResult;
+		m_DownHitResult.Location = HitResult.ImpactPoint;
+		m_DownHitResult.Distance = static_cast<float>(FVector::Dist(m_Sim.Location, HitResult.ImpactPoint));
+		m_DownProbed = true;
+		m_Placed = true;
+		return true;
+	}
+
+	m_Placed = true;
+	return false;
+}
+
+bool FSpiderMovement::IsOnWeb(ISpiderMovementWorld& World)
+{
+	const FHitResult* Web{};
+
+	if (CheckWall(World))
+		Web = &m_ForwardHitResult;
+	else if (CheckGrounded(World))
+		Web = &m_DownHitResult;
+
+	if (Web == nullptr || !World.IsWebLine(*Web))
+		return false;
+
+	World.MountWebLine(*Web);
+	return true;
+}
+#pragma endregion HitDetection
+
+#pragma region Helpers
+// ==============================================================================
+// Helpers
+// ==============================================================================
+
+FVector FSpiderMovement::GetUpVector() const
+{
+	return m_Sim.SurfaceRotation.GetUpVector();
+}
+
+FVector FSpiderMovement::GetForwardVector() const
+{
+	return GetBodyRotation().GetForwardVector();
+}
+
+FVector FSpiderMovement::GetRightVector() const
+{
+	return GetBodyRotation().GetRightVector();
+}
+
+FQuat FSpiderMovement::GetBodyRotation() const
+{
+	return m_Sim.SurfaceRotation * FQuat{ FRotator{ 0, m_Sim.BodyYaw, 0 } };
+}
+
+bool FSpiderMovement::IsTransitioning() const
+{
+	// Checking for 0 necessary due to going backwards
+	return 0.f <= m_Sim.LerpTimer && m_Sim.LerpTimer <= 1.f;
+}
+
+bool FSpiderMovement::IsGrounded() const
+{
+	return m_DownHitResult.IsValidBlockingHit() && m_DownHitResult.Distance <= Params.GroundCheckDistance;
+}
+
+bool FSpiderMovement::IsJumping() const
+{
+	return m_Sim.JumpImmuneTimer > 0.f;
+}
+
+bool FSpiderMovement::IsMoving() const
+{
+	return m_Sim.Velocity.Length() > FLT_EPSILON;
+}
+
+bool FSpiderMovement::IsFalling() const
+{
+	return m_Sim.State == ESpiderState::Fall;
+}
+
+bool FSpiderMovement::HitWall() const
+{
+	return	m_ForwardHitResult.IsValidBlockingHit() &&
+			m_ForwardHitResult.Distance <= Params.WallCheckDistance;
+}
+
+bool FSpiderMovement::ChangedGround() const
+{
+	return !GetUpVector().Equals(m_DownHitResult.ImpactNormal, NORMAL_TOLERANCE) && IsGrounded();
+}
+
+bool FSpiderMovement::FellOffWall() const
+{
+	return !GetUpVector().Equals(FVector::UnitZ());
+}
+
+#pragma endregion Helpers
+
+#pragma region FixedStep
+// ==============================================================================
+// Fixed step
+// ==============================================================================
+
+int32 FSpiderFixedStep::Advance(float DeltaTime)
+{
+	m_Accumulator += DeltaTime;
+
+	int32 Steps{ FMath::FloorToInt32(m_Accumulator / StepTime) };
+	if (Steps > MaxSteps)
+	{
+		// Drop the time we can't catch up on
+		Steps = MaxSteps;
+		m_Accumulator = FMath::Fmod(m_Accumulator, StepTime);
+		return Steps;
+	}
+
+	m_Accumulator -= Steps * StepTime;
+	return Steps;
+}
+
+float FSpiderFixedStep::GetAlpha() const
+{
+	return FMath::Clamp(m_Accumulator / StepTime, 0.f, 1.f);
+}
+
+void FSpiderFixedStep::Reset()
+{
+	m_Accumulator = 0.f;
+}
+#pragma endregion FixedStep
@@ -0,0 +1,270 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+
+// Rays a spider fires to find the surface it is walking on
+enum class ESpiderProbe : uint8
+{
+	Down,
+	Forward,
+	Count
+};
+
+enum class ESpiderState : uint8
+{
+	Ground,
+	Transition,
+	Fall,
+	OnWeb,
+	Jumping
+};
+
+constexpr int32 SPIDER_STATE_COUNT{ 5 };
+
+// Time spent in each state, only gathered while a sink is set (benchmarks)
+struct FSpiderStateTimings
+{
+	uint64 Cycles[SPIDER_STATE_COUNT]{};
+	uint32 Steps[SPIDER_STATE_COUNT]{};
+
+	void Reset();
+};
+
+// Tuning, mirrored from the editable properties on ABaseSpider
+struct FSpiderMovementParams
+{
+	float MovementSpeed{ 1000.0f };
+	float WallInterpolateTime{ 0.7f };
+	float LargeLerpCompensation{ 2.f };
+	float Gravity{ 2000.0f };
+	float Drag{ 0.93f };
+	float WallCheckDistance{ 100.0f };
+	float GroundCheckDistance{ 50.f };
+	float JumpImmuneTime{ 0.1f };
+	float CapsuleRadius{ 34.f };
+	// Falls are swept in up to this many pieces a step, following the arc gravity bends them into
+	int32 MaxFallSubsteps{ 4 };
+};
+
+// Input held for every step of a frame
+struct FSpiderMovementInput
+{
+	// Y of the consumed movement input vector
+	float Forward{};
+	// Control rotation yaw the body turns to
+	float BodyYaw{};
+	// Jumps at the start of the step when above zero, only ever set for one step
+	float JumpPower{};
+};
+
+// Everything a step changes, copied to interpolate between steps
+struct FSpiderSimState
+{
+	ESpiderState State{ ESpiderState::Fall };
+	ESpiderState OldState{ ESpiderState::Fall };
+
+	// Body
+	FVector Location{};
+	FQuat SurfaceRotation{ FQuat::Identity };
+	float BodyYaw{};
+
+	// Controls
+	FVector Velocity{};
+	float JumpImmuneTimer{};
+
+	// Lerp
+	FVector StickPosition{};
+	FRotator StickRotation{};
+	float LerpTimer{ FLT_MAX };
+	float LerpRatio{};
+
+	// Web
+	FVector StartLinePoint{};
+	FVector EndLinePoint{};
+	// Handle the world knows the strand by, INDEX_NONE for lines set from Blueprint
+	int32 WebStrand{ INDEX_NONE };
+	// Riding the strand, the spider is placed by arc length from StartLinePoint without tracing
+	bool WebAttached{ false };
+	float WebDistance{};
+	FVector WebOffset{};
+};
+
+// What the simulation needs from the world around it, the pawn or a headless stand-in
+class ISpiderMovementWorld
+{
+public:
+	virtual ~ISpiderMovementWorld() = default;
+
+	// Returns true on a blocking hit
+	virtual bool Probe(ESpiderProbe ProbeType, const FVector& Start, const FVector& End, FHitResult& OutHit) = 0;
+	// Moves the body by Delta, stopping at blocking geometry. Returns where the body ended up
+	virtual FVector Sweep(const FVector& Start, const FVector& Delta, const FQuat& Rotation) = 0;
+	// Sweeps the body against anything it can stand on, webs included. OutHit.Location is where the body touched
+	virtual bool SweepProbe(const FVector& Start, const FVector& End, const FQuat& Rotation, FHitResult& OutHit) = 0;
+	// False for what SweepProbe stops at but can't be landed on (pawns, physics bodies)
+	virtual bool CanStandOn(const FHitResult& HitResult) const { return true; }
+	virtual bool IsWeb(const FHitResult& HitResult) const = 0;
+	virtual bool IsWebLine(const FHitResult& HitResult) const = 0;
+
+	virtual void MountWebLine(const FHitResult& HitResult) {}
+	// Current ends of a strand, false once it is gone
+	virtual bool GetWebStrand(int32 Strand, FVector& OutStart, FVector& OutEnd) const { return false; }
+	// True once a break cut the strand off from the level, never anchored strands stay walkable
+	virtual bool IsWebStrandDetached(int32 Strand) const { return false; }
+	// Strand carrying on from the end of Strand at Point, INDEX_NONE at a loose end
+	virtual int32 FindWebJunction(int32 Strand, const FVector& Point, const FVector& Direction) const { return INDEX_NONE; }
+	virtual void PlayWalkSound(bool OnWeb, bool Moving) {}
+	virtual void PlayLandingSound() {}
+	virtual void StopWalkSound() {}
+	virtual void StopAllSounds() {}
+};
+
+/**
+ * Spider movement state machine without any actor or component.
+ * Steps with whatever delta it is given, drive it through FSpiderFixedStep for frame rate independent results.
+ */
+class SPIDERGAME_API FSpiderMovement
+{
+public:
+	FSpiderMovementParams Params{};
+	// Tells spiders apart in Insights state change events
+	uint32 TraceId{};
+
+	void Step(float DeltaTime, const FSpiderMovementInput& Input, ISpiderMovementWorld& World);
+	// Steps that need nothing from the world (transition lerps, jumps), safe on any thread.
+	// False when the step needs the world, the state is left untouched then and Step has to run instead.
+	// A falling body still gets its gravity and drag worked out here, Step only sweeps along them
+	bool Integrate(float DeltaTime, const FSpiderMovementInput& Input);
+	// Game thread half of an integrated step, moves the body through the world
+	void FinishIntegrate(float DeltaTime, ISpiderMovementWorld& World);
+	bool Jump(float JumpPower, ISpiderMovementWorld& World);
+	// Strand is the world's handle for it, without one the line stays where it was set
+	void SetClosestWeb(const FVector& Start, const FVector& End, int32 Strand = INDEX_NONE);
+
+	const FSpiderSimState& GetSimState() const;
+	void SetSimState(const FSpiderSimState& SimState);
+	void Teleport(const FVector& Location, const FQuat& SurfaceRotation);
+
+	FVector GetUpVector() const;
+	FVector GetForwardVector() const;
+	FVector GetRightVector() const;
+	FQuat GetBodyRotation() const;
+
+	bool IsGrounded() const;
+	bool IsJumping() const;
+	bool IsMoving() const;
+	bool IsFalling() const;
+	bool IsTransitioning() const;
+	bool HitWall() const;
+
+	// Every spider adds its step times to Sink until it is cleared with nullptr
+	static void SetTimingSink(FSpiderStateTimings* Sink);
+
+private:
+	static constexpr float RAYCAST_LENGTH{ 1000.f };
+	static constexpr float NORMAL_TOLERANCE{ 0.1f };
+	// Extra distance a falling body is pushed out of what it started inside
+	static constexpr float DEPENETRATION_MARGIN{ 0.125f };
+	// Junctions crossed in one step at most, strands can be shorter than a step
+	static constexpr int32 MAX_JUNCTIONS_PER_STEP{ 4 };
+
+	FSpiderSimState m_Sim{};
+	FSpiderMovementInput m_Input{};
+
+	// Collision
+	FHitResult m_DownHitResult{};
+	FHitResult m_ForwardHitResult{};
+	// Probes already traced this step, IsOnWeb reuses them
+	bool m_DownProbed{ false };
+	bool m_ForwardProbed{ false };
+	// The state already put the body where it goes this step, skip the sweep
+	bool m_Placed{ false };
+	// Strand end the probes found nothing at, waiting there doesn't trace again until the body moves or turns
+	bool m_IdleAtEnd{ false };
+	FVector m_IdleEndLocation{};
+	FQuat m_IdleEndRotation{};
+	// Integrated step waiting for FinishIntegrate
+	ESpiderState m_IntegratedState{};
+	uint64 m_IntegratedCycles{};
+	// Velocity after every fall substep when nothing is hit, worked out before the sweeps need them
+	TArray<FVector, TInlineAllocator<8>> m_FallVelocities{};
+	float m_FallSubstepTime{};
+	bool m_FallPlanned{ false };
+
+	// ==============================================================================
+	// States
+	// ==============================================================================
+	void Transition(float DeltaTime, ISpiderMovementWorld& World);
+	void Grounded(float DeltaTime, ISpiderMovementWorld& World);
+	void OnWeb(float DeltaTime, ISpiderMovementWorld& World);
+	void Falling(float DeltaTime, ISpiderMovementWorld& World);
+	void Jumping(float DeltaTime);
+	void LerpTransition(float DeltaTime);
+	void BeginStep(const FSpiderMovementInput& Input);
+	void EndStep(float DeltaTime, ESpiderState StepState, uint64 Cycles, ISpiderMovementWorld& World);
+
+	// ==============================================================================
+	// Controls
+	// ==============================================================================
+	void RotateBody();
+	void HandleMove(const FVector& Direction);
+
+	// ==============================================================================
+	// Physics
+	// ==============================================================================
+	void ApplyGravity(float DeltaTime);
+	void ApplyDrag(float DeltaTime);
+	void PlanFall(float DeltaTime);
+
+	// ==============================================================================
+	// Surface sticking
+	// ==============================================================================
+	void SetTransition(const FHitResult& HitResult);
+	void TransitionSurfaces(float DeltaTime);
+	void CalcSurfaceStickPoint(const FHitResult& HitResult);
+	void CalcLerpRatio();
+	void StickToSurface();
+	void RotateToWorld(float DeltaTime);
+
+	// ==============================================================================
+	// Web strands
+	// ==============================================================================
+	void AttachToStrand();
+	bool CrossJunction(double& Distance, ISpiderMovementWorld& World);
+	void ReachStrandEnd(ISpiderMovementWorld& World);
+
+	// ==============================================================================
+	// Hit detection
+	// ==============================================================================
+	bool CheckGrounded(ISpiderMovementWorld& World);
+	bool CheckWall(ISpiderMovementWorld& World);
+	bool SweepFall(float DeltaTime, ISpiderMovementWorld& World);
+	bool IsOnWeb(ISpiderMovementWorld& World);
+
+	// ==============================================================================
+	// Helpers
+	// ==============================================================================
+	bool ChangedGround() const;
+	bool FellOffWall() const;
+	void BookStateChange(ESpiderState OldState) const;
+};
+
+// Accumulates frame time and hands it out in fixed steps
+struct SPIDERGAME_API FSpiderFixedStep
+{
+	float StepTime{ 1.f / 60.f };
+	// Caps the steps per frame so a hitch slows the game down instead of piling up work
+	int32 MaxSteps{ 8 };
+
+	// Returns the number of steps to simulate this frame
+	int32 Advance(float DeltaTime);
+	// How far the accumulator is into the next step, used to interpolate rendering
+	float GetAlpha() const;
+	void Reset();
+
+private:
+	float m_Accumulator{};
+};
@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderNavGraph.h"
+
+#include "Algo/Reverse.h"
+
+int32 FSpiderNavGraph::GetNumNodes() const
+{
+	return Locations.Num();
+}
+
+bool FSpiderNavGraph::IsEmpty() const
+{
+	return Locations.IsEmpty();
+}
+
+int32 FSpiderNavGraph::FindNearestNode(const FVector& Location, float MaxDistance) const
+{
+	int32 Nearest{ INDEX_NONE };
+	double NearestDistanceSquared{ FMath::Square(MaxDistance) };
+
+	const FIntVector Min{ ToLookupCell(Location - FVector{ MaxDistance }) };
+	const FIntVector Max{ ToLookupCell(Location + FVector{ MaxDistance }) };
+	for (int32 X{ Min.X }; X <= Max.X; ++X)
+	{
+		for (int32 Y{ Min.Y }; Y <= Max.Y; ++Y)
+		{
+			for (int32 Z{ Min.Z }; Z <= Max.Z; ++Z)
+			{
+				const TArray<int32>* Cell{ m_Lookup.Find({ X, Y, Z }) };
+				if (Cell == nullptr)
+					continue;
+
+				for (const int32 Node : *Cell)
+				{
+					const double DistanceSquared{ FVector::DistSquared(Location, FVector{ Locations[Node] }) };
+					if (DistanceSquared <= NearestDistanceSquared)
+					{
+						NearestDistanceSquared = DistanceSquared;
+						Nearest = Node;
+					}
+				}
+			}
+		}
+	}
+
+	return Nearest;
+}
+
+bool FSpiderNavGraph::FindPath(int32 Start, int32 Goal, const TBitArray<>& BlockedLinks, TArray<FSpiderNavPoint>& OutPath) const
+{
+	OutPath.Reset();
+	if (!Locations.IsValidIndex(Start) || !Locations.IsValidIndex(Goal))
+		return false;
+
+	struct FOpenNode
+	{
+		float Estimate{};
+		int32 Node{};
+
+		bool operator<(const FOpenNode& Other) const { return Estimate < Other.Estimate; }
+	};
+
+	// Per query scratch, the graph itself is never written so queries can run side by side
+	const int32 NumNodes{ GetNumNodes() };
+	TArray<float> Costs{};
+	Costs.Init(TNumericLimits<float>::Max(), NumNodes);
+	TArray<int32> CameFromLink{};
+	CameFromLink.Init(INDEX_NONE, NumNodes);
+	TArray<int32> CameFrom{};
+	CameFrom.Init(INDEX_NONE, NumNodes);
+	TBitArray<> Closed{ false, NumNodes };
+	TArray<FOpenNode> Open{};
+
+	const FVector3f GoalLocation{ Locations[Goal] };
+	Costs[Start] = 0.f;
+	Open.HeapPush({ FVector3f::Dist(Locations[Start], GoalLocation), Start });
+
+	while (!Open.IsEmpty())
+	{
+		FOpenNode Current{};
+		Open.HeapPop(Current, false);
+		if (Closed[Current.Node])
+			continue;
+
+		if (Current.Node == Goal)
+			break;
+
+		Closed[Current.Node] = true;
+		for (int32 Link{ LinkOffsets[Current.Node] }; Link < LinkOffsets[Current.Node + 1]; ++Link)
+		{
+			const int32 Next{ LinkTargets[Link] };
+			if (Closed[Next] || (BlockedLinks.IsValidIndex(Link) && BlockedLinks[Link]))
+				continue;
+
+			const float Cost{ Costs[Current.Node] + FVector3f::Dist(Locations[Current.Node], Locations[Next]) };
+			if (Cost >= Costs[Next])
+				continue;
+
+			Costs[Next] = Cost;
+			CameFrom[Next] = Current.Node;
+			CameFromLink[Next] = Link;
+			Open.HeapPush({ Cost + FVector3f::Dist(Locations[Next], GoalLocation), Next });
+		}
+	}
+
+	if (Start != Goal && CameFrom[Goal] == INDEX_NONE)
+		return false;
+
+	for (int32 Node{ Goal }; Node != INDEX_NONE; Node = CameFrom[Node])
+	{
+		const int32 Link{ CameFromLink[Node] };
+		OutPath.Add({ FVector{ Locations[Node] }, FVector{ Normals[Node] }, Link != INDEX_NONE ? LinkTypes[Link] : ESpiderNavLink::Surface });
+	}
+
+	Algo::Reverse(OutPath);
+	return true;
+}
+
+void FSpiderNavGraph::Reset()
+{
+	Locations.Reset();
+	Normals.Reset();
+	LinkOffsets.Reset();
+	LinkTargets.Reset();
+	LinkTypes.Reset();
+	m_Lookup.Reset();
+}
+
+void FSpiderNavGraph::BuildLookup()
+{
+	m_Lookup.Reset();
+	for (int32 Node{}; Node < Locations.Num(); ++Node)
+		m_Lookup.FindOrAdd(ToLookupCell(FVector{ Locations[Node] })).Add(Node);
+}
+
+FIntVector FSpiderNavGraph::ToLookupCell(const FVector& Location)
+{
+	return {
+		FMath::FloorToInt32(Location.X / LOOKUP_CELL_SIZE),
+		FMath::FloorToInt32(Location.Y / LOOKUP_CELL_SIZE),
+		FMath::FloorToInt32(Location.Z / LOOKUP_CELL_SIZE)
+	};
+}
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderNavGraph.generated.h"
+
+UENUM()
+enum class ESpiderNavLink : uint8
+{
+	// Walked along floors, walls and ceilings
+	Surface,
+	// Walked along a web strand, can break at runtime
+	WebLine
+};
+
+// A point on the way, Normal is the surface the spider stands on there
+struct FSpiderNavPoint
+{
+	FVector Location{};
+	FVector Normal{};
+	ESpiderNavLink Link{ ESpiderNavLink::Surface };
+};
+
+/**
+ * Nodes on surfaces of any orientation with the links between them, built offline by ASpiderNavGraphActor.
+ * Links are stored compressed (each node's links start at LinkOffsets[Node]), positions and normals in single precision.
+ * FindPath only reads, so it can run on any thread while nobody rebuilds the graph.
+ */
+USTRUCT()
+struct SPIDERGAME_API FSpiderNavGraph
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FVector3f> Locations{};
+	UPROPERTY()
+	TArray<FVector3f> Normals{};
+	// One more entry than there are nodes, the last one is the number of links
+	UPROPERTY()
+	TArray<int32> LinkOffsets{};
+	UPROPERTY()
+	TArray<int32> LinkTargets{};
+	UPROPERTY()
+	TArray<ESpiderNavLink> LinkTypes{};
+
+	int32 GetNumNodes() const;
+	bool IsEmpty() const;
+
+	// Node closest to Location within MaxDistance, INDEX_NONE if there is none
+	int32 FindNearestNode(const FVector& Location, float MaxDistance) const;
+	// Set bits in BlockedLinks are skipped, used for broken web strands. Returns false when Goal can't be reached
+	bool FindPath(int32 Start, int32 Goal, const TBitArray<>& BlockedLinks, TArray<FSpiderNavPoint>& OutPath) const;
+
+	void Reset();
+	// Fills the lookup grid, call after changing the nodes and before sharing the graph between threads
+	void BuildLookup();
+
+private:
+	static constexpr float LOOKUP_CELL_SIZE{ 200.f };
+
+	TMap<FIntVector, TArray<int32>> m_Lookup{};
+
+	static FIntVector ToLookupCell(const FVector& Location);
+};
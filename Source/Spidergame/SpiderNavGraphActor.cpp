@@ -0,0 +1,247 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderNavGraphActor.h"
+
+#include "EngineUtils.h"
+#include "Algo/StableSort.h"
+#include "SpiderNavSubsystem.h"
+#include "WebStrandInstancesComponent.h"
+#include "Components/BoxComponent.h"
+#include "Engine/World.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogSpiderNav, Log, All);
+
+ASpiderNavGraphActor::ASpiderNavGraphActor()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	Bounds = CreateDefaultSubobject<UBoxComponent>(TEXT("Bounds"));
+	Bounds->SetBoxExtent({ 2000.f, 2000.f, 1000.f });
+	Bounds->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	RootComponent = Bounds;
+}
+
+void ASpiderNavGraphActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (USpiderNavSubsystem* Navigation{ GetWorld()->GetSubsystem<USpiderNavSubsystem>() })
+		Navigation->RegisterGraph(this);
+}
+
+void ASpiderNavGraphActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (USpiderNavSubsystem* Navigation{ GetWorld()->GetSubsystem<USpiderNavSubsystem>() })
+		Navigation->UnregisterGraph(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASpiderNavGraphActor::Build()
+{
+#if WITH_EDITOR
+	const double StartTime{ FPlatformTime::Seconds() };
+
+	TArray<FBuildNode> Nodes{};
+	TArray<FBuildLink> Links{};
+	SampleSurfaces(Nodes);
+	LinkSurfaces(Nodes, Links);
+	if (IncludeWebStrands)
+		AddWebStrands(Nodes, Links);
+
+	Modify();
+	Compress(Nodes, Links);
+
+	UE_LOG(LogSpiderNav, Log, TEXT("%s: built %d nodes and %d links in %.2fs"), *GetName(), m_Graph.GetNumNodes(), m_Graph.LinkTargets.Num(),
+		FPlatformTime::Seconds() - StartTime);
+#endif
+}
+
+const FSpiderNavGraph& ASpiderNavGraphActor::GetGraph() const
+{
+	return m_Graph;
+}
+
+#if WITH_EDITOR
+void ASpiderNavGraphActor::SampleSurfaces(TArray<FBuildNode>& OutNodes) const
+{
+	static const FVector DIRECTIONS[]{ FVector::UnitX(), -FVector::UnitX(), FVector::UnitY(), -FVector::UnitY(), FVector::UnitZ(), -FVector::UnitZ() };
+
+	const FBox Box{ Bounds->Bounds.GetBox() };
+	const float Spacing{ FMath::Max(NodeSpacing, 10.f) };
+	const FCollisionQueryParams Params{ SCENE_QUERY_STAT(SpiderNavBuild), true };
+
+	// One node per half spacing cell and facing, traces from neighbouring grid points find the same surface
+	TMap<FIntVector4, int32> Samples{};
+	for (double X{ Box.Min.X }; X <= Box.Max.X; X += Spacing)
+	{
+		for (double Y{ Box.Min.Y }; Y <= Box.Max.Y; Y += Spacing)
+		{
+			for (double Z{ Box.Min.Z }; Z <= Box.Max.Z; Z += Spacing)
+			{
+				const FVector Point{ X, Y, Z };
+				for (const FVector& Direction : DIRECTIONS)
+				{
+					FHitResult HitResult{};
+					if (!GetWorld()->LineTraceSingleByObjectType(HitResult, Point, Point + Direction * Spacing, ECC_WorldStatic, Params))
+						continue;
+
+					const FVector& Normal{ HitResult.ImpactNormal };
+					const int32 Facing{ Normal.GetAbs().GetMax() == FMath::Abs(Normal.X) ? 0 : Normal.GetAbs().GetMax() == FMath::Abs(Normal.Y) ? 1 : 2 };
+					const FVector Cell{ HitResult.ImpactPoint / (Spacing * 0.5) };
+					const FIntVector4 Key{ FMath::FloorToInt32(Cell.X), FMath::FloorToInt32(Cell.Y), FMath::FloorToInt32(Cell.Z), Facing * 2 + (Normal[Facing] > 0.0 ? 1 : 0) };
+					if (Samples.Contains(Key) || !Box.IsInside(HitResult.ImpactPoint))
+						continue;
+
+					Samples.Add(Key, OutNodes.Num());
+					OutNodes.Add({ HitResult.ImpactPoint, Normal });
+				}
+			}
+		}
+	}
+}
+
+void ASpiderNavGraphActor::LinkSurfaces(const TArray<FBuildNode>& Nodes, TArray<FBuildLink>& OutLinks) const
+{
+	const float LinkDistance{ FMath::Max(NodeSpacing, 10.f) * 1.5f };
+	const double MinCosAngle{ FMath::Cos(FMath::DegreesToRadians(MaxLinkAngle)) };
+
+	// Bin by link distance so only neighbouring cells are compared
+	TMap<FIntVector, TArray<int32>> Cells{};
+	for (int32 Node{}; Node < Nodes.Num(); ++Node)
+	{
+		const FVector Cell{ Nodes[Node].Location / LinkDistance };
+		Cells.FindOrAdd({ FMath::FloorToInt32(Cell.X), FMath::FloorToInt32(Cell.Y), FMath::FloorToInt32(Cell.Z) }).Add(Node);
+	}
+
+	for (const TPair<FIntVector, TArray<int32>>& Pair : Cells)
+	{
+		for (const int32 From : Pair.Value)
+		{
+			const FBuildNode& A{ Nodes[From] };
+			for (int32 X{ -1 }; X <= 1; ++X)
+			for (int32 Y{ -1 }; Y <= 1; ++Y)
+			for (int32 Z{ -1 }; Z <= 1; ++Z)
+			{
+				const TArray<int32>* Neighbours{ Cells.Find(Pair.Key + FIntVector{ X, Y, Z }) };
+				if (Neighbours == nullptr)
+					continue;
+
+				for (const int32 To : *Neighbours)
+				{
+					// Both directions are added together
+					if (To <= From)
+						continue;
+
+					const FBuildNode& B{ Nodes[To] };
+					if (FVector::DistSquared(A.Location, B.Location) > FMath::Square(LinkDistance) || A.Normal.Dot(B.Normal) < MinCosAngle)
+						continue;
+
+					// Where the spider's body would be, it has to fit through
+					if (!IsClear(A.Location + A.Normal * Clearance, B.Location + B.Normal * Clearance))
+						continue;
+
+					OutLinks.Add({ From, To, ESpiderNavLink::Surface });
+					OutLinks.Add({ To, From, ESpiderNavLink::Surface });
+				}
+			}
+		}
+	}
+}
+
+void ASpiderNavGraphActor::AddWebStrands(TArray<FBuildNode>& Nodes, TArray<FBuildLink>& Links) const
+{
+	constexpr float JUNCTION_DISTANCE{ 10.f };
+	const float LinkDistance{ FMath::Max(NodeSpacing, 10.f) * 1.5f };
+	const int32 NumSurfaceNodes{ Nodes.Num() };
+	const FBox Box{ Bounds->Bounds.GetBox() };
+
+	// Strand ends that meet share a node, that's where the spider can change strands
+	const auto FindOrAddEnd = [&Nodes, NumSurfaceNodes, JUNCTION_DISTANCE](const FVector& Location)
+	{
+		for (int32 Node{ NumSurfaceNodes }; Node < Nodes.Num(); ++Node)
+		{
+			if (FVector::DistSquared(Nodes[Node].Location, Location) <= FMath::Square(JUNCTION_DISTANCE))
+				return Node;
+		}
+
+		return Nodes.Add({ Location, FVector::UnitZ() });
+	};
+
+	for (TActorIterator<AActor> It{ GetWorld() }; It; ++It)
+	{
+		TInlineComponentArray<UWebStrandInstancesComponent*> Webs{ *It };
+		for (const UWebStrandInstancesComponent* Web : Webs)
+		{
+			for (int32 Strand{}; Strand < Web->GetInstanceCount(); ++Strand)
+			{
+				FVector Start{};
+				FVector End{};
+				if (!Web->IsValidStrand(Strand))
+					continue;
+
+				Web->GetStrandEnds(Strand, Start, End);
+				if (!Box.IsInside(Start) && !Box.IsInside(End))
+					continue;
+
+				const int32 From{ FindOrAddEnd(Start) };
+				const int32 To{ FindOrAddEnd(End) };
+				if (From == To)
+					continue;
+
+				Links.Add({ From, To, ESpiderNavLink::WebLine });
+				Links.Add({ To, From, ESpiderNavLink::WebLine });
+			}
+		}
+	}
+
+	// Tie the strand ends to the surfaces they are anchored on
+	for (int32 End{ NumSurfaceNodes }; End < Nodes.Num(); ++End)
+	{
+		for (int32 Node{}; Node < NumSurfaceNodes; ++Node)
+		{
+			const FBuildNode& Surface{ Nodes[Node] };
+			if (FVector::DistSquared(Surface.Location, Nodes[End].Location) > FMath::Square(LinkDistance)
+				|| !IsClear(Nodes[End].Location, Surface.Location + Surface.Normal * Clearance))
+				continue;
+
+			Links.Add({ End, Node, ESpiderNavLink::Surface });
+			Links.Add({ Node, End, ESpiderNavLink::Surface });
+		}
+	}
+}
+
+void ASpiderNavGraphActor::Compress(const TArray<FBuildNode>& Nodes, const TArray<FBuildLink>& Links)
+{
+	m_Graph.Reset();
+
+	m_Graph.Locations.Reserve(Nodes.Num());
+	m_Graph.Normals.Reserve(Nodes.Num());
+	for (const FBuildNode& Node : Nodes)
+	{
+		m_Graph.Locations.Add(FVector3f{ Node.Location });
+		m_Graph.Normals.Add(FVector3f{ Node.Normal });
+	}
+
+	TArray<FBuildLink> Sorted{ Links };
+	Algo::StableSortBy(Sorted, &FBuildLink::From);
+
+	m_Graph.LinkOffsets.Init(0, Nodes.Num() + 1);
+	m_Graph.LinkTargets.Reserve(Sorted.Num());
+	m_Graph.LinkTypes.Reserve(Sorted.Num());
+	for (const FBuildLink& Link : Sorted)
+	{
+		++m_Graph.LinkOffsets[Link.From + 1];
+		m_Graph.LinkTargets.Add(Link.To);
+		m_Graph.LinkTypes.Add(Link.Type);
+	}
+
+	for (int32 Node{}; Node < Nodes.Num(); ++Node)
+		m_Graph.LinkOffsets[Node + 1] += m_Graph.LinkOffsets[Node];
+}
+
+bool ASpiderNavGraphActor::IsClear(const FVector& Start, const FVector& End) const
+{
+	FHitResult HitResult{};
+	return !GetWorld()->LineTraceSingleByObjectType(HitResult, Start, End, ECC_WorldStatic, FCollisionQueryParams{ SCENE_QUERY_STAT(SpiderNavBuild), true });
+}
+#endif
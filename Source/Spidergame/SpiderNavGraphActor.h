@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavGraphActor.generated.h"
+
+class UBoxComponent;
+
+/**
+ * Surface navigation for AI spiders, one per level. Build samples every surface inside the box (floors, walls and ceilings alike)
+ * and links neighbours a spider can walk between, strands of web strand instance components become links of their own.
+ * Blueprint web lines aren't collected, they have no registered strand to check at runtime.
+ * The graph is saved with the level and handed to USpiderNavSubsystem on BeginPlay.
+ */
+UCLASS()
+class SPIDERGAME_API ASpiderNavGraphActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASpiderNavGraphActor();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Navigation")
+	TObjectPtr<UBoxComponent> Bounds{};
+
+	// Distance between sampled surface points
+	UPROPERTY(EditAnywhere, Category="Navigation")
+	float NodeSpacing{ 100.f };
+	// Room a spider needs above a surface, links are checked this far off both surfaces
+	UPROPERTY(EditAnywhere, Category="Navigation")
+	float Clearance{ 40.f };
+	// Largest bend between two linked surfaces, past 90 only convex edges need it
+	UPROPERTY(EditAnywhere, Category="Navigation")
+	float MaxLinkAngle{ 100.f };
+	UPROPERTY(EditAnywhere, Category="Navigation")
+	bool IncludeWebStrands{ true };
+
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION(CallInEditor, Category="Navigation")
+	void Build();
+
+	const FSpiderNavGraph& GetGraph() const;
+
+private:
+	UPROPERTY()
+	FSpiderNavGraph m_Graph{};
+
+#if WITH_EDITOR
+	struct FBuildNode
+	{
+		FVector Location{};
+		FVector Normal{};
+	};
+
+	struct FBuildLink
+	{
+		int32 From{};
+		int32 To{};
+		ESpiderNavLink Type{};
+	};
+
+	void SampleSurfaces(TArray<FBuildNode>& OutNodes) const;
+	void LinkSurfaces(const TArray<FBuildNode>& Nodes, TArray<FBuildLink>& OutLinks) const;
+	void AddWebStrands(TArray<FBuildNode>& Nodes, TArray<FBuildLink>& Links) const;
+	void Compress(const TArray<FBuildNode>& Nodes, const TArray<FBuildLink>& Links);
+	bool IsClear(const FVector& Start, const FVector& End) const;
+#endif
+};
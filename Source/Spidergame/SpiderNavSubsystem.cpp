@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderNavSubsystem.h"
+
+#include "SpiderNavGraphActor.h"
+#include "WebGraphSubsystem.h"
+#include "Async/Async.h"
+
+void USpiderNavSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_WebGraph = Collection.InitializeDependency<UWebGraphSubsystem>();
+}
+
+void USpiderNavSubsystem::Deinitialize()
+{
+	m_Graph.Reset();
+	m_GraphActor.Reset();
+	Super::Deinitialize();
+}
+
+void USpiderNavSubsystem::RegisterGraph(const ASpiderNavGraphActor* GraphActor)
+{
+	if (GraphActor == nullptr || GraphActor->GetGraph().IsEmpty())
+		return;
+
+	// Copied once so searches never read the level's copy
+	TSharedRef<FSpiderNavGraph, ESPMode::ThreadSafe> Graph{ MakeShared<FSpiderNavGraph, ESPMode::ThreadSafe>(GraphActor->GetGraph()) };
+	Graph->BuildLookup();
+
+	m_WebLinks.Reset();
+	for (int32 Node{}; Node < Graph->GetNumNodes(); ++Node)
+	{
+		for (int32 Link{ Graph->LinkOffsets[Node] }; Link < Graph->LinkOffsets[Node + 1]; ++Link)
+		{
+			if (Graph->LinkTypes[Link] == ESpiderNavLink::WebLine)
+				m_WebLinks.Add({ Link, FVector{ Graph->Locations[Node] }, FVector{ Graph->Locations[Graph->LinkTargets[Link]] } });
+		}
+	}
+
+	m_GraphActor = GraphActor;
+	m_Graph = Graph;
+}
+
+void USpiderNavSubsystem::UnregisterGraph(const ASpiderNavGraphActor* GraphActor)
+{
+	if (m_GraphActor != GraphActor)
+		return;
+
+	m_GraphActor.Reset();
+	m_Graph.Reset();
+	m_WebLinks.Reset();
+}
+
+bool USpiderNavSubsystem::HasGraph() const
+{
+	return m_Graph.IsValid();
+}
+
+bool USpiderNavSubsystem::FindPathAsync(const FVector& Start, const FVector& Goal, FSpiderPathFound OnPathFound)
+{
+	if (!m_Graph.IsValid())
+		return false;
+
+	const int32 StartNode{ m_Graph->FindNearestNode(Start, MAX_SNAP_DISTANCE) };
+	const int32 GoalNode{ m_Graph->FindNearestNode(Goal, MAX_SNAP_DISTANCE) };
+	if (StartNode == INDEX_NONE || GoalNode == INDEX_NONE)
+		return false;
+
+	// Web strands are checked here, the web graph isn't safe to read while the game thread changes it
+	TBitArray<> Blocked{};
+	FindBrokenWebLinks(Blocked);
+
+	Async(EAsyncExecution::TaskGraph, [Graph = m_Graph, StartNode, GoalNode, Blocked = MoveTemp(Blocked), OnPathFound = MoveTemp(OnPathFound), Goal]() mutable
+	{
+		TArray<FSpiderNavPoint> Path{};
+		const bool Found{ Graph->FindPath(StartNode, GoalNode, Blocked, Path) };
+
+		// End exactly where we were asked to, the goal node is only close
+		if (Found)
+			Path.Add({ Goal, Path.Last().Normal, ESpiderNavLink::Surface });
+
+		AsyncTask(ENamedThreads::GameThread, [Found, Path = MoveTemp(Path), OnPathFound = MoveTemp(OnPathFound)]()
+		{
+			OnPathFound.ExecuteIfBound(Found, Path);
+		});
+	});
+
+	return true;
+}
+
+void USpiderNavSubsystem::FindBrokenWebLinks(TBitArray<>& OutBlocked)
+{
+	OutBlocked.Init(false, m_Graph->LinkTargets.Num());
+	if (m_WebGraph == nullptr)
+		return;
+
+	for (FWebLink& WebLink : m_WebLinks)
+	{
+		// Strands can register after the graph, the handle is looked up once they're there
+		if (WebLink.Segment == INDEX_NONE)
+			WebLink.Segment = FindWebLinkSegment(WebLink);
+
+		// A stale handle is the strand breaking, a new strand near it doesn't bring the link back
+		OutBlocked[WebLink.Link] = !m_WebGraph->IsValidSegment(WebLink.Segment);
+	}
+}
+
+int32 USpiderNavSubsystem::FindWebLinkSegment(const FWebLink& WebLink) const
+{
+	int32 Segment{};
+	FVector ClosestPoint{};
+	if (!m_WebGraph->FindClosestSegment((WebLink.From + WebLink.To) * 0.5, WEB_LINK_TOLERANCE, Segment, ClosestPoint))
+		return INDEX_NONE;
+
+	// Has to be the strand the link was built from, not one crossing it
+	const FVector Start{ m_WebGraph->GetSegmentStart(Segment) };
+	const FVector End{ m_WebGraph->GetSegmentEnd(Segment) };
+	const bool Matches{ (Start.Equals(WebLink.From, WEB_LINK_TOLERANCE) && End.Equals(WebLink.To, WEB_LINK_TOLERANCE))
+		|| (Start.Equals(WebLink.To, WEB_LINK_TOLERANCE) && End.Equals(WebLink.From, WEB_LINK_TOLERANCE)) };
+	return Matches ? Segment : INDEX_NONE;
+}
@@ -0,0 +1,61 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "SpiderNavGraph.h"
+#include "SpiderNavSubsystem.generated.h"
+
+class ASpiderNavGraphActor;
+class UWebGraphSubsystem;
+
+DECLARE_DELEGATE_TwoParams(FSpiderPathFound, bool /*Found*/, const TArray<FSpiderNavPoint>& /*Path*/);
+
+/**
+ * Answers path queries on the level's surface navigation graph. Searches run on a worker thread,
+ * the callback comes back on the game thread. Web strand links that broke since the graph was built are skipped.
+ * Only strands of UWebStrandInstancesComponent are web links, Blueprint web lines aren't in the web graph and aren't navigated.
+ */
+UCLASS()
+class SPIDERGAME_API USpiderNavSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void RegisterGraph(const ASpiderNavGraphActor* GraphActor);
+	void UnregisterGraph(const ASpiderNavGraphActor* GraphActor);
+	bool HasGraph() const;
+
+	// Returns false without calling back when there is no graph or no node near Start or Goal
+	bool FindPathAsync(const FVector& Start, const FVector& Goal, FSpiderPathFound OnPathFound);
+
+private:
+	// Start and goal may be this far from the closest node
+	static constexpr float MAX_SNAP_DISTANCE{ 300.f };
+	// How far a registered strand's ends may be off a web link's nodes and still be its strand
+	static constexpr float WEB_LINK_TOLERANCE{ 50.f };
+
+	struct FWebLink
+	{
+		int32 Link{};
+		FVector From{};
+		FVector To{};
+		// Web graph handle of the strand, found on the first query after it registered. Once invalid it stays broken
+		int32 Segment{ INDEX_NONE };
+	};
+
+	TWeakObjectPtr<const ASpiderNavGraphActor> m_GraphActor{};
+	// Shared with running searches, a new graph never changes one in use
+	TSharedPtr<const FSpiderNavGraph, ESPMode::ThreadSafe> m_Graph{};
+	// Web strand links, checked against the web graph on every query
+	TArray<FWebLink> m_WebLinks{};
+	UPROPERTY(Transient)
+	TObjectPtr<UWebGraphSubsystem> m_WebGraph{};
+
+	void FindBrokenWebLinks(TBitArray<>& OutBlocked);
+	int32 FindWebLinkSegment(const FWebLink& WebLink) const;
+};
@@ -0,0 +1,233 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderNetMovement.h"
+
+#include "Engine/NetSerialization.h"
+#include "UObject/CoreNet.h"
+
+namespace
+{
+	constexpr uint32 NORMAL_STEPS{ 1 << 10 };
+	constexpr uint32 STATE_MAX{ 1 << 3 };
+	constexpr int32 BIT_WRITER_SIZE{ 1024 };
+
+	// Octahedral mapping, a unit vector folded onto a square with even precision in every direction
+	FVector2D EncodeOctahedral(const FVector& Normal)
+	{
+		const FVector N{ Normal / (FMath::Abs(Normal.X) + FMath::Abs(Normal.Y) + FMath::Abs(Normal.Z)) };
+		if (N.Z >= 0.0)
+			return { N.X, N.Y };
+
+		return { (1.0 - FMath::Abs(N.Y)) * (N.X >= 0.0 ? 1.0 : -1.0), (1.0 - FMath::Abs(N.X)) * (N.Y >= 0.0 ? 1.0 : -1.0) };
+	}
+
+	FVector DecodeOctahedral(const FVector2D& Encoded)
+	{
+		FVector N{ Encoded.X, Encoded.Y, 1.0 - FMath::Abs(Encoded.X) - FMath::Abs(Encoded.Y) };
+		const double Fold{ FMath::Max(-N.Z, 0.0) };
+		N.X += N.X >= 0.0 ? -Fold : Fold;
+		N.Y += N.Y >= 0.0 ? -Fold : Fold;
+		return N.GetSafeNormal(UE_SMALL_NUMBER, FVector::UnitZ());
+	}
+
+	uint32 QuantizeUnit(double Value)
+	{
+		return static_cast<uint32>(FMath::Clamp(FMath::RoundToInt((Value * 0.5 + 0.5) * (NORMAL_STEPS - 1)), 0, NORMAL_STEPS - 1));
+	}
+
+	double DequantizeUnit(uint32 Value)
+	{
+		return static_cast<double>(Value) / (NORMAL_STEPS - 1) * 2.0 - 1.0;
+	}
+
+	void SerializeNormal(FVector& Normal, FArchive& Ar)
+	{
+		const FVector2D Encoded{ EncodeOctahedral(Normal) };
+		uint32 X{ QuantizeUnit(Encoded.X) };
+		uint32 Y{ QuantizeUnit(Encoded.Y) };
+		Ar.SerializeInt(X, NORMAL_STEPS);
+		Ar.SerializeInt(Y, NORMAL_STEPS);
+
+		if (Ar.IsLoading())
+			Normal = DecodeOctahedral({ DequantizeUnit(X), DequantizeUnit(Y) });
+	}
+
+	// The same bits the net driver would send, into one writer reused since this runs every replication
+	template<typename T>
+	int32 MeasureNetBits(const T& Value)
+	{
+		static thread_local FNetBitWriter Writer{ nullptr, BIT_WRITER_SIZE };
+		Writer.Reset();
+
+		// Saving only reads the value
+		bool Success{};
+		const_cast<T&>(Value).NetSerialize(Writer, nullptr, Success);
+		return static_cast<int32>(Writer.GetNumBits());
+	}
+}
+
+FSpiderNetInput FSpiderNetInput::Quantize(const FSpiderMovementInput& Input)
+{
+	FSpiderNetInput NetInput{};
+	NetInput.Forward = static_cast<int8>(FMath::RoundToInt(FMath::Clamp(Input.Forward, -1.f, 1.f) * MAX_int8));
+	NetInput.BodyYaw = FRotator::CompressAxisToShort(Input.BodyYaw);
+	NetInput.JumpPower = static_cast<uint16>(FMath::Clamp(FMath::RoundToInt(Input.JumpPower), 0, MAX_uint16));
+	return NetInput;
+}
+
+FSpiderMovementInput FSpiderNetInput::Dequantize() const
+{
+	return { static_cast<float>(Forward) / MAX_int8, FRotator::DecompressAxisFromShort(BodyYaw), static_cast<float>(JumpPower) };
+}
+
+bool FSpiderNetInputs::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << LastSequence;
+
+	uint32 Count{ static_cast<uint32>(FMath::Min(Inputs.Num(), MAX_INPUTS)) };
+	Ar.SerializeInt(Count, MAX_INPUTS + 1);
+	if (Ar.IsLoading())
+		Inputs.SetNum(Count);
+
+	// Oldest entries first, only the newest Count are sent when there are too many
+	const int32 First{ Inputs.Num() - static_cast<int32>(Count) };
+	for (int32 Index{ First }; Index < Inputs.Num(); ++Index)
+	{
+		FSpiderNetInput& Input{ Inputs[Index] };
+		Ar << Input.Forward;
+		Ar << Input.BodyYaw;
+
+		// Jumps are rare, one bit says whether there is one
+		uint8 Jumped{ Input.JumpPower > 0 };
+		Ar.SerializeBits(&Jumped, 1);
+		if (Jumped)
+			Ar << Input.JumpPower;
+		else
+			Input.JumpPower = 0;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+int32 FSpiderNetInputs::GetNetBits() const
+{
+	return MeasureNetBits(*this);
+}
+
+FSpiderNetState FSpiderNetState::FromSim(const FSpiderSimState& Sim, uint16 Sequence)
+{
+	FSpiderNetState NetState{};
+	NetState.Location = Sim.Location;
+	NetState.Normal = Sim.SurfaceRotation.GetUpVector();
+	NetState.Velocity = Sim.Velocity;
+	NetState.BodyYaw = Sim.BodyYaw;
+	NetState.State = Sim.State;
+	NetState.Sequence = Sequence;
+	NetState.StickPosition = Sim.StickPosition;
+	NetState.StickRotation = Sim.StickRotation;
+	NetState.LerpTimer = Sim.LerpTimer;
+	NetState.LerpRatio = Sim.LerpRatio;
+	NetState.JumpImmuneTimer = Sim.JumpImmuneTimer;
+	NetState.WebStart = Sim.StartLinePoint;
+	NetState.WebEnd = Sim.EndLinePoint;
+	return NetState;
+}
+
+void FSpiderNetState::ToSim(FSpiderSimState& Sim) const
+{
+	Sim.SurfaceRotation = FQuat::FindBetweenNormals(Sim.SurfaceRotation.GetUpVector(), Normal) * Sim.SurfaceRotation;
+	Sim.SurfaceRotation.Normalize();
+	Sim.Location = Location;
+	Sim.Velocity = Velocity;
+	Sim.BodyYaw = BodyYaw;
+	Sim.OldState = State;
+	Sim.State = State;
+
+	if (State == ESpiderState::Transition)
+	{
+		Sim.StickPosition = StickPosition;
+		Sim.StickRotation = StickRotation;
+		Sim.LerpTimer = LerpTimer;
+		Sim.LerpRatio = LerpRatio;
+	}
+	if (State == ESpiderState::Jumping)
+		Sim.JumpImmuneTimer = JumpImmuneTimer;
+	if (State == ESpiderState::OnWeb)
+	{
+		// The receiver's handle for this strand is looked up again from its ends
+		Sim.StartLinePoint = WebStart;
+		Sim.EndLinePoint = WebEnd;
+		Sim.WebStrand = INDEX_NONE;
+	}
+
+	// The strand offset is picked up again from the new location
+	Sim.WebAttached = false;
+}
+
+bool FSpiderNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = SerializePackedVector<10, 24>(Location, Ar);
+	SerializeNormal(Normal, Ar);
+	bOutSuccess &= SerializePackedVector<1, 24>(Velocity, Ar);
+
+	uint16 Yaw{ FRotator::CompressAxisToShort(BodyYaw) };
+	Ar << Yaw;
+	uint32 StateValue{ static_cast<uint32>(State) };
+	Ar.SerializeInt(StateValue, STATE_MAX);
+	if (Ar.IsLoading())
+	{
+		BodyYaw = FRotator::DecompressAxisFromShort(Yaw);
+		State = static_cast<ESpiderState>(FMath::Min(StateValue, static_cast<uint32>(SPIDER_STATE_COUNT - 1)));
+	}
+
+	Ar << Sequence;
+
+	// Only what the state needs to carry on the same way
+	if (State == ESpiderState::Transition)
+	{
+		bOutSuccess &= SerializePackedVector<10, 24>(StickPosition, Ar);
+		StickRotation.SerializeCompressedShort(Ar);
+		Ar << LerpTimer;
+		Ar << LerpRatio;
+	}
+	else if (State == ESpiderState::Jumping)
+	{
+		Ar << JumpImmuneTimer;
+	}
+	else if (State == ESpiderState::OnWeb)
+	{
+		bOutSuccess &= SerializePackedVector<10, 24>(WebStart, Ar);
+		bOutSuccess &= SerializePackedVector<10, 24>(WebEnd, Ar);
+	}
+
+	bOutSuccess &= !Ar.IsError();
+	return true;
+}
+
+bool FSpiderNetState::Identical(const FSpiderNetState* Other, uint32 PortFlags) const
+{
+	if (State != Other->State || Sequence != Other->Sequence
+		|| FRotator::CompressAxisToShort(BodyYaw) != FRotator::CompressAxisToShort(Other->BodyYaw)
+		|| !Location.Equals(Other->Location, 0.05)
+		|| !Velocity.Equals(Other->Velocity, 0.5)
+		|| !Normal.Equals(Other->Normal, 1.0 / NORMAL_STEPS))
+		return false;
+
+	if (State == ESpiderState::Transition)
+		return StickPosition.Equals(Other->StickPosition, 0.05) && LerpTimer == Other->LerpTimer;
+	if (State == ESpiderState::Jumping)
+		return JumpImmuneTimer == Other->JumpImmuneTimer;
+	if (State == ESpiderState::OnWeb)
+		return WebStart.Equals(Other->WebStart, 0.05) && WebEnd.Equals(Other->WebEnd, 0.05);
+	return true;
+}
+
+int32 FSpiderNetState::GetNetBits() const
+{
+	return MeasureNetBits(*this);
+}
+
+bool FSpiderNetState::IsNewer(uint16 A, uint16 B)
+{
+	return static_cast<int16>(A - B) > 0;
+}
@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderMovement.h"
+#include "SpiderNetMovement.generated.h"
+
+// One fixed step of the owning client's input, quantised the same way on both ends so prediction matches the server
+USTRUCT()
+struct FSpiderNetInput
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int8 Forward{};
+	UPROPERTY()
+	uint16 BodyYaw{};
+	UPROPERTY()
+	uint16 JumpPower{};
+
+	static FSpiderNetInput Quantize(const FSpiderMovementInput& Input);
+	FSpiderMovementInput Dequantize() const;
+};
+
+// A step of the owning client, kept until the server confirms or corrects it
+struct FSpiderNetStep
+{
+	uint16 Sequence{};
+	FSpiderNetInput Input{};
+	// After the step, what the server's state is compared to
+	FSpiderSimState State{};
+};
+
+// The client's latest steps, older ones are resent so a lost packet doesn't lose steps
+USTRUCT()
+struct FSpiderNetInputs
+{
+	GENERATED_BODY()
+
+	static constexpr int32 MAX_INPUTS{ 15 };
+
+	// Sequence of the last entry in Inputs
+	uint16 LastSequence{};
+	TArray<FSpiderNetInput> Inputs{};
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+	int32 GetNetBits() const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSpiderNetInputs> : public TStructOpsTypeTraitsBase2<FSpiderNetInputs>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+ * Replicated spider movement. Location to a tenth of a unit, the surface normal octahedral in 2x10 bits, body yaw in 16 bits
+ * and the state in 3. Lerp and jump timers and the strand's ends are only written in the states that use them.
+ */
+USTRUCT()
+struct FSpiderNetState
+{
+	GENERATED_BODY()
+
+	FVector Location{};
+	FVector Normal{ FVector::UnitZ() };
+	FVector Velocity{};
+	float BodyYaw{};
+	ESpiderState State{ ESpiderState::Fall };
+	// Last client input the server stepped, only meaningful to the owning client
+	uint16 Sequence{};
+
+	// Transition
+	FVector StickPosition{};
+	FRotator StickRotation{};
+	float LerpTimer{ FLT_MAX };
+	float LerpRatio{};
+
+	// Jumping
+	float JumpImmuneTimer{};
+
+	// OnWeb, the strand by its ends since segment handles are local to each machine
+	FVector WebStart{};
+	FVector WebEnd{};
+
+	static FSpiderNetState FromSim(const FSpiderSimState& Sim, uint16 Sequence);
+	// Onto Sim, the surface is turned the shortest way to the sent normal so the twist around it stays the receiver's
+	void ToSim(FSpiderSimState& Sim) const;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+	// Compared at the precision it is sent with, anything finer would replicate noise
+	bool Identical(const FSpiderNetState* Other, uint32 PortFlags) const;
+	int32 GetNetBits() const;
+
+	// Sequence numbers wrap, A is newer when it is less than half the range ahead
+	static bool IsNewer(uint16 A, uint16 B);
+};
+
+template<>
+struct TStructOpsTypeTraits<FSpiderNetState> : public TStructOpsTypeTraitsBase2<FSpiderNetState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdentical = true
+	};
+};
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderPreloadData.h"
+
+const FPrimaryAssetType USpiderPreloadData::PRIMARY_ASSET_TYPE{ TEXT("SpiderPreload") };
+const FName USpiderPreloadData::GAME_BUNDLE{ TEXT("Game") };
+
+FPrimaryAssetId USpiderPreloadData::GetPrimaryAssetId() const
+{
+	// Blueprint subclasses would otherwise register under their own class name
+	if (HasAnyFlags(RF_ClassDefaultObject))
+		return Super::GetPrimaryAssetId();
+
+	return { PRIMARY_ASSET_TYPE, GetFName() };
+}
+
+bool USpiderPreloadData::IsForLevel(const FSoftObjectPath& Level) const
+{
+	return Levels.IsEmpty() || Levels.ContainsByPredicate([&Level](const TSoftObjectPtr<UWorld>& Other)
+	{
+		return Other.ToSoftObjectPath() == Level;
+	});
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "SpiderPreloadData.generated.h"
+
+/**
+ * Assets a gameplay level needs before its first frame, loaded in the background from the main menu.
+ * One per group of assets (spider, fireflies, webs), the asset manager finds them as SpiderPreload primary assets.
+ * Everything is soft referenced and only loaded with the Game bundle, the data asset itself stays tiny.
+ */
+UCLASS(BlueprintType)
+class SPIDERGAME_API USpiderPreloadData : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetType PRIMARY_ASSET_TYPE;
+	static const FName GAME_BUNDLE;
+
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+
+	// Levels these assets are for, empty for every level
+	UPROPERTY(EditDefaultsOnly, Category="Preload")
+	TArray<TSoftObjectPtr<UWorld>> Levels{};
+
+	// Meshes, textures, materials, sounds
+	UPROPERTY(EditDefaultsOnly, Category="Preload", meta=(AssetBundles="Game"))
+	TArray<TSoftObjectPtr<UObject>> Assets{};
+	// Blueprints spawned during play, their defaults pull in the rest
+	UPROPERTY(EditDefaultsOnly, Category="Preload", meta=(AssetBundles="Game"))
+	TArray<TSoftClassPtr<UObject>> Classes{};
+
+	bool IsForLevel(const FSoftObjectPath& Level) const;
+};
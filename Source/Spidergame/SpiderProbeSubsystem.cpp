@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderProbeSubsystem.h"
+
+#include "SpiderStats.h"
+
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<bool> CVarSpiderAsyncProbes(
+	TEXT("Spider.Probes.Async"),
+	true,
+	TEXT("Fire spider surface probes as batched async traces and consume them the next frame.\n")
+	TEXT("0: trace synchronously every call"));
+
+static TAutoConsoleVariable<float> CVarSpiderProbeReuseDistance(
+	TEXT("Spider.Probes.MaxReuseDistance"),
+	50.f,
+	TEXT("Max distance a ray may have moved since last frame before its async result is thrown away for a sync trace"));
+
+static TAutoConsoleVariable<float> CVarSpiderProbeReuseAngle(
+	TEXT("Spider.Probes.MaxReuseAngle"),
+	5.f,
+	TEXT("Max angle in degrees a ray may have turned since last frame before its async result is thrown away for a sync trace"));
+
+void USpiderProbeSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	m_PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &USpiderProbeSubsystem::FlushProbes);
+}
+
+void USpiderProbeSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(m_PostActorTickHandle);
+	m_Owners.Empty();
+	Super::Deinitialize();
+}
+
+void USpiderProbeSubsystem::Register(const AActor* Owner)
+{
+	if (Owner == nullptr)
+		return;
+
+	// Build the query params once instead of every trace
+	FProbeOwner& ProbeOwner{ m_Owners.FindOrAdd(Owner) };
+	ProbeOwner.Params = FCollisionQueryParams{ SCENE_QUERY_STAT(SpiderProbe), false, Owner };
+}
+
+void USpiderProbeSubsystem::Unregister(const AActor* Owner)
+{
+	m_Owners.Remove(Owner);
+}
+
+bool USpiderProbeSubsystem::Probe(const AActor* Owner, ESpiderProbe ProbeType, const FVector& Start, const FVector& End, FHitResult& OutHit)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SpiderProbe);
+
+	FProbeOwner* ProbeOwner{ m_Owners.Find(Owner) };
+	if (ProbeOwner == nullptr)
+	{
+		Register(Owner);
+		ProbeOwner = m_Owners.Find(Owner);
+	}
+
+	if (!IsAsync())
+		return TraceSync(*ProbeOwner, Start, End, OutHit);
+
+	FProbeSlot& Slot{ ProbeOwner->Slots[static_cast<int32>(ProbeType)] };
+
+	// Queue this frame's ray, the latest request wins
+	Slot.PendingStart = Start;
+	Slot.PendingEnd = End;
+	Slot.bPending = true;
+
+	if (TryConsumeAsync(Slot, Start, End, OutHit))
+	{
+		INC_DWORD_STAT(STAT_SpiderReusedProbes);
+		return OutHit.bBlockingHit;
+	}
+
+	return TraceSync(*ProbeOwner, Start, End, OutHit);
+}
+
+bool USpiderProbeSubsystem::IsAsync()
+{
+	return CVarSpiderAsyncProbes.GetValueOnGameThread();
+}
+
+int32 USpiderProbeSubsystem::GetSyncTraceCount() const
+{
+	return m_SyncTraces;
+}
+
+int32 USpiderProbeSubsystem::GetAsyncTraceCount() const
+{
+	return m_AsyncTraces;
+}
+
+void USpiderProbeSubsystem::ResetTraceCounts()
+{
+	m_SyncTraces = 0;
+	m_AsyncTraces = 0;
+}
+
+bool USpiderProbeSubsystem::TraceSync(const FProbeOwner& Owner, const FVector& Start, const FVector& End, FHitResult& OutHit) const
+{
+	++m_SyncTraces;
+	INC_DWORD_STAT(STAT_SpiderSyncTraces);
+	CSV_CUSTOM_STAT(Spider, SyncTraces, 1, ECsvCustomStatOp::Accumulate);
+	OutHit = {};
+	return GetWorld()->LineTraceSingleByObjectType(OutHit, Start, End, m_SurfaceQuery, Owner.Params);
+}
+
+bool USpiderProbeSubsystem::TryConsumeAsync(FProbeSlot& Slot, const FVector& Start, const FVector& End, FHitResult& OutHit) const
+{
+	// Handles are only valid for one frame and the ray was fired from where the spider was then,
+	// a second request in the same frame (another fixed step, a re-probe after moving) traces again
+	FTraceDatum Datum{};
+	if (Slot.bConsumed || !Slot.Handle.IsValid() || !GetWorld()->QueryTraceData(Slot.Handle, Datum))
+		return false;
+
+	Slot.bConsumed = true;
+
+	// Too far from last frame's ray to trust the result
+	const double MaxDistance{ CVarSpiderProbeReuseDistance.GetValueOnGameThread() };
+	if (FVector::DistSquared(Start, Slot.IssuedStart) > MaxDistance * MaxDistance)
+		return false;
+
+	const double MinCosAngle{ FMath::Cos(FMath::DegreesToRadians(CVarSpiderProbeReuseAngle.GetValueOnGameThread())) };
+	if ((End - Start).GetSafeNormal().Dot((Slot.IssuedEnd - Slot.IssuedStart).GetSafeNormal()) < MinCosAngle)
+		return false;
+
+	OutHit = {};
+	for (const FHitResult& Hit : Datum.OutHits)
+	{
+		if (Hit.bBlockingHit)
+		{
+			OutHit = Hit;
+			break;
+		}
+	}
+
+	// Move the hit along with the ray so sticking to it doesn't pull the spider back a frame
+	const FVector Offset{ Start - Slot.IssuedStart };
+	OutHit.Location += Offset;
+	OutHit.ImpactPoint += Offset;
+	OutHit.TraceStart = Start;
+	OutHit.TraceEnd = End;
+	return true;
+}
+
+void USpiderProbeSubsystem::FlushProbes(UWorld* World, ELevelTick TickType, float DeltaTime)
+{
+	if (World != GetWorld() || !IsAsync())
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SpiderProbeFlush);
+
+	// One batch for every spider in the world
+	for (TPair<TObjectKey<AActor>, FProbeOwner>& Pair : m_Owners)
+	{
+		FProbeOwner& Owner{ Pair.Value };
+		for (FProbeSlot& Slot : Owner.Slots)
+		{
+			if (!Slot.bPending)
+			{
+				Slot.Handle = {};
+				continue;
+			}
+
+			Slot.Handle = World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Slot.PendingStart, Slot.PendingEnd, m_SurfaceQuery, Owner.Params);
+			Slot.bConsumed = false;
+			Slot.IssuedStart = Slot.PendingStart;
+			Slot.IssuedEnd = Slot.PendingEnd;
+			Slot.bPending = false;
+			++m_AsyncTraces;
+			INC_DWORD_STAT(STAT_SpiderAsyncTraces);
+			CSV_CUSTOM_STAT(Spider, AsyncTraces, 1, ECsvCustomStatOp::Accumulate);
+		}
+	}
+}
@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "SpiderCollision.h"
+#include "SpiderMovement.h"
+#include "SpiderProbeSubsystem.generated.h"
+
+/**
+ * Gathers the surface probes of every spider in the world and fires them as one batch of async traces
+ * at the end of the actor tick. Results are handed back the next frame, to the first time the spider asks for the same probe again.
+ * Falls back to a synchronous trace when no usable result is available (first frame, big jumps, Spider.Probes.Async 0).
+ */
+UCLASS()
+class SPIDERGAME_API USpiderProbeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void Register(const AActor* Owner);
+	void Unregister(const AActor* Owner);
+
+	// Returns true on a blocking hit
+	bool Probe(const AActor* Owner, ESpiderProbe ProbeType, const FVector& Start, const FVector& End, FHitResult& OutHit);
+
+	static bool IsAsync();
+
+	// Traces fired since the last reset, sync fallbacks and async batch entries
+	int32 GetSyncTraceCount() const;
+	int32 GetAsyncTraceCount() const;
+	void ResetTraceCounts();
+
+private:
+	struct FProbeSlot
+	{
+		// Ray requested this frame, fired in FlushProbes
+		FVector PendingStart{};
+		FVector PendingEnd{};
+		bool bPending{ false };
+
+		// Ray fired last frame
+		FVector IssuedStart{};
+		FVector IssuedEnd{};
+		FTraceHandle Handle{};
+		// Last frame's result is handed out once, later substeps and re-probes trace again
+		bool bConsumed{ false };
+	};
+
+	struct FProbeOwner
+	{
+		FCollisionQueryParams Params{};
+		FProbeSlot Slots[static_cast<int32>(ESpiderProbe::Count)]{};
+	};
+
+	TMap<TObjectKey<AActor>, FProbeOwner> m_Owners{};
+	// Only what a spider can stand on, by object type
+	FCollisionObjectQueryParams m_SurfaceQuery{ MakeSpiderSurfaceQuery() };
+	FDelegateHandle m_PostActorTickHandle{};
+	mutable int32 m_SyncTraces{};
+	int32 m_AsyncTraces{};
+
+	bool TraceSync(const FProbeOwner& Owner, const FVector& Start, const FVector& End, FHitResult& OutHit) const;
+	bool TryConsumeAsync(FProbeSlot& Slot, const FVector& Start, const FVector& End, FHitResult& OutHit) const;
+	void FlushProbes(UWorld* World, ELevelTick TickType, float DeltaTime);
+};
@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderRecording.h"
+
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+namespace
+{
+	// Frame flags, fields without their flag are the same as the previous frame
+	enum EFrameFlags : uint8
+	{
+		DeltaTimeChanged = 1 << 0,
+		MoveChanged = 1 << 1,
+		RotationChanged = 1 << 2,
+		Jumped = 1 << 3,
+		WebAction = 1 << 4
+	};
+
+	void SerializeFrame(FArchive& Ar, FSpiderRecordedFrame& Frame, const FSpiderRecordedFrame& Previous)
+	{
+		uint8 Flags{};
+		if (Ar.IsSaving())
+		{
+			Flags |= Frame.DeltaTime != Previous.DeltaTime ? DeltaTimeChanged : 0;
+			Flags |= Frame.Move != Previous.Move ? MoveChanged : 0;
+			Flags |= Frame.ControlRotation != Previous.ControlRotation ? RotationChanged : 0;
+			Flags |= Frame.JumpPower > 0.f ? Jumped : 0;
+			Flags |= Frame.WebActions != 0 ? WebAction : 0;
+		}
+		Ar << Flags;
+
+		if (Ar.IsLoading())
+			Frame = { Previous.DeltaTime, Previous.Move, Previous.ControlRotation };
+
+		if (Flags & DeltaTimeChanged)
+			Ar << Frame.DeltaTime;
+		if (Flags & MoveChanged)
+			Ar << Frame.Move;
+		if (Flags & RotationChanged)
+		{
+			// Roll is never used by the spider
+			Ar << Frame.ControlRotation.Pitch;
+			Ar << Frame.ControlRotation.Yaw;
+		}
+		if (Flags & Jumped)
+			Ar << Frame.JumpPower;
+		if (Flags & WebAction)
+			Ar << Frame.WebActions;
+	}
+
+	void SerializeState(FArchive& Ar, FSpiderSimState& State)
+	{
+		uint8 StateValue{ static_cast<uint8>(State.State) };
+		uint8 OldStateValue{ static_cast<uint8>(State.OldState) };
+		Ar << StateValue;
+		Ar << OldStateValue;
+		State.State = static_cast<ESpiderState>(FMath::Min<uint8>(StateValue, SPIDER_STATE_COUNT - 1));
+		State.OldState = static_cast<ESpiderState>(FMath::Min<uint8>(OldStateValue, SPIDER_STATE_COUNT - 1));
+
+		Ar << State.Location;
+		Ar << State.SurfaceRotation;
+		Ar << State.BodyYaw;
+		Ar << State.Velocity;
+		Ar << State.JumpImmuneTimer;
+		Ar << State.StickPosition;
+		Ar << State.StickRotation;
+		Ar << State.LerpTimer;
+		Ar << State.LerpRatio;
+		Ar << State.StartLinePoint;
+		Ar << State.EndLinePoint;
+
+		// Strand handles only mean something in the world that made them
+		if (Ar.IsLoading())
+		{
+			State.WebStrand = INDEX_NONE;
+			State.WebAttached = false;
+		}
+	}
+}
+
+bool FSpiderRecording::Save(const FString& Path) const
+{
+	// Serialize is shared with loading, it writes from a copy
+	FSpiderRecording Copy{ *this };
+	TArray<uint8> Bytes{};
+	FMemoryWriter Writer{ Bytes };
+	Copy.Serialize(Writer);
+	return !Writer.IsError() && FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
+
+bool FSpiderRecording::Load(const FString& Path)
+{
+	TArray<uint8> Bytes{};
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+		return false;
+
+	FMemoryReader Reader{ Bytes };
+	Serialize(Reader);
+	return !Reader.IsError() && !Frames.IsEmpty() && !Snapshots.IsEmpty();
+}
+
+FString FSpiderRecording::MakePath(const FString& Name)
+{
+	return FPaths::ProfilingDir() / TEXT("SpiderRecordings") / FString::Printf(TEXT("%s-%s.spiderrec"), *Name, *FDateTime::Now().ToString());
+}
+
+void FSpiderRecording::Serialize(FArchive& Ar)
+{
+	uint32 Magic{ MAGIC };
+	uint32 Version{ VERSION };
+	Ar << Magic;
+	Ar << Version;
+	if (Magic != MAGIC || Version != VERSION)
+	{
+		Ar.SetError();
+		return;
+	}
+
+	Ar << MapPath;
+	Ar << StepTime;
+	Ar << MaxSteps;
+
+	int32 FrameCount{ Frames.Num() };
+	Ar << FrameCount;
+	if (Ar.IsLoading())
+	{
+		// Every frame takes at least a byte
+		if (FrameCount < 0 || FrameCount > Ar.TotalSize())
+		{
+			Ar.SetError();
+			return;
+		}
+		Frames.SetNum(FrameCount);
+	}
+
+	FSpiderRecordedFrame Previous{};
+	for (FSpiderRecordedFrame& Frame : Frames)
+	{
+		SerializeFrame(Ar, Frame, Previous);
+		Previous = Frame;
+		if (Ar.IsError())
+			return;
+	}
+
+	int32 SnapshotCount{ Snapshots.Num() };
+	Ar << SnapshotCount;
+	if (Ar.IsLoading())
+	{
+		if (SnapshotCount < 0 || SnapshotCount > Ar.TotalSize())
+		{
+			Ar.SetError();
+			return;
+		}
+		Snapshots.SetNum(SnapshotCount);
+	}
+
+	for (FSpiderRecordedSnapshot& Snapshot : Snapshots)
+	{
+		Ar << Snapshot.Frame;
+		SerializeState(Ar, Snapshot.State);
+	}
+}
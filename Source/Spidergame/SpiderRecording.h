@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpiderMovement.h"
+#include "SpiderRecording.generated.h"
+
+// Web input is handled in Blueprint, the pawn only hears about it to record and replay it
+UENUM(BlueprintType)
+enum class ESpiderWebAction : uint8
+{
+	ShootWeb,
+	StartWebStructure,
+	ConfirmWebStructure,
+	CancelWeb,
+	Count UMETA(Hidden)
+};
+
+// Everything that drove the spider for one frame, exact so a replay steps the same
+struct FSpiderRecordedFrame
+{
+	float DeltaTime{};
+	// Pending movement input vector, only X and Y are used
+	FVector2f Move{};
+	FRotator3f ControlRotation{};
+	float JumpPower{};
+	// Bit per ESpiderWebAction
+	uint8 WebActions{};
+};
+
+// Simulation state before a frame, replays start from the first one and check against the rest
+struct FSpiderRecordedSnapshot
+{
+	int32 Frame{};
+	FSpiderSimState State{};
+};
+
+/**
+ * One spider's session in a compact binary file. Frames only store what changed since the previous one,
+ * a second of walking around costs a few hundred bytes.
+ */
+class SPIDERGAME_API FSpiderRecording
+{
+public:
+	static constexpr int32 SNAPSHOT_INTERVAL{ 60 };
+
+	// Package of the map it was recorded in, without a PIE prefix
+	FString MapPath{};
+	// Fixed step settings of the recorded spider, a replay with others won't match
+	float StepTime{};
+	int32 MaxSteps{};
+	TArray<FSpiderRecordedFrame> Frames{};
+	TArray<FSpiderRecordedSnapshot> Snapshots{};
+
+	bool Save(const FString& Path) const;
+	bool Load(const FString& Path);
+
+	// Saved/Profiling/SpiderRecordings/<Name>-<Date>.spiderrec
+	static FString MakePath(const FString& Name);
+
+private:
+	static constexpr uint32 MAGIC{ 0x43525053 };
+	static constexpr uint32 VERSION{ 1 };
+
+	void Serialize(FArchive& Ar);
+};
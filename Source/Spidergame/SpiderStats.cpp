@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "SpiderStats.h"
+
+DEFINE_STAT(STAT_SpiderSimulate);
+DEFINE_STAT(STAT_SpiderGround);
+DEFINE_STAT(STAT_SpiderTransition);
+DEFINE_STAT(STAT_SpiderFall);
+DEFINE_STAT(STAT_SpiderOnWeb);
+DEFINE_STAT(STAT_SpiderJumping);
+DEFINE_STAT(STAT_SpiderSweep);
+DEFINE_STAT(STAT_SpiderProbe);
+DEFINE_STAT(STAT_SpiderProbeFlush);
+DEFINE_STAT(STAT_SpiderBatchIntegrate);
+DEFINE_STAT(STAT_SpiderBatchDecide);
+DEFINE_STAT(STAT_SpiderBatchMove);
+DEFINE_STAT(STAT_SpiderLegs);
+DEFINE_STAT(STAT_WebMeshBuild);
+DEFINE_STAT(STAT_WebShooter);
+
+DEFINE_STAT(STAT_SpiderSyncTraces);
+DEFINE_STAT(STAT_SpiderAsyncTraces);
+DEFINE_STAT(STAT_SpiderReusedProbes);
+DEFINE_STAT(STAT_SpiderContactCacheHits);
+DEFINE_STAT(STAT_SpiderStateChanges);
+DEFINE_STAT(STAT_SpiderSoundToggles);
+DEFINE_STAT(STAT_SpiderBatched);
+DEFINE_STAT(STAT_SpiderNetCorrections);
+DEFINE_STAT(STAT_SpiderLegTraces);
+DEFINE_STAT(STAT_SpiderWebShotTraces);
+
+CSV_DEFINE_CATEGORY_MODULE(SPIDERGAME_API, Spider, true);
+
+#if SPIDER_TRACE_ENABLED
+UE_TRACE_CHANNEL_DEFINE(SpiderChannel);
+
+UE_TRACE_EVENT_BEGIN(Spider, StateChange)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, SpiderId)
+	UE_TRACE_EVENT_FIELD(uint8, OldState)
+	UE_TRACE_EVENT_FIELD(uint8, NewState)
+UE_TRACE_EVENT_END()
+
+void SpiderTrace::StateChanged(uint32 SpiderId, uint8 OldState, uint8 NewState)
+{
+	UE_TRACE_LOG(Spider, StateChange, SpiderChannel)
+		<< StateChange.Cycle(FPlatformTime::Cycles64())
+		<< StateChange.SpiderId(SpiderId)
+		<< StateChange.OldState(OldState)
+		<< StateChange.NewState(NewState);
+}
+#endif
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+// Everything here compiles to nothing in Shipping, stat and CSV macros already do, the trace channel is guarded below
+// stat Spider, csvprofile start, or -trace=default,Spider for Insights
+
+DECLARE_STATS_GROUP(TEXT("Spider"), STATGROUP_Spider, STATCAT_Advanced);
+
+// Cycles
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Simulate"), STAT_SpiderSimulate, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("State Ground"), STAT_SpiderGround, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("State Transition"), STAT_SpiderTransition, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("State Fall"), STAT_SpiderFall, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("State OnWeb"), STAT_SpiderOnWeb, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("State Jumping"), STAT_SpiderJumping, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Move sweep"), STAT_SpiderSweep, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Probe"), STAT_SpiderProbe, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Probe flush"), STAT_SpiderProbeFlush, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch integrate"), STAT_SpiderBatchIntegrate, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch decide"), STAT_SpiderBatchDecide, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Batch move"), STAT_SpiderBatchMove, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Leg IK"), STAT_SpiderLegs, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Web mesh build"), STAT_WebMeshBuild, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Web shots"), STAT_WebShooter, STATGROUP_Spider, SPIDERGAME_API);
+
+// Counters, reset every frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sync traces"), STAT_SpiderSyncTraces, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Async traces"), STAT_SpiderAsyncTraces, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Reused probes"), STAT_SpiderReusedProbes, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Cached ground hits"), STAT_SpiderContactCacheHits, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("State changes"), STAT_SpiderStateChanges, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Sound toggles"), STAT_SpiderSoundToggles, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Batched spiders"), STAT_SpiderBatched, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net corrections"), STAT_SpiderNetCorrections, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Leg traces"), STAT_SpiderLegTraces, STATGROUP_Spider, SPIDERGAME_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Web shot traces"), STAT_SpiderWebShotTraces, STATGROUP_Spider, SPIDERGAME_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(SPIDERGAME_API, Spider);
+
+#define SPIDER_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+#if SPIDER_TRACE_ENABLED
+UE_TRACE_CHANNEL_EXTERN(SpiderChannel, SPIDERGAME_API);
+
+namespace SpiderTrace
+{
+	// Spider.StateChange event with the spider's id and the state indices
+	SPIDERGAME_API void StateChanged(uint32 SpiderId, uint8 OldState, uint8 NewState);
+}
+
+#define TRACE_SPIDER_STATE_CHANGE(SpiderId, OldState, NewState) SpiderTrace::StateChanged(SpiderId, static_cast<uint8>(OldState), static_cast<uint8>(NewState))
+#else
+#define TRACE_SPIDER_STATE_CHANGE(SpiderId, OldState, NewState)
+#endif
@@ -3,3 +3,80 @@
 
 #include "SpidergameGameModeBase.h"
 
+#include "BaseSpider.h"
+#include "EngineUtils.h"
+#include "Kismet/GameplayStatics.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogFireflyPool, Log, All);
+DEFINE_LOG_CATEGORY_STATIC(LogSpiderNet, Log, All);
+
+void ASpidergameGameModeBase::StartPlay()
+{
+	m_FireflyPool = NewObject<UFireflyPool>(this);
+	m_FireflyPool->Initialize(FireflyClass);
+	m_FireflyPool->Prewarm(FireflyPrewarmCount);
+
+	Super::StartPlay();
+}
+
+APawn* ASpidergameGameModeBase::AcquireFirefly(const FTransform& Transform)
+{
+	return m_FireflyPool ? m_FireflyPool->Acquire(Transform) : nullptr;
+}
+
+void ASpidergameGameModeBase::ReleaseFirefly(APawn* Firefly)
+{
+	if (m_FireflyPool)
+		m_FireflyPool->Release(Firefly);
+	else if (Firefly)
+		Firefly->Destroy();
+}
+
+FFireflyPoolStats ASpidergameGameModeBase::GetFireflyPoolStats() const
+{
+	return m_FireflyPool ? m_FireflyPool->GetStats() : FFireflyPoolStats{};
+}
+
+float ASpidergameGameModeBase::GetFireflyPoolHitRate() const
+{
+	return m_FireflyPool ? m_FireflyPool->GetHitRate() : 0.f;
+}
+
+void ASpidergameGameModeBase::DumpFireflyPool() const
+{
+	const FFireflyPoolStats Stats{ GetFireflyPoolStats() };
+	UE_LOG(LogFireflyPool, Display, TEXT("Fireflies: %d active, %d pooled, %d acquires, %d releases, %.1f%% hit rate"),
+		Stats.Active, Stats.Pooled, Stats.Acquires, Stats.Releases, GetFireflyPoolHitRate() * 100.f);
+}
+
+void ASpidergameGameModeBase::DumpSpiderBandwidth() const
+{
+	float Total{};
+	int32 Count{};
+	for (TActorIterator<ABaseSpider> It{ GetWorld() }; It; ++It)
+	{
+		const float BytesPerSecond{ It->GetNetBytesPerSecond() };
+		UE_LOG(LogSpiderNet, Display, TEXT("%s: %.1f bytes/s at %.0f Hz"), *It->GetName(), BytesPerSecond, It->NetUpdateFrequency);
+		Total += BytesPerSecond;
+		++Count;
+	}
+	UE_LOG(LogSpiderNet, Display, TEXT("Spiders: %d, %.1f bytes/s total"), Count, Total);
+}
+
+void ASpidergameGameModeBase::StartSpiderRecording() const
+{
+	if (ABaseSpider* Spider{ Cast<ABaseSpider>(UGameplayStatics::GetPlayerPawn(this, 0)) })
+		Spider->StartRecording();
+}
+
+void ASpidergameGameModeBase::StopSpiderRecording() const
+{
+	if (ABaseSpider* Spider{ Cast<ABaseSpider>(UGameplayStatics::GetPlayerPawn(this, 0)) })
+		Spider->StopRecording();
+}
+
+void ASpidergameGameModeBase::ReplaySpiderRecording(const FString& Path) const
+{
+	if (ABaseSpider* Spider{ Cast<ABaseSpider>(UGameplayStatics::GetPlayerPawn(this, 0)) })
+		Spider->StartReplayFromFile(Path);
+}
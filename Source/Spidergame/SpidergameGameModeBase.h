@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/GameModeBase.h"
+#include "FireflyPool.h"
 #include "SpidergameGameModeBase.generated.h"
 
 /**
@@ -13,5 +14,43 @@ UCLASS()
 class SPIDERGAME_API ASpidergameGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
+
+public:
+	virtual void StartPlay() override;
+
+	// Spawners should get fireflies from here instead of spawning them
+	UFUNCTION(BlueprintCallable, Category="Firefly")
+	APawn* AcquireFirefly(const FTransform& Transform);
+	// Eaten or dead fireflies go back here instead of being destroyed
+	UFUNCTION(BlueprintCallable, Category="Firefly")
+	void ReleaseFirefly(APawn* Firefly);
+
+	UFUNCTION(BlueprintPure, Category="Firefly")
+	FFireflyPoolStats GetFireflyPoolStats() const;
+	UFUNCTION(BlueprintPure, Category="Firefly")
+	float GetFireflyPoolHitRate() const;
+
+	UFUNCTION(Exec)
+	void DumpFireflyPool() const;
+	// Movement replication per spider over the last second
+	UFUNCTION(Exec)
+	void DumpSpiderBandwidth() const;
+	// Record the first player's spider, replay plays a recording back on it
+	UFUNCTION(Exec)
+	void StartSpiderRecording() const;
+	UFUNCTION(Exec)
+	void StopSpiderRecording() const;
+	UFUNCTION(Exec)
+	void ReplaySpiderRecording(const FString& Path) const;
+
+protected:
+	UPROPERTY(EditDefaultsOnly, Category="Firefly")
+	TSubclassOf<APawn> FireflyClass{};
+	// Fireflies spawned at level load so the first waves don't have to
+	UPROPERTY(EditDefaultsOnly, Category="Firefly", meta=(ClampMin=0))
+	int32 FireflyPrewarmCount{ 32 };
+
+private:
+	UPROPERTY(Transient)
+	TObjectPtr<UFireflyPool> m_FireflyPool{};
 };
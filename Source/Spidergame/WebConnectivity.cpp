@@ -0,0 +1,393 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "WebConnectivity.h"
+
+FWebConnectivity::FWebConnectivity(float JunctionDistance)
+	: m_JunctionDistance{ FMath::Max(JunctionDistance, UE_KINDA_SMALL_NUMBER) }
+{
+}
+
+#pragma region Segments
+// ==============================================================================
+// Segments
+// ==============================================================================
+
+void FWebConnectivity::AddSegment(int32 Segment, const FVector& Start, const FVector& End, bool StartAnchored, bool EndAnchored)
+{
+	if (HasSegment(Segment))
+	{
+		TArray<TArray<int32>> Detached{};
+		RemoveSegment(Segment, Detached);
+	}
+
+	const int32 StartNode{ FindOrAddNode(Start, StartAnchored) };
+	const int32 EndNode{ FindOrAddNode(End, EndAnchored) };
+	m_Nodes[StartNode].Segments.Add(Segment);
+	if (EndNode != StartNode)
+		m_Nodes[EndNode].Segments.Add(Segment);
+
+	while (m_SegmentNodes.Num() <= Segment)
+		m_SegmentNodes.Add({ INDEX_NONE, INDEX_NONE });
+	m_SegmentNodes[Segment] = { StartNode, EndNode };
+
+	MergeIslands(m_Nodes[StartNode].Island, m_Nodes[EndNode].Island);
+}
+
+void FWebConnectivity::RemoveSegment(int32 Segment, TArray<TArray<int32>>& OutDetached)
+{
+	if (!HasSegment(Segment))
+		return;
+
+	const int32 StartNode{ m_SegmentNodes[Segment].X };
+	const int32 EndNode{ m_SegmentNodes[Segment].Y };
+	m_SegmentNodes[Segment] = { INDEX_NONE, INDEX_NONE };
+
+	const int32 Island{ m_Nodes[StartNode].Island };
+	const bool WasAnchored{ m_Islands[Island].Anchors > 0 };
+
+	m_Nodes[StartNode].Segments.RemoveSingleSwap(Segment, false);
+	m_Nodes[EndNode].Segments.RemoveSingleSwap(Segment, false);
+
+	// Loose ends disappear with their last strand, their anchor with them
+	const bool StartLeft{ !m_Nodes[StartNode].Segments.IsEmpty() };
+	const bool EndLeft{ EndNode != StartNode && !m_Nodes[EndNode].Segments.IsEmpty() };
+	if (!StartLeft)
+		RemoveNode(StartNode);
+	if (EndNode != StartNode && !EndLeft)
+		RemoveNode(EndNode);
+
+	// Only a strand between two nodes that stay can cut an island in two
+	int32 SplitOff{ INDEX_NONE };
+	if (StartLeft && EndLeft)
+	{
+		TArray<int32> Split{};
+		FindSplit(StartNode, EndNode, Split);
+		if (!Split.IsEmpty())
+		{
+			SplitIsland(Split);
+			SplitOff = m_Nodes[Split[0]].Island;
+		}
+	}
+
+	if (!WasAnchored)
+		return;
+
+	if (m_Islands.IsValidIndex(Island) && m_Islands[Island].Anchors == 0)
+		CollectSegments(Island, OutDetached.AddDefaulted_GetRef());
+	if (SplitOff != INDEX_NONE && m_Islands[SplitOff].Anchors == 0)
+		CollectSegments(SplitOff, OutDetached.AddDefaulted_GetRef());
+}
+
+void FWebConnectivity::MoveSegment(int32 Segment, const FVector& Start, const FVector& End)
+{
+	if (!HasSegment(Segment))
+		return;
+
+	MoveNode(m_SegmentNodes[Segment].X, Start);
+	MoveNode(m_SegmentNodes[Segment].Y, End);
+}
+
+void FWebConnectivity::Reset()
+{
+	m_Nodes.Empty();
+	m_Islands.Empty();
+	m_SegmentNodes.Empty();
+	m_NodeCells.Empty();
+	m_VisitStamps.Empty();
+	m_VisitSides.Empty();
+}
+
+bool FWebConnectivity::IsAnchored(int32 Segment) const
+{
+	// Unknown segments aren't ours to drop
+	if (!HasSegment(Segment))
+		return true;
+
+	return m_Islands[m_Nodes[m_SegmentNodes[Segment].X].Island].Anchors > 0;
+}
+
+bool FWebConnectivity::IsDetached(int32 Segment) const
+{
+	if (!HasSegment(Segment))
+		return false;
+
+	const FIsland& Island{ m_Islands[m_Nodes[m_SegmentNodes[Segment].X].Island] };
+	return Island.WasAnchored && Island.Anchors == 0;
+}
+
+bool FWebConnectivity::IsEndAnchored(int32 Segment, bool AtEnd) const
+{
+	if (!HasSegment(Segment))
+		return false;
+
+	const FIntPoint& Nodes{ m_SegmentNodes[Segment] };
+	return m_Nodes[AtEnd ? Nodes.Y : Nodes.X].Anchored;
+}
+
+void FWebConnectivity::AnchorEnd(int32 Segment, bool AtEnd)
+{
+	if (!HasSegment(Segment))
+		return;
+
+	const FIntPoint& Nodes{ m_SegmentNodes[Segment] };
+	AnchorNode(AtEnd ? Nodes.Y : Nodes.X);
+}
+
+void FWebConnectivity::GetIsland(int32 Segment, TArray<int32>& OutSegments) const
+{
+	OutSegments.Reset();
+	if (HasSegment(Segment))
+		CollectSegments(m_Nodes[m_SegmentNodes[Segment].X].Island, OutSegments);
+}
+
+int32 FWebConnectivity::GetNumIslands() const
+{
+	return m_Islands.Num();
+}
+
+bool FWebConnectivity::HasSegment(int32 Segment) const
+{
+	return m_SegmentNodes.IsValidIndex(Segment) && m_SegmentNodes[Segment].X != INDEX_NONE;
+}
+
+#pragma endregion Segments
+
+#pragma region Nodes
+// ==============================================================================
+// Nodes
+// ==============================================================================
+
+FIntVector FWebConnectivity::ToCell(const FVector& Location) const
+{
+	return {
+		FMath::FloorToInt32(Location.X / m_JunctionDistance),
+		FMath::FloorToInt32(Location.Y / m_JunctionDistance),
+		FMath::FloorToInt32(Location.Z / m_JunctionDistance)
+	};
+}
+
+int32 FWebConnectivity::FindOrAddNode(const FVector& Location, bool Anchored)
+{
+	// Anything within the junction distance is in this cell or a neighbour
+	const FIntVector Cell{ ToCell(Location) };
+	int32 Closest{ INDEX_NONE };
+	double ClosestDistanceSquared{ FMath::Square(m_JunctionDistance) };
+	for (int32 X{ -1 }; X <= 1; ++X)
+		for (int32 Y{ -1 }; Y <= 1; ++Y)
+			for (int32 Z{ -1 }; Z <= 1; ++Z)
+			{
+				const TArray<int32>* Nodes{ m_NodeCells.Find(Cell + FIntVector{ X, Y, Z }) };
+				if (Nodes == nullptr)
+					continue;
+
+				for (const int32 Node : *Nodes)
+				{
+					const double DistanceSquared{ FVector::DistSquared(Location, m_Nodes[Node].Location) };
+					if (DistanceSquared <= ClosestDistanceSquared)
+					{
+						ClosestDistanceSquared = DistanceSquared;
+						Closest = Node;
+					}
+				}
+			}
+
+	if (Closest != INDEX_NONE)
+	{
+		if (Anchored)
+			AnchorNode(Closest);
+		return Closest;
+	}
+
+	FNode NewNode{};
+	NewNode.Location = Location;
+	NewNode.Anchored = Anchored;
+	const int32 Node{ m_Nodes.Add(MoveTemp(NewNode)) };
+	m_NodeCells.FindOrAdd(Cell).Add(Node);
+
+	// Every node starts out as its own island
+	AddToIsland(Node, m_Islands.Add({}));
+	return Node;
+}
+
+void FWebConnectivity::RemoveNode(int32 Node)
+{
+	const int32 Island{ m_Nodes[Node].Island };
+	RemoveFromIsland(Node);
+	if (m_Islands[Island].Nodes.IsEmpty())
+		m_Islands.RemoveAt(Island);
+
+	const FIntVector Cell{ ToCell(m_Nodes[Node].Location) };
+	if (TArray<int32>* Nodes{ m_NodeCells.Find(Cell) })
+	{
+		Nodes->RemoveSingleSwap(Node, false);
+		if (Nodes->IsEmpty())
+			m_NodeCells.Remove(Cell);
+	}
+
+	m_Nodes.RemoveAt(Node);
+}
+
+void FWebConnectivity::MoveNode(int32 Node, const FVector& Location)
+{
+	const FIntVector OldCell{ ToCell(m_Nodes[Node].Location) };
+	const FIntVector NewCell{ ToCell(Location) };
+	m_Nodes[Node].Location = Location;
+	if (OldCell == NewCell)
+		return;
+
+	if (TArray<int32>* Nodes{ m_NodeCells.Find(OldCell) })
+	{
+		Nodes->RemoveSingleSwap(Node, false);
+		if (Nodes->IsEmpty())
+			m_NodeCells.Remove(OldCell);
+	}
+	m_NodeCells.FindOrAdd(NewCell).Add(Node);
+}
+
+void FWebConnectivity::AnchorNode(int32 Node)
+{
+	FNode& NodeData{ m_Nodes[Node] };
+	if (NodeData.Anchored)
+		return;
+
+	NodeData.Anchored = true;
+	FIsland& Island{ m_Islands[NodeData.Island] };
+	++Island.Anchors;
+	Island.WasAnchored = true;
+}
+
+#pragma endregion Nodes
+
+#pragma region Islands
+// ==============================================================================
+// Islands
+// ==============================================================================
+
+void FWebConnectivity::AddToIsland(int32 Node, int32 Island)
+{
+	FNode& NodeData{ m_Nodes[Node] };
+	NodeData.Island = Island;
+	NodeData.Slot = m_Islands[Island].Nodes.Add(Node);
+	if (NodeData.Anchored)
+	{
+		++m_Islands[Island].Anchors;
+		m_Islands[Island].WasAnchored = true;
+	}
+}
+
+void FWebConnectivity::RemoveFromIsland(int32 Node)
+{
+	FNode& NodeData{ m_Nodes[Node] };
+	FIsland& Island{ m_Islands[NodeData.Island] };
+
+	// Swap the last node into the freed slot
+	const int32 Last{ Island.Nodes.Last() };
+	Island.Nodes[NodeData.Slot] = Last;
+	m_Nodes[Last].Slot = NodeData.Slot;
+	Island.Nodes.Pop(false);
+
+	if (NodeData.Anchored)
+		--Island.Anchors;
+
+	NodeData.Island = INDEX_NONE;
+	NodeData.Slot = INDEX_NONE;
+}
+
+void FWebConnectivity::MergeIslands(int32 A, int32 B)
+{
+	if (A == B)
+		return;
+
+	// Relabel the smaller one, every node moves at most log(n) times
+	if (m_Islands[A].Nodes.Num() < m_Islands[B].Nodes.Num())
+		Swap(A, B);
+
+	const TArray<int32> Moved{ MoveTemp(m_Islands[B].Nodes) };
+	m_Islands[A].WasAnchored |= m_Islands[B].WasAnchored;
+	m_Islands.RemoveAt(B);
+	for (const int32 Node : Moved)
+	{
+		m_Nodes[Node].Island = INDEX_NONE;
+		AddToIsland(Node, A);
+	}
+}
+
+void FWebConnectivity::FindSplit(int32 A, int32 B, TArray<int32>& OutSplit)
+{
+	OutSplit.Reset();
+	if (m_VisitStamps.Num() < m_Nodes.GetMaxIndex())
+	{
+		m_VisitStamps.SetNumZeroed(m_Nodes.GetMaxIndex());
+		m_VisitSides.SetNumZeroed(m_Nodes.GetMaxIndex());
+	}
+
+	++m_Stamp;
+	if (m_Stamp == 0)
+	{
+		// Wrapped, old stamps could match again
+		FMemory::Memzero(m_VisitStamps.GetData(), m_VisitStamps.Num() * sizeof(uint32));
+		m_Stamp = 1;
+	}
+
+	// Visited nodes double as the queue, Next is where the queue starts
+	TArray<int32> Visited[2]{ { A }, { B } };
+	int32 Next[2]{};
+	m_VisitStamps[A] = m_Stamp;
+	m_VisitSides[A] = 0;
+	m_VisitStamps[B] = m_Stamp;
+	m_VisitSides[B] = 1;
+
+	for (int32 Side{};; Side = 1 - Side)
+	{
+		if (Next[Side] == Visited[Side].Num())
+		{
+			OutSplit = MoveTemp(Visited[Side]);
+			return;
+		}
+
+		const int32 Node{ Visited[Side][Next[Side]++] };
+		for (const int32 Segment : m_Nodes[Node].Segments)
+		{
+			const FIntPoint& Ends{ m_SegmentNodes[Segment] };
+			const int32 Other{ Ends.X == Node ? Ends.Y : Ends.X };
+			if (m_VisitStamps[Other] != m_Stamp)
+			{
+				m_VisitStamps[Other] = m_Stamp;
+				m_VisitSides[Other] = static_cast<uint8>(Side);
+				Visited[Side].Add(Other);
+			}
+			else if (m_VisitSides[Other] != Side)
+			{
+				// The searches met, there's another way around
+				return;
+			}
+		}
+	}
+}
+
+void FWebConnectivity::SplitIsland(const TArray<int32>& Nodes)
+{
+	// The piece hung from whatever the whole did
+	const bool WasAnchored{ m_Islands[m_Nodes[Nodes[0]].Island].WasAnchored };
+	const int32 Island{ m_Islands.Add({}) };
+	m_Islands[Island].WasAnchored = WasAnchored;
+	for (const int32 Node : Nodes)
+	{
+		RemoveFromIsland(Node);
+		AddToIsland(Node, Island);
+	}
+}
+
+void FWebConnectivity::CollectSegments(int32 Island, TArray<int32>& OutSegments) const
+{
+	// Every segment is seen from both its nodes, only take it from its start
+	for (const int32 Node : m_Islands[Island].Nodes)
+	{
+		for (const int32 Segment : m_Nodes[Node].Segments)
+		{
+			if (m_SegmentNodes[Segment].X == Node)
+				OutSegments.Add(Segment);
+		}
+	}
+}
+
+#pragma endregion Islands
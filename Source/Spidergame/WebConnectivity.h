@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Which strands hang together and whether each group (island) still touches the level.
+ * Strand ends closer than the junction distance share a node, nodes where a strand hit the level are anchors.
+ * Adding a strand merges two islands by relabelling the smaller one's nodes.
+ * Removing one searches from both of its ends at once, one node per side in turn. Whichever side runs out first
+ * is split off, so a break costs as much as the smaller piece and nothing when there's another way around.
+ * Islands remember having had an anchor, so a web that lost its anchors can be told apart from one that never had any.
+ */
+class SPIDERGAME_API FWebConnectivity
+{
+public:
+	explicit FWebConnectivity(float JunctionDistance);
+
+	void AddSegment(int32 Segment, const FVector& Start, const FVector& End, bool StartAnchored, bool EndAnchored);
+	// Adds the segments of every island that was anchored and isn't anymore to OutDetached, one array per island
+	void RemoveSegment(int32 Segment, TArray<TArray<int32>>& OutDetached);
+	// Keeps the segment's junctions, strands swinging don't change what they're tied to
+	void MoveSegment(int32 Segment, const FVector& Start, const FVector& End);
+	void Reset();
+
+	bool IsAnchored(int32 Segment) const;
+	// Was tied to the level and isn't anymore, never anchored islands aren't detached
+	bool IsDetached(int32 Segment) const;
+	// Ends found to touch the level after they were added
+	bool IsEndAnchored(int32 Segment, bool AtEnd) const;
+	void AnchorEnd(int32 Segment, bool AtEnd);
+	// Segments of the island the segment is part of
+	void GetIsland(int32 Segment, TArray<int32>& OutSegments) const;
+	int32 GetNumIslands() const;
+
+private:
+	struct FNode
+	{
+		FVector Location{};
+		TArray<int32> Segments{};
+		int32 Island{ INDEX_NONE };
+		// Index in the island's node list
+		int32 Slot{ INDEX_NONE };
+		bool Anchored{ false };
+	};
+
+	struct FIsland
+	{
+		TArray<int32> Nodes{};
+		int32 Anchors{};
+		bool WasAnchored{ false };
+	};
+
+	float m_JunctionDistance{};
+
+	TSparseArray<FNode> m_Nodes{};
+	TSparseArray<FIsland> m_Islands{};
+	// Nodes at both ends of a segment, indexed by segment handle
+	TArray<FIntPoint> m_SegmentNodes{};
+	// Junction distance sized cells to the nodes in them
+	TMap<FIntVector, TArray<int32>> m_NodeCells{};
+
+	// Search scratch, stamped so nothing needs clearing between searches
+	TArray<uint32> m_VisitStamps{};
+	TArray<uint8> m_VisitSides{};
+	uint32 m_Stamp{};
+
+	bool HasSegment(int32 Segment) const;
+	FIntVector ToCell(const FVector& Location) const;
+	int32 FindOrAddNode(const FVector& Location, bool Anchored);
+	void RemoveNode(int32 Node);
+	void MoveNode(int32 Node, const FVector& Location);
+	void AnchorNode(int32 Node);
+	void AddToIsland(int32 Node, int32 Island);
+	void RemoveFromIsland(int32 Node);
+	void MergeIslands(int32 A, int32 B);
+	// Nodes on the side that ran out first, empty when A and B are still connected
+	void FindSplit(int32 A, int32 B, TArray<int32>& OutSplit);
+	void SplitIsland(const TArray<int32>& Nodes);
+	void CollectSegments(int32 Island, TArray<int32>& OutSegments) const;
+};
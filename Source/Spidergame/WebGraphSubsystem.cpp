@@ -0,0 +1,519 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "WebGraphSubsystem.h"
+
+#include "SpiderCollision.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+
+static TAutoConsoleVariable<bool> CVarWebDropDetached(
+	TEXT("Spider.Web.DropDetached"),
+	true,
+	TEXT("Remove strands that lost every anchor to the level, off leaves them hanging in the air"));
+
+void UWebGraphSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	m_LevelAddedHandle = FWorldDelegates::LevelAddedToWorld.AddUObject(this, &UWebGraphSubsystem::HandleLevelAdded);
+	m_ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateStatic(&UWebGraphSubsystem::MoveToWebProfile));
+}
+
+void UWebGraphSubsystem::Deinitialize()
+{
+	FWorldDelegates::LevelAddedToWorld.Remove(m_LevelAddedHandle);
+	m_LevelAddedHandle.Reset();
+	GetWorld()->RemoveOnActorSpawnedHandler(m_ActorSpawnedHandle);
+	m_ActorSpawnedHandle.Reset();
+
+	Super::Deinitialize();
+}
+
+void UWebGraphSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Placed webs first, tagged ones on a default profile would anchor strands to themselves
+	for (TActorIterator<AActor> It{ &InWorld }; It; ++It)
+		MoveToWebProfile(*It);
+
+	// Webs registered while the level was loading couldn't see all of it
+	AnchorLooseEnds();
+}
+
+#pragma region Segments
+// ==============================================================================
+// Segments
+// ==============================================================================
+
+int32 UWebGraphSubsystem::AddSegment(const FVector& Start, const FVector& End, AActor* Owner)
+{
+	int32 Index{};
+	if (m_FreeSegments.IsEmpty())
+	{
+		Index = m_Starts.Add(Start);
+		checkf(Index <= INDEX_MASK, TEXT("Web graph is out of segment handles"));
+		m_Ends.Add(End);
+		m_Owners.Add(Owner);
+		m_Alive.Add(true);
+		m_Generations.Add(0);
+	}
+	else
+	{
+		Index = m_FreeSegments.Pop(false);
+		m_Starts[Index] = Start;
+		m_Ends[Index] = End;
+		m_Owners[Index] = Owner;
+		m_Alive[Index] = true;
+	}
+
+	++m_NumSegments;
+	InsertIntoGrid(Index);
+	// Before play the level may be half loaded, OnWorldBeginPlay looks for the anchors then
+	const UWorld* World{ GetWorld() };
+	const bool Playing{ World && World->HasBegunPlay() };
+	m_Connectivity.AddSegment(Index, Start, End, Playing && IsAnchorPoint(Start, Owner), Playing && IsAnchorPoint(End, Owner));
+	return ToHandle(Index);
+}
+
+void UWebGraphSubsystem::RemoveSegment(int32 Segment)
+{
+	if (!IsValidSegment(Segment))
+		return;
+
+	const int32 Index{ ToIndex(Segment) };
+	RemoveFromGrid(Index);
+	m_Alive[Index] = false;
+	AActor* Owner{ m_Owners[Index].Get() };
+	m_Owners[Index] = nullptr;
+	// Old handles to this slot stop being valid here
+	m_Generations[Index] = static_cast<uint16>((m_Generations[Index] + 1) & GENERATION_MASK);
+	m_FreeSegments.Add(Index);
+	--m_NumSegments;
+
+	TArray<TArray<int32>> Detached{};
+	m_Connectivity.RemoveSegment(Index, Detached);
+	for (TArray<int32>& Island : Detached)
+	{
+		for (int32& IslandSegment : Island)
+			IslandSegment = ToHandle(IslandSegment);
+	}
+
+	OnSegmentRemoved.Broadcast(Segment, Owner);
+
+	for (const TArray<int32>& Island : Detached)
+	{
+		OnIslandDetached.Broadcast(Island);
+		if (!CVarWebDropDetached.GetValueOnGameThread())
+			continue;
+
+		// Already unanchored, removing these can't detach anything else
+		for (const int32 IslandSegment : Island)
+			RemoveSegment(IslandSegment);
+	}
+}
+
+void UWebGraphSubsystem::RemoveSegmentsOf(const AActor* Owner)
+{
+	TArray<int32> OwnedSegments{};
+	for (TConstSetBitIterator<> It{ m_Alive }; It; ++It)
+	{
+		if (m_Owners[It.GetIndex()] == Owner)
+			OwnedSegments.Add(ToHandle(It.GetIndex()));
+	}
+
+	for (const int32 Segment : OwnedSegments)
+		RemoveSegment(Segment);
+}
+
+void UWebGraphSubsystem::MoveSegment(int32 Segment, const FVector& Start, const FVector& End)
+{
+	if (!IsValidSegment(Segment))
+		return;
+
+	const int32 Index{ ToIndex(Segment) };
+	RemoveFromGrid(Index);
+	m_Starts[Index] = Start;
+	m_Ends[Index] = End;
+	InsertIntoGrid(Index);
+	m_Connectivity.MoveSegment(Index, Start, End);
+}
+
+bool UWebGraphSubsystem::IsValidSegment(int32 Segment) const
+{
+	const int32 Index{ ToIndex(Segment) };
+	return Segment >= 0 && m_Alive.IsValidIndex(Index) && m_Alive[Index] && m_Generations[Index] == Segment >> INDEX_BITS;
+}
+
+int32 UWebGraphSubsystem::GetNumSegments() const
+{
+	return m_NumSegments;
+}
+
+void UWebGraphSubsystem::GetSegments(TArray<int32>& OutSegments) const
+{
+	OutSegments.Reset(m_NumSegments);
+	for (TConstSetBitIterator<> It{ m_Alive }; It; ++It)
+		OutSegments.Add(ToHandle(It.GetIndex()));
+}
+
+const FVector& UWebGraphSubsystem::GetSegmentStart(int32 Segment) const
+{
+	return m_Starts[ToIndex(Segment)];
+}
+
+const FVector& UWebGraphSubsystem::GetSegmentEnd(int32 Segment) const
+{
+	return m_Ends[ToIndex(Segment)];
+}
+
+AActor* UWebGraphSubsystem::GetSegmentOwner(int32 Segment) const
+{
+	return m_Owners[ToIndex(Segment)].Get();
+}
+
+int32 UWebGraphSubsystem::ToIndex(int32 Segment)
+{
+	return Segment & INDEX_MASK;
+}
+
+int32 UWebGraphSubsystem::ToHandle(int32 Index) const
+{
+	return Index == INDEX_NONE ? INDEX_NONE : (m_Generations[Index] << INDEX_BITS) | Index;
+}
+
+#pragma endregion Segments
+
+#pragma region Connectivity
+// ==============================================================================
+// Connectivity
+// ==============================================================================
+
+bool UWebGraphSubsystem::IsSegmentAnchored(int32 Segment) const
+{
+	return IsValidSegment(Segment) && m_Connectivity.IsAnchored(ToIndex(Segment));
+}
+
+bool UWebGraphSubsystem::IsSegmentDetached(int32 Segment) const
+{
+	return IsValidSegment(Segment) && m_Connectivity.IsDetached(ToIndex(Segment));
+}
+
+void UWebGraphSubsystem::GetSegmentIsland(int32 Segment, TArray<int32>& OutSegments) const
+{
+	OutSegments.Reset();
+	if (!IsValidSegment(Segment))
+		return;
+
+	m_Connectivity.GetIsland(ToIndex(Segment), OutSegments);
+	for (int32& IslandSegment : OutSegments)
+		IslandSegment = ToHandle(IslandSegment);
+}
+
+bool UWebGraphSubsystem::IsAnchorPoint(const FVector& Point, const AActor* Owner) const
+{
+	const UWorld* World{ GetWorld() };
+	if (World == nullptr)
+		return false;
+
+	// Other webs don't hold a strand up, only the level does
+	FCollisionQueryParams Params{ SCENE_QUERY_STAT(WebAnchor), false, Owner };
+	return World->OverlapAnyTestByObjectType(Point, FQuat::Identity, MakeSpiderSurfaceQuery(false), FCollisionShape::MakeSphere(ANCHOR_DISTANCE), Params);
+}
+
+void UWebGraphSubsystem::AnchorLooseEnds()
+{
+	for (TConstSetBitIterator<> It{ m_Alive }; It; ++It)
+	{
+		const int32 Index{ It.GetIndex() };
+		const AActor* Owner{ m_Owners[Index].Get() };
+		if (!m_Connectivity.IsEndAnchored(Index, false) && IsAnchorPoint(m_Starts[Index], Owner))
+			m_Connectivity.AnchorEnd(Index, false);
+		if (!m_Connectivity.IsEndAnchored(Index, true) && IsAnchorPoint(m_Ends[Index], Owner))
+			m_Connectivity.AnchorEnd(Index, true);
+	}
+}
+
+void UWebGraphSubsystem::HandleLevelAdded(ULevel* Level, UWorld* World)
+{
+	if (World != GetWorld() || !World->HasBegunPlay())
+		return;
+
+	for (AActor* Actor : Level->Actors)
+		MoveToWebProfile(Actor);
+	AnchorLooseEnds();
+}
+
+void UWebGraphSubsystem::MoveToWebProfile(AActor* Actor)
+{
+	// Editor worlds are left alone, this must not dirty the levels
+	if (Actor == nullptr || Actor->Tags.IsEmpty() || !Actor->GetWorld() || !Actor->GetWorld()->IsGameWorld())
+		return;
+
+	const bool WebLine{ Actor->Tags.Contains(WEB_LINE_TAG) };
+	if (!WebLine && !Actor->Tags.Contains(WEB_TAG))
+		return;
+
+	// Only what the spider could already stand on, triggers and the like keep their profile
+	const TInlineComponentArray<UPrimitiveComponent*> Primitives{ Actor };
+	for (UPrimitiveComponent* Primitive : Primitives)
+	{
+		const ECollisionChannel ObjectType{ Primitive->GetCollisionObjectType() };
+		if (Primitive->IsCollisionEnabled() && (ObjectType == ECC_WorldStatic || ObjectType == ECC_WorldDynamic))
+			Primitive->SetCollisionProfileName(WebLine ? WEB_LINE_PROFILE : WEB_PROFILE);
+	}
+}
+
+#pragma endregion Connectivity
+
+#pragma region Grid
+// ==============================================================================
+// Grid
+// ==============================================================================
+
+FIntVector UWebGraphSubsystem::ToCell(const FVector& Location)
+{
+	return {
+		FMath::FloorToInt32(Location.X / CELL_SIZE),
+		FMath::FloorToInt32(Location.Y / CELL_SIZE),
+		FMath::FloorToInt32(Location.Z / CELL_SIZE)
+	};
+}
+
+void UWebGraphSubsystem::GetSegmentCells(const FVector& Start, const FVector& End, TArray<FIntVector>& OutCells) const
+{
+	// Walk the cells the segment passes through (Amanatides & Woo)
+	constexpr int32 MaxCells{ 10000 };
+
+	FIntVector Cell{ ToCell(Start) };
+	const FIntVector LastCell{ ToCell(End) };
+	const FVector Delta{ End - Start };
+
+	int32 Step[3]{};
+	double NextBoundary[3]{};
+	double BoundaryStep[3]{};
+	for (int32 Axis{}; Axis < 3; ++Axis)
+	{
+		if (Delta[Axis] > 0.0)
+		{
+			Step[Axis] = 1;
+			NextBoundary[Axis] = ((Cell[Axis] + 1) * CELL_SIZE - Start[Axis]) / Delta[Axis];
+			BoundaryStep[Axis] = CELL_SIZE / Delta[Axis];
+		}
+		else if (Delta[Axis] < 0.0)
+		{
+			Step[Axis] = -1;
+			NextBoundary[Axis] = (Cell[Axis] * CELL_SIZE - Start[Axis]) / Delta[Axis];
+			BoundaryStep[Axis] = -CELL_SIZE / Delta[Axis];
+		}
+		else
+		{
+			NextBoundary[Axis] = DBL_MAX;
+			BoundaryStep[Axis] = DBL_MAX;
+		}
+	}
+
+	OutCells.Add(Cell);
+	while (Cell != LastCell && OutCells.Num() < MaxCells)
+	{
+		int32 Axis{ NextBoundary[0] < NextBoundary[1] ? 0 : 1 };
+		if (NextBoundary[2] < NextBoundary[Axis])
+			Axis = 2;
+
+		if (NextBoundary[Axis] > 1.0)
+			break;
+
+		Cell[Axis] += Step[Axis];
+		NextBoundary[Axis] += BoundaryStep[Axis];
+		OutCells.Add(Cell);
+	}
+}
+
+void UWebGraphSubsystem::InsertIntoGrid(int32 Segment)
+{
+	TArray<FIntVector> Cells{};
+	GetSegmentCells(m_Starts[Segment], m_Ends[Segment], Cells);
+
+	for (const FIntVector& Cell : Cells)
+		m_Cells.FindOrAdd(Cell).Add(Segment);
+}
+
+void UWebGraphSubsystem::RemoveFromGrid(int32 Segment)
+{
+	TArray<FIntVector> Cells{};
+	GetSegmentCells(m_Starts[Segment], m_Ends[Segment], Cells);
+
+	for (const FIntVector& Cell : Cells)
+	{
+		TArray<int32>* Segments{ m_Cells.Find(Cell) };
+		if (Segments == nullptr)
+			continue;
+
+		Segments->RemoveSingleSwap(Segment, false);
+		if (Segments->IsEmpty())
+			m_Cells.Remove(Cell);
+	}
+}
+
+template <typename TVisitor>
+void UWebGraphSubsystem::ForEachSegmentInBox(const FBox& Box, TVisitor&& Visitor) const
+{
+	const FIntVector Min{ ToCell(Box.Min) };
+	const FIntVector Max{ ToCell(Box.Max) };
+	const int64 NumCells{ int64{ Max.X - Min.X + 1 } * (Max.Y - Min.Y + 1) * (Max.Z - Min.Z + 1) };
+
+	// Big boxes over a sparse grid, cheaper to check the occupied cells
+	if (NumCells > MAX_QUERY_CELLS || NumCells > m_Cells.Num())
+	{
+		for (const TPair<FIntVector, TArray<int32>>& Pair : m_Cells)
+		{
+			const FIntVector& Cell{ Pair.Key };
+			if (Cell.X < Min.X || Cell.Y < Min.Y || Cell.Z < Min.Z || Cell.X > Max.X || Cell.Y > Max.Y || Cell.Z > Max.Z)
+				continue;
+
+			for (const int32 Segment : Pair.Value)
+				Visitor(Segment);
+		}
+		return;
+	}
+
+	for (int32 X{ Min.X }; X <= Max.X; ++X)
+		for (int32 Y{ Min.Y }; Y <= Max.Y; ++Y)
+			for (int32 Z{ Min.Z }; Z <= Max.Z; ++Z)
+			{
+				const TArray<int32>* Segments{ m_Cells.Find({ X, Y, Z }) };
+				if (Segments == nullptr)
+					continue;
+
+				for (const int32 Segment : *Segments)
+					Visitor(Segment);
+			}
+}
+
+#pragma endregion Grid
+
+#pragma region Queries
+// ==============================================================================
+// Queries
+// ==============================================================================
+
+bool UWebGraphSubsystem::FindClosestSegment(const FVector& Point, float MaxDistance, int32& OutSegment, FVector& OutClosestPoint) const
+{
+	OutSegment = INDEX_NONE;
+	double ClosestDistanceSquared{ FMath::Square(MaxDistance) };
+
+	ForEachSegmentInBox(FBox{ Point, Point }.ExpandBy(MaxDistance), [&](int32 Segment)
+	{
+		const FVector Closest{ FMath::ClosestPointOnSegment(Point, m_Starts[Segment], m_Ends[Segment]) };
+		const double DistanceSquared{ FVector::DistSquared(Point, Closest) };
+		if (DistanceSquared <= ClosestDistanceSquared)
+		{
+			ClosestDistanceSquared = DistanceSquared;
+			OutSegment = Segment;
+			OutClosestPoint = Closest;
+		}
+	});
+
+	OutSegment = ToHandle(OutSegment);
+	return OutSegment != INDEX_NONE;
+}
+
+int32 UWebGraphSubsystem::FindConnectedSegment(int32 From, const FVector& Point, const FVector& Direction, float Tolerance, float MinAlignment) const
+{
+	const int32 FromIndex{ IsValidSegment(From) ? ToIndex(From) : INDEX_NONE };
+	int32 Connected{ INDEX_NONE };
+	double BestAlignment{ MinAlignment };
+	const double ToleranceSquared{ FMath::Square(Tolerance) };
+
+	ForEachSegmentInBox(FBox{ Point, Point }.ExpandBy(Tolerance), [&](int32 Segment)
+	{
+		if (Segment == FromIndex)
+			return;
+
+		// Heading away from the junction along this segment
+		FVector Outgoing{};
+		if (FVector::DistSquared(Point, m_Starts[Segment]) <= ToleranceSquared)
+			Outgoing = m_Ends[Segment] - m_Starts[Segment];
+		else if (FVector::DistSquared(Point, m_Ends[Segment]) <= ToleranceSquared)
+			Outgoing = m_Starts[Segment] - m_Ends[Segment];
+		else
+			return;
+
+		const double Alignment{ Outgoing.GetSafeNormal().Dot(Direction) };
+		if (Alignment >= BestAlignment)
+		{
+			BestAlignment = Alignment;
+			Connected = Segment;
+		}
+	});
+
+	return ToHandle(Connected);
+}
+
+void UWebGraphSubsystem::OverlapCapsule(const FVector& CapsuleStart, const FVector& CapsuleEnd, float Radius, TArray<int32>& OutSegments) const
+{
+	OutSegments.Reset();
+
+	FBox Bounds{ CapsuleStart, CapsuleStart };
+	Bounds += CapsuleEnd;
+
+	ForEachSegmentInBox(Bounds.ExpandBy(Radius), [&](int32 Segment)
+	{
+		FVector OnCapsule{};
+		FVector OnSegment{};
+		FMath::SegmentDistToSegmentSafe(CapsuleStart, CapsuleEnd, m_Starts[Segment], m_Ends[Segment], OnCapsule, OnSegment);
+		if (FVector::DistSquared(OnCapsule, OnSegment) <= FMath::Square(Radius))
+			OutSegments.AddUnique(ToHandle(Segment));
+	});
+}
+
+bool UWebGraphSubsystem::Raycast(const FVector& Start, const FVector& End, float Radius, int32& OutSegment, float& OutTime) const
+{
+	OutSegment = INDEX_NONE;
+	OutTime = 1.f;
+
+	const double Length{ FVector::Dist(Start, End) };
+	if (Length <= UE_KINDA_SMALL_NUMBER)
+		return false;
+
+	// Cells along the ray, grown by the radius
+	TArray<FIntVector> RayCells{};
+	GetSegmentCells(Start, End, RayCells);
+
+	const int32 Reach{ FMath::CeilToInt32(Radius / CELL_SIZE) };
+	TSet<FIntVector> Cells{};
+	for (const FIntVector& RayCell : RayCells)
+	{
+		for (int32 X{ -Reach }; X <= Reach; ++X)
+			for (int32 Y{ -Reach }; Y <= Reach; ++Y)
+				for (int32 Z{ -Reach }; Z <= Reach; ++Z)
+					Cells.Add(RayCell + FIntVector{ X, Y, Z });
+	}
+
+	for (const FIntVector& Cell : Cells)
+	{
+		const TArray<int32>* Segments{ m_Cells.Find(Cell) };
+		if (Segments == nullptr)
+			continue;
+
+		for (const int32 Segment : *Segments)
+		{
+			FVector OnRay{};
+			FVector OnSegment{};
+			FMath::SegmentDistToSegmentSafe(Start, End, m_Starts[Segment], m_Ends[Segment], OnRay, OnSegment);
+			if (FVector::DistSquared(OnRay, OnSegment) > FMath::Square(Radius))
+				continue;
+
+			const float Time{ static_cast<float>(FVector::Dist(Start, OnRay) / Length) };
+			if (OutSegment == INDEX_NONE || Time < OutTime)
+			{
+				OutSegment = Segment;
+				OutTime = Time;
+			}
+		}
+	}
+
+	OutSegment = ToHandle(OutSegment);
+	return OutSegment != INDEX_NONE;
+}
+
+#pragma endregion Queries
@@ -0,0 +1,133 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WebConnectivity.h"
+#include "WebGraphSubsystem.generated.h"
+
+DECLARE_MULTICAST_DELEGATE_TwoParams(FWebSegmentRemovedDelegate, int32 /*Segment*/, AActor* /*Owner*/);
+DECLARE_MULTICAST_DELEGATE_OneParam(FWebIslandDetachedDelegate, const TArray<int32>& /*Segments*/);
+
+/**
+ * Every web strand in the world as a line segment, kept in flat arrays and binned in a uniform grid.
+ * Web actors register their strands here so closest strand, capsule and ray queries only look at nearby cells.
+ * Segment handles stay valid until the segment is removed. Removed slots are reused under a new generation,
+ * so a handle kept past its segment's removal never points at the strand that took its slot.
+ * Const queries don't touch any shared scratch state, so they can run on worker threads while nothing adds or removes segments.
+ * Strand ends touching the level are anchors, a break that leaves part of a web without one reports that part as detached.
+ * Anchors are looked for once play begins and again for loose ends whenever a streamed level comes in, so load order doesn't matter.
+ * Blueprint webs still marked with the Web or WebLine actor tag are moved onto the web collision profiles once, when they spawn.
+ */
+UCLASS()
+class SPIDERGAME_API UWebGraphSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+
+	// ==============================================================================
+	// Segments
+	// ==============================================================================
+	UFUNCTION(BlueprintCallable, Category="Web")
+	int32 AddSegment(const FVector& Start, const FVector& End, AActor* Owner);
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void RemoveSegment(int32 Segment);
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void RemoveSegmentsOf(const AActor* Owner);
+	// Keeps the handle, for strands that stretch or swing
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void MoveSegment(int32 Segment, const FVector& Start, const FVector& End);
+
+	UFUNCTION(BlueprintPure, Category="Web")
+	bool IsValidSegment(int32 Segment) const;
+	UFUNCTION(BlueprintPure, Category="Web")
+	int32 GetNumSegments() const;
+	// Handles of every segment, for passes that snapshot the whole graph
+	void GetSegments(TArray<int32>& OutSegments) const;
+	// Fired for every removal, also those not made by the owner (a firefly tearing a strand)
+	FWebSegmentRemovedDelegate OnSegmentRemoved{};
+
+	const FVector& GetSegmentStart(int32 Segment) const;
+	const FVector& GetSegmentEnd(int32 Segment) const;
+	AActor* GetSegmentOwner(int32 Segment) const;
+
+	// ==============================================================================
+	// Connectivity
+	// ==============================================================================
+	// Still tied to the level through its own or connected strands
+	UFUNCTION(BlueprintPure, Category="Web")
+	bool IsSegmentAnchored(int32 Segment) const;
+	// Was tied to the level and lost it, webs that never touched the level aren't detached
+	UFUNCTION(BlueprintPure, Category="Web")
+	bool IsSegmentDetached(int32 Segment) const;
+	// Every segment connected to Segment, itself included
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void GetSegmentIsland(int32 Segment, TArray<int32>& OutSegments) const;
+	// Fired after the removal that cut these segments off the level, before Spider.Web.DropDetached removes them
+	FWebIslandDetachedDelegate OnIslandDetached{};
+
+	// ==============================================================================
+	// Queries
+	// ==============================================================================
+	// Closest segment within MaxDistance of Point
+	UFUNCTION(BlueprintCallable, Category="Web")
+	bool FindClosestSegment(const FVector& Point, float MaxDistance, int32& OutSegment, FVector& OutClosestPoint) const;
+	// Segments touching the capsule swept between CapsuleStart and CapsuleEnd
+	void OverlapCapsule(const FVector& CapsuleStart, const FVector& CapsuleEnd, float Radius, TArray<int32>& OutSegments) const;
+	// Segment with an end within Tolerance of Point that carries on closest to Direction, at least MinAlignment (cosine) along it.
+	// INDEX_NONE if nothing else ends there or everything turns back too sharply
+	int32 FindConnectedSegment(int32 From, const FVector& Point, const FVector& Direction, float Tolerance, float MinAlignment = 0.f) const;
+	// First segment the ray passes within Radius of, OutTime is the ray fraction at the closest approach
+	bool Raycast(const FVector& Start, const FVector& End, float Radius, int32& OutSegment, float& OutTime) const;
+
+private:
+	static constexpr float CELL_SIZE{ 200.f };
+	// Past this many cells a query just walks every occupied cell
+	static constexpr int32 MAX_QUERY_CELLS{ 4096 };
+	// Strand ends closer than this are tied together
+	static constexpr float JUNCTION_DISTANCE{ 10.f };
+	// Strand ends within this of level geometry are anchored
+	static constexpr float ANCHOR_DISTANCE{ 5.f };
+	// Handles are the slot index in the low bits and the slot's generation above it, always positive
+	static constexpr int32 INDEX_BITS{ 20 };
+	static constexpr int32 INDEX_MASK{ (1 << INDEX_BITS) - 1 };
+	static constexpr int32 GENERATION_MASK{ (1 << (31 - INDEX_BITS)) - 1 };
+
+	// Segment data, one entry per slot
+	TArray<FVector> m_Starts{};
+	TArray<FVector> m_Ends{};
+	TArray<TWeakObjectPtr<AActor>> m_Owners{};
+	TBitArray<> m_Alive{};
+	TArray<uint16> m_Generations{};
+	TArray<int32> m_FreeSegments{};
+	int32 m_NumSegments{};
+
+	// Grid cell to the segments passing through it
+	TMap<FIntVector, TArray<int32>> m_Cells{};
+
+	FWebConnectivity m_Connectivity{ JUNCTION_DISTANCE };
+	FDelegateHandle m_LevelAddedHandle{};
+	FDelegateHandle m_ActorSpawnedHandle{};
+
+	static int32 ToIndex(int32 Segment);
+	int32 ToHandle(int32 Index) const;
+	static FIntVector ToCell(const FVector& Location);
+	void GetSegmentCells(const FVector& Start, const FVector& End, TArray<FIntVector>& OutCells) const;
+	void InsertIntoGrid(int32 Segment);
+	void RemoveFromGrid(int32 Segment);
+	bool IsAnchorPoint(const FVector& Point, const AActor* Owner) const;
+	// Ends that didn't touch the level may now that more of it has loaded
+	void AnchorLooseEnds();
+	void HandleLevelAdded(ULevel* Level, UWorld* World);
+	// Probes only look at object types, a tagged web on a default profile would count as ground
+	static void MoveToWebProfile(AActor* Actor);
+
+	// Calls Visitor with the segments of every cell overlapping the box, segments can be visited more than once
+	template <typename TVisitor>
+	void ForEachSegmentInBox(const FBox& Box, TVisitor&& Visitor) const;
+};
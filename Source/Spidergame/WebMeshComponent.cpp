@@ -0,0 +1,344 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "WebMeshComponent.h"
+
+#include "SpiderCollision.h"
+#include "SpiderStats.h"
+#include "WebGraphSubsystem.h"
+#include "WebStrandInstancesComponent.h"
+#include "Async/Async.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DEFINE_LOG_CATEGORY_STATIC(LogWebMesh, Log, All);
+
+UWebMeshComponent::UWebMeshComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	// Sections are replaced as a whole, never edited
+	bUseAsyncCooking = true;
+	bUseComplexAsSimpleCollision = true;
+
+	// A whole structure, spiders walk over it like ground instead of mounting its strands
+	SetCollisionProfileName(WEB_PROFILE);
+}
+
+void UWebMeshComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (m_RebuildPending)
+		StartBuild();
+
+	m_LODTimer -= DeltaTime;
+	if (m_LODTimer > 0.f)
+		return;
+
+	m_LODTimer = LODUpdateInterval;
+	UpdateLOD();
+}
+
+void UWebMeshComponent::BuildWeb(const TArray<FVector>& Anchors, const TArray<FIntPoint>& Strands, const TArray<AActor*>& Placeholders)
+{
+	m_Strands.Reset(Strands.Num());
+	for (const FIntPoint& Strand : Strands)
+	{
+		if (!Anchors.IsValidIndex(Strand.X) || !Anchors.IsValidIndex(Strand.Y) || Strand.X == Strand.Y)
+		{
+			UE_LOG(LogWebMesh, Warning, TEXT("%s: skipped strand %d-%d, only %d anchors"), *GetPathName(), Strand.X, Strand.Y, Anchors.Num());
+			continue;
+		}
+
+		m_Strands.Add({ Anchors[Strand.X], Anchors[Strand.Y] });
+	}
+
+	for (AActor* Placeholder : Placeholders)
+		m_PlaceholderActors.Add(Placeholder);
+
+	StartBuild();
+}
+
+void UWebMeshComponent::BuildFromStrands(UWebStrandInstancesComponent* Placeholder)
+{
+	if (Placeholder == nullptr)
+		return;
+
+	m_Strands.Reset(Placeholder->GetNumStrands());
+	for (int32 Strand{}; Strand < Placeholder->GetInstanceCount(); ++Strand)
+	{
+		if (!Placeholder->IsValidStrand(Strand))
+			continue;
+
+		FStrand& Added{ m_Strands.AddDefaulted_GetRef() };
+		Placeholder->GetStrandEnds(Strand, Added.Start, Added.End);
+	}
+
+	m_PlaceholderStrands = Placeholder;
+	StartBuild();
+}
+
+bool UWebMeshComponent::IsBuilding() const
+{
+	return m_RebuildPending || m_ShownBuildId != m_BuildId;
+}
+
+int32 UWebMeshComponent::GetNumStrands() const
+{
+	return m_Segments.Num();
+}
+
+void UWebMeshComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+		m_SegmentRemovedHandle = WebGraph->OnSegmentRemoved.AddUObject(this, &UWebMeshComponent::HandleSegmentRemoved);
+}
+
+void UWebMeshComponent::OnUnregister()
+{
+	// Pending builds find nothing to finish
+	m_ShownBuildId = ++m_BuildId;
+	m_RebuildPending = false;
+
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+	{
+		WebGraph->OnSegmentRemoved.Remove(m_SegmentRemovedHandle);
+		m_SegmentRemovedHandle.Reset();
+	}
+	const TArray<int32> Segments{ MoveTemp(m_Segments) };
+	m_Segments.Reset();
+	m_ShownStrands.Reset();
+	UnregisterSegments(Segments);
+
+	Super::OnUnregister();
+}
+
+void UWebMeshComponent::StartBuild()
+{
+	const uint32 BuildId{ ++m_BuildId };
+	m_RebuildPending = false;
+
+	// Built relative to where the component is now, the web doesn't move while it's being placed
+	Async(EAsyncExecution::TaskGraph, [WeakThis = TWeakObjectPtr<UWebMeshComponent>{ this }, BuildId, Strands = m_Strands,
+		WorldToLocal = GetComponentTransform().Inverse(), LODSides = LODSides, Radius = StrandThickness * 0.5f, UVLength = UVLength]()
+	{
+		TArray<FLODMesh> LODs{};
+		{
+			SCOPE_CYCLE_COUNTER(STAT_WebMeshBuild);
+
+			LODs.SetNum(LODSides.Num());
+			for (int32 LOD{}; LOD < LODSides.Num(); ++LOD)
+				BuildLOD(Strands, WorldToLocal, FMath::Max(LODSides[LOD], 3), Radius, UVLength, LODs[LOD]);
+		}
+
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, BuildId, LODs = MoveTemp(LODs)]() mutable
+		{
+			if (UWebMeshComponent* This{ WeakThis.Get() })
+				This->FinishBuild(BuildId, MoveTemp(LODs));
+		});
+	});
+}
+
+void UWebMeshComponent::FinishBuild(uint32 BuildId, TArray<FLODMesh>&& LODs)
+{
+	// A newer build is on its way
+	if (BuildId != m_BuildId)
+		return;
+
+	m_ShownBuildId = BuildId;
+
+	ClearAllMeshSections();
+	for (int32 LOD{}; LOD < LODs.Num(); ++LOD)
+	{
+		const FLODMesh& Mesh{ LODs[LOD] };
+		if (Mesh.Triangles.IsEmpty())
+			continue;
+
+		// Only the coarsest LOD is cooked, hidden sections still collide
+		CreateMeshSection(LOD, Mesh.Vertices, Mesh.Triangles, Mesh.Normals, Mesh.UVs, {}, Mesh.Tangents, LOD == LODs.Num() - 1);
+		SetMeshSectionVisible(LOD, false);
+	}
+
+	m_LOD = INDEX_NONE;
+	UpdateLOD();
+
+	// New segments first so spiders on the old strands have something to land on
+	// and the web never loses its anchors in between
+	const TArray<int32> OldSegments{ MoveTemp(m_Segments) };
+	m_ShownStrands = m_Strands;
+	RegisterSegments();
+	UnregisterSegments(OldSegments);
+	RemovePlaceholders();
+
+	OnWebMeshReady.Broadcast();
+}
+
+void UWebMeshComponent::RegisterSegments()
+{
+	UWebGraphSubsystem* WebGraph{ GetWebGraph() };
+	if (WebGraph == nullptr)
+		return;
+
+	m_Segments.Reset(m_ShownStrands.Num());
+	for (const FStrand& Strand : m_ShownStrands)
+		m_Segments.Add(WebGraph->AddSegment(Strand.Start, Strand.End, GetOwner()));
+}
+
+void UWebMeshComponent::UnregisterSegments(const TArray<int32>& Segments)
+{
+	// Callers forget the segments first so their removal isn't mistaken for a break
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+	{
+		for (const int32 Segment : Segments)
+			WebGraph->RemoveSegment(Segment);
+	}
+}
+
+void UWebMeshComponent::RemovePlaceholders()
+{
+	for (const TWeakObjectPtr<AActor>& Placeholder : m_PlaceholderActors)
+	{
+		if (AActor* Actor{ Placeholder.Get() })
+			Actor->Destroy();
+	}
+	m_PlaceholderActors.Reset();
+
+	if (UWebStrandInstancesComponent* Strands{ m_PlaceholderStrands.Get() })
+		Strands->ClearStrands();
+	m_PlaceholderStrands.Reset();
+}
+
+void UWebMeshComponent::UpdateLOD()
+{
+	const int32 LOD{ CalcLOD() };
+	if (LOD == m_LOD)
+		return;
+
+	if (m_LOD != INDEX_NONE)
+		SetMeshSectionVisible(m_LOD, false);
+
+	m_LOD = LOD;
+	if (m_LOD != INDEX_NONE)
+		SetMeshSectionVisible(m_LOD, true);
+}
+
+int32 UWebMeshComponent::CalcLOD() const
+{
+	const int32 NumLODs{ GetNumSections() };
+	if (NumLODs == 0)
+		return INDEX_NONE;
+
+	// Closest local viewer, splitscreen shows the detail the nearest one needs
+	double ClosestSquared{ TNumericLimits<double>::Max() };
+	const UWorld* World{ GetWorld() };
+	for (FConstPlayerControllerIterator It{ World->GetPlayerControllerIterator() }; It; ++It)
+	{
+		const APlayerController* Controller{ It->Get() };
+		if (Controller == nullptr || !Controller->IsLocalController() || Controller->PlayerCameraManager == nullptr)
+			continue;
+
+		ClosestSquared = FMath::Min(ClosestSquared, Bounds.GetBox().ComputeSquaredDistanceToPoint(Controller->PlayerCameraManager->GetCameraLocation()));
+	}
+
+	// No viewer on a server, the collision section is all it needs
+	if (ClosestSquared == TNumericLimits<double>::Max())
+		return NumLODs - 1;
+
+	int32 LOD{};
+	while (LOD < LODDistances.Num() && ClosestSquared >= FMath::Square(LODDistances[LOD]))
+		++LOD;
+
+	return FMath::Min(LOD, NumLODs - 1);
+}
+
+void UWebMeshComponent::HandleSegmentRemoved(int32 Segment, AActor* Owner)
+{
+	if (Owner != GetOwner())
+		return;
+
+	const int32 Strand{ m_Segments.Find(Segment) };
+	if (Strand == INDEX_NONE)
+		return;
+
+	// The current mesh stays up until the one without this strand is ready
+	const FStrand Removed{ m_ShownStrands[Strand] };
+	m_Segments.RemoveAt(Strand);
+	m_ShownStrands.RemoveAt(Strand);
+
+	const int32 Pending{ m_Strands.IndexOfByPredicate([&Removed](const FStrand& Other)
+	{
+		return Other.Start == Removed.Start && Other.End == Removed.End;
+	}) };
+	if (Pending == INDEX_NONE)
+		return;
+
+	// A break tears strands in bursts, they all go in the next tick's build
+	m_Strands.RemoveAt(Pending);
+	m_RebuildPending = true;
+}
+
+UWebGraphSubsystem* UWebMeshComponent::GetWebGraph() const
+{
+	const UWorld* World{ GetWorld() };
+	return RegisterInWebGraph && World ? World->GetSubsystem<UWebGraphSubsystem>() : nullptr;
+}
+
+void UWebMeshComponent::BuildLOD(const TArray<FStrand>& Strands, const FTransform& WorldToLocal, int32 Sides, float Radius, float UVLength, FLODMesh& OutMesh)
+{
+	// A ring of Sides + 1 vertices at both ends, the last one repeats the first for the UV seam
+	const int32 RingSize{ Sides + 1 };
+	const int32 NumVertices{ Strands.Num() * RingSize * 2 };
+	OutMesh.Vertices.Reserve(NumVertices);
+	OutMesh.Normals.Reserve(NumVertices);
+	OutMesh.UVs.Reserve(NumVertices);
+	OutMesh.Tangents.Reserve(NumVertices);
+	OutMesh.Triangles.Reserve(Strands.Num() * Sides * 6);
+
+	for (const FStrand& Strand : Strands)
+	{
+		const FVector Start{ WorldToLocal.TransformPosition(Strand.Start) };
+		const FVector End{ WorldToLocal.TransformPosition(Strand.End) };
+		const FVector Direction{ End - Start };
+		const double Length{ Direction.Length() };
+		if (Length < UE_KINDA_SMALL_NUMBER)
+			continue;
+
+		const FMatrix Basis{ FRotationMatrix::MakeFromZ(Direction) };
+		const FVector AxisX{ Basis.GetUnitAxis(EAxis::X) };
+		const FVector AxisY{ Basis.GetUnitAxis(EAxis::Y) };
+		const FProcMeshTangent Tangent{ Direction / Length, false };
+		const double VEnd{ Length / FMath::Max(UVLength, 1.f) };
+
+		const int32 First{ OutMesh.Vertices.Num() };
+		for (int32 Side{}; Side <= Sides; ++Side)
+		{
+			double Sin{};
+			double Cos{};
+			FMath::SinCos(&Sin, &Cos, UE_TWO_PI * Side / Sides);
+			const FVector Normal{ AxisX * Cos + AxisY * Sin };
+			const double U{ static_cast<double>(Side) / Sides };
+
+			OutMesh.Vertices.Add(Start + Normal * Radius);
+			OutMesh.Vertices.Add(End + Normal * Radius);
+			OutMesh.Normals.Add(Normal);
+			OutMesh.Normals.Add(Normal);
+			OutMesh.UVs.Add({ U, 0.0 });
+			OutMesh.UVs.Add({ U, VEnd });
+			OutMesh.Tangents.Add(Tangent);
+			OutMesh.Tangents.Add(Tangent);
+		}
+
+		for (int32 Side{}; Side < Sides; ++Side)
+		{
+			const int32 Bottom{ First + Side * 2 };
+			const int32 Top{ Bottom + 1 };
+			const int32 NextBottom{ Bottom + 2 };
+			const int32 NextTop{ Bottom + 3 };
+
+			OutMesh.Triangles.Append({ Bottom, Top, NextBottom });
+			OutMesh.Triangles.Append({ NextBottom, Top, NextTop });
+		}
+	}
+}
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProceduralMeshComponent.h"
+#include "WebMeshComponent.generated.h"
+
+class UWebStrandInstancesComponent;
+class UWebGraphSubsystem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FWebMeshReadySignature);
+
+/**
+ * One triangulated mesh for a whole player built web structure, instead of a piece per strand.
+ * The strands are copied on the game thread and the tubes for every LOD are generated on a background task,
+ * the finished sections are swapped in on a later frame and their collision cooks async.
+ * Until then the pieces the web was built from stay as a placeholder, they are removed once the mesh shows.
+ * LODs are sections with fewer sides per strand, only the one for the viewer's distance is visible.
+ */
+UCLASS(ClassGroup=(Web), meta=(BlueprintSpawnableComponent))
+class SPIDERGAME_API UWebMeshComponent : public UProceduralMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWebMeshComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Strands index into Anchors, both world space. Placeholders are destroyed once the mesh is ready
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void BuildWeb(const TArray<FVector>& Anchors, const TArray<FIntPoint>& Strands, const TArray<AActor*>& Placeholders);
+	// Takes over the strands of an instances component, cleared once the mesh is ready
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void BuildFromStrands(UWebStrandInstancesComponent* Placeholder);
+
+	UFUNCTION(BlueprintPure, Category="Web")
+	bool IsBuilding() const;
+	UFUNCTION(BlueprintPure, Category="Web")
+	int32 GetNumStrands() const;
+
+	// New mesh swapped in, placeholders are gone
+	UPROPERTY(BlueprintAssignable, Category="Web")
+	FWebMeshReadySignature OnWebMeshReady{};
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Web")
+	float StrandThickness{ 2.f };
+	// Texture repeats once every this many units along a strand
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Web")
+	float UVLength{ 100.f };
+	// Also register every strand in the web graph so spiders and fireflies can find it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Web")
+	bool RegisterInWebGraph{ true };
+
+	// Sides per strand for every LOD, the last one is also the collision
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="LOD", meta=(ClampMin=3))
+	TArray<int32> LODSides{ 6, 4, 3 };
+	// Viewer distance where each LOD after the first starts
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="LOD")
+	TArray<float> LODDistances{ 1500.f, 4000.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="LOD", meta=(ClampMin=0))
+	float LODUpdateInterval{ 0.25f };
+
+protected:
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+private:
+	struct FStrand
+	{
+		FVector Start{};
+		FVector End{};
+	};
+
+	struct FLODMesh
+	{
+		TArray<FVector> Vertices{};
+		TArray<int32> Triangles{};
+		TArray<FVector> Normals{};
+		TArray<FVector2D> UVs{};
+		TArray<FProcMeshTangent> Tangents{};
+	};
+
+	// World space, what the latest build is made of
+	TArray<FStrand> m_Strands{};
+	// Strands of the mesh that is showing and their web graph segments
+	TArray<FStrand> m_ShownStrands{};
+	TArray<int32> m_Segments{};
+
+	TArray<TWeakObjectPtr<AActor>> m_PlaceholderActors{};
+	TWeakObjectPtr<UWebStrandInstancesComponent> m_PlaceholderStrands{};
+
+	// Results of older builds are dropped when they come in
+	uint32 m_BuildId{};
+	uint32 m_ShownBuildId{};
+	int32 m_LOD{ INDEX_NONE };
+	float m_LODTimer{};
+	// Strands were removed this frame, one rebuild covers all of them
+	bool m_RebuildPending{};
+	FDelegateHandle m_SegmentRemovedHandle{};
+
+	void StartBuild();
+	void FinishBuild(uint32 BuildId, TArray<FLODMesh>&& LODs);
+	void RegisterSegments();
+	void UnregisterSegments(const TArray<int32>& Segments);
+	void RemovePlaceholders();
+	void UpdateLOD();
+	int32 CalcLOD() const;
+	void HandleSegmentRemoved(int32 Segment, AActor* Owner);
+	UWebGraphSubsystem* GetWebGraph() const;
+
+	static void BuildLOD(const TArray<FStrand>& Strands, const FTransform& WorldToLocal, int32 Sides, float Radius, float UVLength, FLODMesh& OutMesh);
+};
@@ -0,0 +1,596 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "WebPhysicsComponent.h"
+
+#include "FireflyCaptureSubsystem.h"
+#include "WebGraphSubsystem.h"
+#include "WebStrandInstancesComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "Math/VectorRegister.h"
+
+namespace
+{
+	// Verlet step for one axis of four particles, pinned lanes stay put
+	void IntegrateLanes(float* Position, float* Previous, const float* Force, const VectorRegister4Float& Free,
+		const VectorRegister4Float& ForceStep, const VectorRegister4Float& KeepVelocity, const VectorRegister4Float& GravityStep)
+	{
+		const VectorRegister4Float Current{ VectorLoad(Position) };
+		const VectorRegister4Float Velocity{ VectorMultiply(VectorSubtract(Current, VectorLoad(Previous)), KeepVelocity) };
+
+		VectorRegister4Float Next{ VectorAdd(Current, Velocity) };
+		Next = VectorMultiplyAdd(VectorLoad(Force), ForceStep, Next);
+		Next = VectorAdd(Next, GravityStep);
+		Next = VectorSelect(Free, Next, Current);
+
+		VectorStore(Current, Previous);
+		VectorStore(Next, Position);
+	}
+
+	VectorRegister4Float Gather(const TArray<float>& Values, const int32 (&Indices)[4])
+	{
+		return MakeVectorRegister(Values[Indices[0]], Values[Indices[1]], Values[Indices[2]], Values[Indices[3]]);
+	}
+
+	void Scatter(TArray<float>& Values, const int32 (&Indices)[4], const VectorRegister4Float& Lanes)
+	{
+		float Stored[4];
+		VectorStore(Lanes, Stored);
+		for (int32 Lane{}; Lane < 4; ++Lane)
+			Values[Indices[Lane]] = Stored[Lane];
+	}
+}
+
+UWebPhysicsComponent::UWebPhysicsComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+	// Strand transforms are read by the renderer, done before the end of frame update
+	PrimaryComponentTick.TickGroup = TG_PostPhysics;
+}
+
+void UWebPhysicsComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	m_Strands = GetOwner()->FindComponentByClass<UWebStrandInstancesComponent>();
+	if (m_Strands)
+	{
+		m_Strands->OnStrandBroken.AddDynamic(this, &UWebPhysicsComponent::HandleStrandBroken);
+		m_Strands->OnStrandAdded.AddDynamic(this, &UWebPhysicsComponent::HandleStrandAdded);
+	}
+
+	if (UFireflyCaptureSubsystem* Captures{ GetWorld()->GetSubsystem<UFireflyCaptureSubsystem>() })
+	{
+		Captures->OnFireflyCaptured.AddDynamic(this, &UWebPhysicsComponent::HandleFireflyCaptured);
+		Captures->OnFireflyFreed.AddDynamic(this, &UWebPhysicsComponent::HandleFireflyFreed);
+	}
+
+	RebuildFromStrands();
+}
+
+void UWebPhysicsComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (m_Strands)
+	{
+		m_Strands->OnStrandBroken.RemoveDynamic(this, &UWebPhysicsComponent::HandleStrandBroken);
+		m_Strands->OnStrandAdded.RemoveDynamic(this, &UWebPhysicsComponent::HandleStrandAdded);
+	}
+
+	if (UFireflyCaptureSubsystem* Captures{ GetWorld()->GetSubsystem<UFireflyCaptureSubsystem>() })
+	{
+		Captures->OnFireflyCaptured.RemoveDynamic(this, &UWebPhysicsComponent::HandleFireflyCaptured);
+		Captures->OnFireflyFreed.RemoveDynamic(this, &UWebPhysicsComponent::HandleFireflyFreed);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UWebPhysicsComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	if (m_Strands == nullptr)
+		return;
+
+	if (m_RebuildPending)
+		Rebuild(true);
+
+	if (m_ParticleA.IsEmpty())
+		return;
+
+	// Hanging fireflies weigh on the constraint they were caught on every step
+	for (auto It{ m_StuckFireflies.CreateIterator() }; It; ++It)
+	{
+		if (!It.Key().IsValid() || m_Strand[It.Value().Key] == INDEX_NONE)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+
+		AddForceToConstraint(It.Value().Key, It.Value().Value, { 0.f, 0.f, -FireflyMass * Gravity });
+	}
+
+	const float StepTime{ 1.f / FMath::Max(SimulationRate, 1.f) };
+	m_Accumulator = FMath::Min(m_Accumulator + DeltaTime, StepTime * MAX_STEPS);
+
+	const double Deadline{ FPlatformTime::Seconds() + BudgetMs / 1000.0 };
+	bool OverBudget{ false };
+	while (m_Accumulator >= StepTime && !OverBudget)
+	{
+		m_Accumulator -= StepTime;
+		Integrate(StepTime);
+
+		for (int32 Iteration{}; Iteration < SolverIterations; ++Iteration)
+		{
+			SolveConstraints();
+			if (FPlatformTime::Seconds() > Deadline)
+			{
+				OverBudget = true;
+				break;
+			}
+		}
+
+		// Half solved strands look stretched, only judge tension on full steps
+		if (!OverBudget)
+			SnapOverstretched();
+	}
+
+	// Drop what didn't fit, the web falls behind instead of the frame
+	if (OverBudget)
+		m_Accumulator = 0.f;
+
+	FMemory::Memzero(m_ForceX.GetData(), m_ForceX.Num() * sizeof(float));
+	FMemory::Memzero(m_ForceY.GetData(), m_ForceY.Num() * sizeof(float));
+	FMemory::Memzero(m_ForceZ.GetData(), m_ForceZ.Num() * sizeof(float));
+
+	PushToStrands();
+}
+
+#pragma region Building
+// ==============================================================================
+// Building
+// ==============================================================================
+
+void UWebPhysicsComponent::RebuildFromStrands()
+{
+	Rebuild(false);
+}
+
+void UWebPhysicsComponent::Rebuild(bool KeepState)
+{
+	m_RebuildPending = false;
+
+	// By segment handle, an instance reused by another strand gets a new handle and starts fresh
+	TMap<int32, float> RestLengths{};
+	TArray<TTuple<TWeakObjectPtr<AActor>, int32, float>> Stuck{};
+	if (KeepState)
+	{
+		for (const TPair<int32, int32>& Pair : m_SegmentConstraints)
+		{
+			if (m_Strand[Pair.Value] != INDEX_NONE)
+				RestLengths.Add(Pair.Key, m_RestLength[Pair.Value]);
+		}
+
+		for (const TPair<TWeakObjectPtr<AActor>, TPair<int32, float>>& Pair : m_StuckFireflies)
+		{
+			const int32 Strand{ m_Strand[Pair.Value.Key] };
+			if (Strand != INDEX_NONE)
+				Stuck.Emplace(Pair.Key, m_Strands->GetStrandSegment(Strand), Pair.Value.Value);
+		}
+	}
+
+	for (TArray<float>* Values : { &m_X, &m_Y, &m_Z, &m_PrevX, &m_PrevY, &m_PrevZ, &m_ForceX, &m_ForceY, &m_ForceZ, &m_InvMass })
+		Values->Reset();
+
+	m_ParticleA.Reset();
+	m_ParticleB.Reset();
+	m_RestLength.Reset();
+	m_Strand.Reset();
+	m_DrawnStart.Reset();
+	m_DrawnEnd.Reset();
+	m_StrandConstraints.Reset();
+	m_SegmentConstraints.Reset();
+	m_StuckFireflies.Reset();
+	m_NumParticles = 0;
+
+	if (m_Strands == nullptr)
+		return;
+
+	m_StrandConstraints.Init(INDEX_NONE, m_Strands->GetInstanceCount());
+
+	// Weld strand ends meeting at a junction into one particle
+	TMap<FIntVector, int32> Welded{};
+	TArray<int32> Degree{};
+	const float WeldSize{ FMath::Max(WeldDistance, UE_KINDA_SMALL_NUMBER) };
+	auto FindOrAddParticle = [&](const FVector& Location)
+	{
+		const FIntVector Key{ FMath::RoundToInt32(Location.X / WeldSize), FMath::RoundToInt32(Location.Y / WeldSize), FMath::RoundToInt32(Location.Z / WeldSize) };
+		if (const int32* Found{ Welded.Find(Key) })
+		{
+			++Degree[*Found];
+			return *Found;
+		}
+
+		const int32 Particle{ AddParticle(Location) };
+		Welded.Add(Key, Particle);
+		Degree.Add(1);
+		return Particle;
+	};
+
+	for (int32 Strand{}; Strand < m_Strands->GetInstanceCount(); ++Strand)
+	{
+		if (!m_Strands->IsValidStrand(Strand))
+			continue;
+
+		FVector Start{};
+		FVector End{};
+		m_Strands->GetStrandEnds(Strand, Start, End);
+
+		const int32 Segment{ m_Strands->GetStrandSegment(Strand) };
+		const float* RestLength{ RestLengths.Find(Segment) };
+
+		m_ParticleA.Add(FindOrAddParticle(Start));
+		m_ParticleB.Add(FindOrAddParticle(End));
+		m_RestLength.Add(RestLength ? *RestLength : FVector::Dist(Start, End));
+		m_DrawnStart.Add(Start);
+		m_DrawnEnd.Add(End);
+
+		const int32 Constraint{ m_Strand.Add(Strand) };
+		m_StrandConstraints[Strand] = Constraint;
+		if (Segment != INDEX_NONE)
+			m_SegmentConstraints.Add(Segment, Constraint);
+	}
+
+	// Loose strand ends are anchored to whatever they were shot at
+	m_NumParticles = m_X.Num();
+	const float InvMass{ 1.f / ParticleMass };
+	for (int32 Particle{}; Particle < m_NumParticles; ++Particle)
+		m_InvMass[Particle] = Degree[Particle] > 1 ? InvMass : 0.f;
+
+	m_NullParticle = AddParticle(FVector::ZeroVector);
+	while (m_X.Num() % LANES != 0)
+		AddParticle(FVector::ZeroVector);
+
+	ColourConstraints();
+
+	for (const TTuple<TWeakObjectPtr<AActor>, int32, float>& Entry : Stuck)
+	{
+		if (const int32* Constraint{ m_SegmentConstraints.Find(Entry.Get<1>()) })
+			m_StuckFireflies.Add(Entry.Get<0>(), { *Constraint, Entry.Get<2>() });
+	}
+}
+
+int32 UWebPhysicsComponent::AddParticle(const FVector& Location)
+{
+	m_X.Add(Location.X);
+	m_Y.Add(Location.Y);
+	m_Z.Add(Location.Z);
+	m_PrevX.Add(Location.X);
+	m_PrevY.Add(Location.Y);
+	m_PrevZ.Add(Location.Z);
+	m_ForceX.Add(0.f);
+	m_ForceY.Add(0.f);
+	m_ForceZ.Add(0.f);
+	return m_InvMass.Add(0.f);
+}
+
+FVector UWebPhysicsComponent::GetParticle(int32 Particle) const
+{
+	return { m_X[Particle], m_Y[Particle], m_Z[Particle] };
+}
+
+void UWebPhysicsComponent::ColourConstraints()
+{
+	// Greedy colouring, a constraint goes in the first batch that doesn't touch its particles yet
+	m_Batches.Reset();
+	TArray<TBitArray<>> UsedParticles{};
+
+	for (int32 Constraint{}; Constraint < m_ParticleA.Num(); ++Constraint)
+	{
+		const int32 A{ m_ParticleA[Constraint] };
+		const int32 B{ m_ParticleB[Constraint] };
+
+		int32 Batch{};
+		while (Batch < m_Batches.Num() && (UsedParticles[Batch][A] || UsedParticles[Batch][B]))
+			++Batch;
+
+		if (Batch == m_Batches.Num())
+		{
+			m_Batches.AddDefaulted();
+			UsedParticles.Emplace(false, m_X.Num());
+		}
+
+		m_Batches[Batch].Add(Constraint);
+		UsedParticles[Batch][A] = true;
+		UsedParticles[Batch][B] = true;
+	}
+
+	for (TArray<int32>& Batch : m_Batches)
+	{
+		while (Batch.Num() % LANES != 0)
+			Batch.Add(INDEX_NONE);
+	}
+}
+
+#pragma endregion Building
+
+#pragma region Loads
+// ==============================================================================
+// Loads
+// ==============================================================================
+
+void UWebPhysicsComponent::AddImpulseAtLocation(const FVector& Location, const FVector& Impulse)
+{
+	float Along{};
+	const int32 Constraint{ FindConstraint(Location, Along) };
+	if (Constraint != INDEX_NONE)
+		AddImpulseToConstraint(Constraint, Along, Impulse);
+}
+
+void UWebPhysicsComponent::AddForceAtLocation(const FVector& Location, const FVector& Force)
+{
+	float Along{};
+	const int32 Constraint{ FindConstraint(Location, Along) };
+	if (Constraint != INDEX_NONE)
+		AddForceToConstraint(Constraint, Along, Force);
+}
+
+void UWebPhysicsComponent::AddImpulseToConstraint(int32 Constraint, float Along, const FVector& Impulse)
+{
+	// Verlet keeps velocity as the gap to the previous position
+	const float StepTime{ 1.f / FMath::Max(SimulationRate, 1.f) };
+	const auto Push = [&](int32 Particle, float Share)
+	{
+		const FVector Offset{ Impulse * (Share * m_InvMass[Particle] * StepTime) };
+		m_PrevX[Particle] -= Offset.X;
+		m_PrevY[Particle] -= Offset.Y;
+		m_PrevZ[Particle] -= Offset.Z;
+	};
+
+	Push(m_ParticleA[Constraint], 1.f - Along);
+	Push(m_ParticleB[Constraint], Along);
+}
+
+void UWebPhysicsComponent::AddForceToConstraint(int32 Constraint, float Along, const FVector& Force)
+{
+	const auto Pull = [&](int32 Particle, float Share)
+	{
+		m_ForceX[Particle] += Force.X * Share;
+		m_ForceY[Particle] += Force.Y * Share;
+		m_ForceZ[Particle] += Force.Z * Share;
+	};
+
+	Pull(m_ParticleA[Constraint], 1.f - Along);
+	Pull(m_ParticleB[Constraint], Along);
+}
+
+int32 UWebPhysicsComponent::FindConstraint(const FVector& Location, float& OutAlong) const
+{
+	// Through the web graph grid, the scan below is for strands not registered there or farther away
+	int32 Segment{};
+	FVector OnSegment{};
+	const UWebGraphSubsystem* WebGraph{ GetWorld()->GetSubsystem<UWebGraphSubsystem>() };
+	if (WebGraph && WebGraph->FindClosestSegment(Location, FIND_RADIUS, Segment, OnSegment))
+	{
+		const int32* Found{ m_SegmentConstraints.Find(Segment) };
+		if (Found && m_Strand[*Found] != INDEX_NONE)
+		{
+			OutAlong = GetAlong(*Found, Location);
+			return *Found;
+		}
+	}
+
+	int32 Closest{ INDEX_NONE };
+	double ClosestDistanceSquared{ DBL_MAX };
+	for (int32 Constraint{}; Constraint < m_ParticleA.Num(); ++Constraint)
+	{
+		if (m_Strand[Constraint] == INDEX_NONE)
+			continue;
+
+		const FVector Start{ GetParticle(m_ParticleA[Constraint]) };
+		const FVector End{ GetParticle(m_ParticleB[Constraint]) };
+		const FVector OnStrand{ FMath::ClosestPointOnSegment(Location, Start, End) };
+		const double DistanceSquared{ FVector::DistSquared(Location, OnStrand) };
+		if (DistanceSquared < ClosestDistanceSquared)
+		{
+			ClosestDistanceSquared = DistanceSquared;
+			Closest = Constraint;
+		}
+	}
+
+	if (Closest != INDEX_NONE)
+		OutAlong = GetAlong(Closest, Location);
+	return Closest;
+}
+
+int32 UWebPhysicsComponent::FindConstraintOfStrand(int32 Strand) const
+{
+	return m_StrandConstraints.IsValidIndex(Strand) ? m_StrandConstraints[Strand] : INDEX_NONE;
+}
+
+float UWebPhysicsComponent::GetAlong(int32 Constraint, const FVector& Location) const
+{
+	const FVector Start{ GetParticle(m_ParticleA[Constraint]) };
+	const FVector End{ GetParticle(m_ParticleB[Constraint]) };
+	const double Length{ FVector::Dist(Start, End) };
+	return Length > UE_KINDA_SMALL_NUMBER ? static_cast<float>(FVector::Dist(Start, FMath::ClosestPointOnSegment(Location, Start, End)) / Length) : 0.f;
+}
+
+#pragma endregion Loads
+
+#pragma region Solver
+// ==============================================================================
+// Solver
+// ==============================================================================
+
+void UWebPhysicsComponent::Integrate(float StepTime)
+{
+	const float StepSquared{ StepTime * StepTime };
+	const VectorRegister4Float KeepVelocity{ VectorSetFloat1(Damping) };
+	const VectorRegister4Float NoGravity{ VectorZeroFloat() };
+	const VectorRegister4Float GravityStep{ VectorSetFloat1(-Gravity * StepSquared) };
+	const VectorRegister4Float StepSquaredLanes{ VectorSetFloat1(StepSquared) };
+
+	for (int32 Index{}; Index < m_X.Num(); Index += LANES)
+	{
+		const VectorRegister4Float InvMass{ VectorLoad(&m_InvMass[Index]) };
+		const VectorRegister4Float Free{ VectorCompareGT(InvMass, VectorZeroFloat()) };
+		const VectorRegister4Float ForceStep{ VectorMultiply(InvMass, StepSquaredLanes) };
+
+		IntegrateLanes(&m_X[Index], &m_PrevX[Index], &m_ForceX[Index], Free, ForceStep, KeepVelocity, NoGravity);
+		IntegrateLanes(&m_Y[Index], &m_PrevY[Index], &m_ForceY[Index], Free, ForceStep, KeepVelocity, NoGravity);
+		IntegrateLanes(&m_Z[Index], &m_PrevZ[Index], &m_ForceZ[Index], Free, ForceStep, KeepVelocity, GravityStep);
+	}
+}
+
+void UWebPhysicsComponent::SolveConstraints()
+{
+	const VectorRegister4Float Epsilon{ VectorSetFloat1(UE_KINDA_SMALL_NUMBER) };
+
+	for (const TArray<int32>& Batch : m_Batches)
+	{
+		// No two constraints in a batch share a particle, so four lanes never write the same one
+		for (int32 First{}; First < Batch.Num(); First += LANES)
+		{
+			int32 A[LANES];
+			int32 B[LANES];
+			float Rest[LANES];
+			for (int32 Lane{}; Lane < LANES; ++Lane)
+			{
+				const int32 Constraint{ Batch[First + Lane] };
+				const bool Live{ Constraint != INDEX_NONE && m_Strand[Constraint] != INDEX_NONE };
+				A[Lane] = Live ? m_ParticleA[Constraint] : m_NullParticle;
+				B[Lane] = Live ? m_ParticleB[Constraint] : m_NullParticle;
+				Rest[Lane] = Live ? m_RestLength[Constraint] : 0.f;
+			}
+
+			VectorRegister4Float AX{ Gather(m_X, A) };
+			VectorRegister4Float AY{ Gather(m_Y, A) };
+			VectorRegister4Float AZ{ Gather(m_Z, A) };
+			VectorRegister4Float BX{ Gather(m_X, B) };
+			VectorRegister4Float BY{ Gather(m_Y, B) };
+			VectorRegister4Float BZ{ Gather(m_Z, B) };
+			const VectorRegister4Float WA{ Gather(m_InvMass, A) };
+			const VectorRegister4Float WB{ Gather(m_InvMass, B) };
+
+			const VectorRegister4Float DX{ VectorSubtract(BX, AX) };
+			const VectorRegister4Float DY{ VectorSubtract(BY, AY) };
+			const VectorRegister4Float DZ{ VectorSubtract(BZ, AZ) };
+			const VectorRegister4Float LengthSquared{ VectorMultiplyAdd(DZ, DZ, VectorMultiplyAdd(DY, DY, VectorMultiply(DX, DX))) };
+			const VectorRegister4Float Length{ VectorSqrt(VectorMax(LengthSquared, Epsilon)) };
+			const VectorRegister4Float WeightSum{ VectorMax(VectorAdd(WA, WB), Epsilon) };
+
+			// Share of the length error each end moves, by inverse mass
+			const VectorRegister4Float Error{ VectorDivide(VectorSubtract(Length, MakeVectorRegister(Rest[0], Rest[1], Rest[2], Rest[3])), VectorMultiply(Length, WeightSum)) };
+			const VectorRegister4Float MoveA{ VectorMultiply(Error, WA) };
+			const VectorRegister4Float MoveB{ VectorMultiply(Error, WB) };
+
+			AX = VectorMultiplyAdd(DX, MoveA, AX);
+			AY = VectorMultiplyAdd(DY, MoveA, AY);
+			AZ = VectorMultiplyAdd(DZ, MoveA, AZ);
+			BX = VectorNegateMultiplyAdd(DX, MoveB, BX);
+			BY = VectorNegateMultiplyAdd(DY, MoveB, BY);
+			BZ = VectorNegateMultiplyAdd(DZ, MoveB, BZ);
+
+			Scatter(m_X, A, AX);
+			Scatter(m_Y, A, AY);
+			Scatter(m_Z, A, AZ);
+			Scatter(m_X, B, BX);
+			Scatter(m_Y, B, BY);
+			Scatter(m_Z, B, BZ);
+		}
+	}
+}
+
+void UWebPhysicsComponent::SnapOverstretched()
+{
+	for (int32 Constraint{}; Constraint < m_ParticleA.Num(); ++Constraint)
+	{
+		if (m_Strand[Constraint] == INDEX_NONE)
+			continue;
+
+		const float Length{ static_cast<float>(FVector::Dist(GetParticle(m_ParticleA[Constraint]), GetParticle(m_ParticleB[Constraint]))) };
+		const float Rest{ FMath::Max(m_RestLength[Constraint], UE_KINDA_SMALL_NUMBER) };
+		if ((Length - Rest) / Rest > MaxStrain)
+			SnapConstraint(Constraint);
+	}
+}
+
+void UWebPhysicsComponent::SnapConstraint(int32 Constraint)
+{
+	const int32 Strand{ m_Strand[Constraint] };
+	m_Strand[Constraint] = INDEX_NONE;
+	m_StrandConstraints[Strand] = INDEX_NONE;
+
+	// Removing through the component doesn't come back through OnStrandBroken
+	m_Strands->RemoveStrand(Strand);
+	OnStrandSnapped.Broadcast(Strand);
+}
+
+void UWebPhysicsComponent::PushToStrands()
+{
+	bool Moved{ false };
+	for (int32 Constraint{}; Constraint < m_ParticleA.Num(); ++Constraint)
+	{
+		const int32 Strand{ m_Strand[Constraint] };
+		if (Strand == INDEX_NONE)
+			continue;
+
+		const FVector Start{ GetParticle(m_ParticleA[Constraint]) };
+		const FVector End{ GetParticle(m_ParticleB[Constraint]) };
+		if (Start.Equals(m_DrawnStart[Constraint], MIN_STRAND_MOVE) && End.Equals(m_DrawnEnd[Constraint], MIN_STRAND_MOVE))
+			continue;
+
+		m_Strands->MoveStrand(Strand, Start, End, false);
+		m_DrawnStart[Constraint] = Start;
+		m_DrawnEnd[Constraint] = End;
+		Moved = true;
+	}
+
+	if (Moved)
+		m_Strands->MarkRenderStateDirty();
+}
+
+#pragma endregion Solver
+
+#pragma region Events
+// ==============================================================================
+// Events
+// ==============================================================================
+
+void UWebPhysicsComponent::HandleStrandBroken(int32 Strand)
+{
+	const int32 Constraint{ FindConstraintOfStrand(Strand) };
+	if (Constraint == INDEX_NONE)
+		return;
+
+	m_Strand[Constraint] = INDEX_NONE;
+	m_StrandConstraints[Strand] = INDEX_NONE;
+}
+
+void UWebPhysicsComponent::HandleStrandAdded(int32 Strand)
+{
+	// Several strands can land in one frame, they share one build
+	m_RebuildPending = true;
+}
+
+void UWebPhysicsComponent::HandleFireflyCaptured(AActor* Firefly, int32 Segment, FVector AttachPoint)
+{
+	if (Firefly == nullptr || m_Strands == nullptr)
+		return;
+
+	// Constraint is kept with the firefly, its weight is put straight on it every step
+	const int32* Constraint{ m_SegmentConstraints.Find(Segment) };
+	if (Constraint == nullptr || m_Strand[*Constraint] == INDEX_NONE)
+		return;
+
+	const float Along{ GetAlong(*Constraint, AttachPoint) };
+	AddImpulseToConstraint(*Constraint, Along, Firefly->GetVelocity() * FireflyImpact);
+	m_StuckFireflies.Add(Firefly, { *Constraint, Along });
+}
+
+void UWebPhysicsComponent::HandleFireflyFreed(AActor* Firefly)
+{
+	m_StuckFireflies.Remove(Firefly);
+}
+
+#pragma endregion Events
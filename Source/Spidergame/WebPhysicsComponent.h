@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "WebPhysicsComponent.generated.h"
+
+class UWebStrandInstancesComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWebStrandSnappedSignature, int32, Strand);
+
+/**
+ * Makes the strands of a web structure sag, swing and snap.
+ * Strand ends become Verlet particles and strands distance constraints between them, both stored as flat float arrays.
+ * Integration runs four particles per SIMD register, constraints are coloured into batches without shared particles
+ * so four of them are solved at once too. Strands stretched past MaxStrain snap.
+ */
+UCLASS(ClassGroup=(Web), meta=(BlueprintSpawnableComponent))
+class SPIDERGAME_API UWebPhysicsComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWebPhysicsComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Rebuilds the particles from the strands currently in the instances component, strands added later are picked up on their own
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void RebuildFromStrands();
+
+	// Pushes the strand closest to Location, for one off hits
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void AddImpulseAtLocation(const FVector& Location, const FVector& Impulse);
+	// Pulls on the strand closest to Location for the next simulation step, for weight that stays
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void AddForceAtLocation(const FVector& Location, const FVector& Force);
+
+	// Strand came apart from too much tension, already removed from the instances component
+	UPROPERTY(BlueprintAssignable, Category="Web")
+	FWebStrandSnappedSignature OnStrandSnapped{};
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Simulation")
+	float SimulationRate{ 60.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Simulation", meta=(ClampMin=1))
+	int32 SolverIterations{ 8 };
+	// Solving stops for this frame once it took this long, the web just settles slower
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Simulation", meta=(ClampMin=0))
+	float BudgetMs{ 0.5f };
+	// Velocity kept per step
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Simulation", meta=(ClampMin=0, ClampMax=1))
+	float Damping{ 0.98f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Simulation")
+	float Gravity{ 980.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Simulation", meta=(ClampMin=0.01))
+	float ParticleMass{ 1.f };
+	// Strand ends closer than this are one particle
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Simulation")
+	float WeldDistance{ 1.f };
+
+	// Stretch over rest length, relative, that snaps a strand
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Tension")
+	float MaxStrain{ 0.5f };
+	// Weight of a firefly hanging in the web
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Tension")
+	float FireflyMass{ 0.5f };
+	// Impulse per unit of firefly speed when it flies in
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Tension")
+	float FireflyImpact{ 0.02f };
+
+private:
+	static constexpr int32 LANES{ 4 };
+	// Strands move less than this are not pushed to the instances and the web graph
+	static constexpr float MIN_STRAND_MOVE{ 0.1f };
+	static constexpr int32 MAX_STEPS{ 4 };
+	// Forces and impulses at a location look for a strand this close in the web graph grid first
+	static constexpr float FIND_RADIUS{ 100.f };
+
+	UPROPERTY(Transient)
+	TObjectPtr<UWebStrandInstancesComponent> m_Strands{};
+
+	// Particles, padded to a multiple of LANES with pinned particles
+	TArray<float> m_X{};
+	TArray<float> m_Y{};
+	TArray<float> m_Z{};
+	TArray<float> m_PrevX{};
+	TArray<float> m_PrevY{};
+	TArray<float> m_PrevZ{};
+	TArray<float> m_ForceX{};
+	TArray<float> m_ForceY{};
+	TArray<float> m_ForceZ{};
+	// 0 for pinned particles
+	TArray<float> m_InvMass{};
+	int32 m_NumParticles{};
+	// Pinned padding particle, unused lanes and snapped constraints point at it
+	int32 m_NullParticle{};
+
+	// Constraints, one per strand
+	TArray<int32> m_ParticleA{};
+	TArray<int32> m_ParticleB{};
+	TArray<float> m_RestLength{};
+	TArray<int32> m_Strand{};
+	TArray<FVector> m_DrawnStart{};
+	TArray<FVector> m_DrawnEnd{};
+	// Constraint per strand instance, INDEX_NONE for strands without one
+	TArray<int32> m_StrandConstraints{};
+	// Constraint per web graph segment, for lookups through the grid
+	TMap<int32, int32> m_SegmentConstraints{};
+	// Constraint indices per colour batch, padded to a multiple of LANES with INDEX_NONE
+	TArray<TArray<int32>> m_Batches{};
+
+	// Fireflies hanging on a constraint
+	TMap<TWeakObjectPtr<AActor>, TPair<int32, float>> m_StuckFireflies{};
+
+	float m_Accumulator{};
+	// Strands were added since the last build, rebuilt before the next step
+	bool m_RebuildPending{ false };
+
+	// Strands that were already simulated keep their rest length and the fireflies on them
+	void Rebuild(bool KeepState);
+	int32 AddParticle(const FVector& Location);
+	FVector GetParticle(int32 Particle) const;
+	void ColourConstraints();
+	// Closest live constraint and how far along it Location lies
+	int32 FindConstraint(const FVector& Location, float& OutAlong) const;
+	int32 FindConstraintOfStrand(int32 Strand) const;
+	float GetAlong(int32 Constraint, const FVector& Location) const;
+	void AddForceToConstraint(int32 Constraint, float Along, const FVector& Force);
+	void AddImpulseToConstraint(int32 Constraint, float Along, const FVector& Impulse);
+	void SnapConstraint(int32 Constraint);
+
+	void Integrate(float StepTime);
+	void SolveConstraints();
+	void SnapOverstretched();
+	void PushToStrands();
+
+	UFUNCTION()
+	void HandleStrandBroken(int32 Strand);
+	UFUNCTION()
+	void HandleStrandAdded(int32 Strand);
+	UFUNCTION()
+	void HandleFireflyCaptured(AActor* Firefly, int32 Segment, FVector AttachPoint);
+	UFUNCTION()
+	void HandleFireflyFreed(AActor* Firefly);
+};
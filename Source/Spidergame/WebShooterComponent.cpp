@@ -0,0 +1,251 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "WebShooterComponent.h"
+
+#include "BaseSpider.h"
+#include "SpiderStats.h"
+#include "WebStrandInstancesComponent.h"
+#include "Components/ArrowComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+
+UWebShooterComponent::UWebShooterComponent()
+{
+	// Only ticks while shots are flying
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+bool UWebShooterComponent::Shoot(const FVector& Direction)
+{
+	if (m_Muzzle == nullptr || m_FlyingStrands == nullptr || m_NumShotsInFlight >= m_Shots.Num())
+		return false;
+
+	FWebShot* Shot{ m_Shots.FindByPredicate([](const FWebShot& Candidate) { return Candidate.Strand == INDEX_NONE; }) };
+	const FVector Start{ m_Muzzle->GetComponentLocation() };
+	Shot->Start = Start;
+	Shot->Head = Start;
+	Shot->Direction = Direction.GetSafeNormal(UE_SMALL_NUMBER, m_Muzzle->GetForwardVector());
+	Shot->Travelled = 0.f;
+	Shot->Handle = {};
+	// Drawn a little past the head, a strand without length has no direction
+	Shot->Strand = m_FlyingStrands->AddStrand(Start, Start + Shot->Direction);
+
+	++m_NumShotsInFlight;
+	SetComponentTickEnabled(true);
+	return true;
+}
+
+bool UWebShooterComponent::ShootAt(const FVector& Target)
+{
+	return m_Muzzle != nullptr && Shoot(Target - m_Muzzle->GetComponentLocation());
+}
+
+void UWebShooterComponent::ClearStrands()
+{
+	// One by one, the instances stay reserved for the next shots
+	const TArray<int32> Strands{ MoveTemp(m_StrandOrder) };
+	m_StrandOrder.Reset();
+	if (m_Strands == nullptr)
+		return;
+
+	for (const int32 Strand : Strands)
+		m_Strands->RemoveStrand(Strand);
+}
+
+int32 UWebShooterComponent::GetNumShotsInFlight() const
+{
+	return m_NumShotsInFlight;
+}
+
+UWebStrandInstancesComponent* UWebShooterComponent::GetStrands() const
+{
+	return m_Strands;
+}
+
+void UWebShooterComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	SCOPE_CYCLE_COUNTER(STAT_WebShooter);
+
+	UWorld* World{ GetWorld() };
+	bool Moved{ false };
+	for (FWebShot& Shot : m_Shots)
+	{
+		if (Shot.Strand == INDEX_NONE || !UpdateShot(World, Shot, DeltaTime))
+			continue;
+
+		m_FlyingStrands->MoveStrand(Shot.Strand, Shot.Start, Shot.Head + Shot.Direction, false);
+		Moved = true;
+	}
+
+	if (Moved)
+		m_FlyingStrands->MarkRenderStateDirty();
+
+	if (m_NumShotsInFlight == 0)
+		SetComponentTickEnabled(false);
+}
+
+void UWebShooterComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	AActor* Owner{ GetOwner() };
+	const ABaseSpider* Spider{ Cast<ABaseSpider>(Owner) };
+	m_Muzzle = Spider && Spider->WebSocket ? Spider->WebSocket.Get() : Owner->GetRootComponent();
+
+	// Everything a shot needs is made here, once
+	m_Shots.SetNum(MaxShots);
+	m_Strands = CreateStrands(TEXT("WebShooterStrands"), true, MaxStrands);
+	m_FlyingStrands = CreateStrands(TEXT("WebShooterShots"), false, MaxShots);
+	m_Strands->OnStrandBroken.AddDynamic(this, &UWebShooterComponent::HandleStrandBroken);
+
+	// The owner's body is in the way of every shot, its strands aren't
+	m_QueryParams = FCollisionQueryParams{ SCENE_QUERY_STAT(WebShot), false };
+	const TInlineComponentArray<UPrimitiveComponent*> Primitives{ Owner };
+	for (const UPrimitiveComponent* Primitive : Primitives)
+	{
+		if (Primitive != m_Strands)
+			m_QueryParams.AddIgnoredComponent(Primitive);
+	}
+}
+
+void UWebShooterComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	for (FWebShot& Shot : m_Shots)
+	{
+		if (Shot.Strand != INDEX_NONE)
+			Release(Shot);
+	}
+
+	if (m_Strands)
+		m_Strands->OnStrandBroken.RemoveDynamic(this, &UWebShooterComponent::HandleStrandBroken);
+	m_StrandOrder.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+UWebStrandInstancesComponent* UWebShooterComponent::CreateStrands(FName Name, bool Landed, int32 Reserve)
+{
+	UWebStrandInstancesComponent* Strands{
+		NewObject<UWebStrandInstancesComponent>(GetOwner(), MakeUniqueObjectName(GetOwner(), UWebStrandInstancesComponent::StaticClass(), Name))
+	};
+
+	Strands->SetStaticMesh(StrandMesh);
+	if (StrandMesh)
+	{
+		const FVector Size{ StrandMesh->GetBoundingBox().GetSize() };
+		Strands->MeshLength = Size.Z;
+		Strands->MeshDiameter = Size.X;
+	}
+	Strands->StrandThickness = StrandThickness;
+
+	// Flying shots are only drawn, spiders can't grab them and fireflies can't hit them
+	Strands->RegisterInWebGraph = Landed;
+	if (!Landed)
+		Strands->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+
+	Strands->RegisterComponent();
+	Strands->ReserveStrands(Reserve);
+	return Strands;
+}
+
+bool UWebShooterComponent::UpdateShot(UWorld* World, FWebShot& Shot, float DeltaTime)
+{
+	if (Shot.Handle.IsValid())
+	{
+		// Results only live for a frame, a stretch whose result is gone is traced again
+		FTraceDatum Datum{};
+		if (!World->QueryTraceData(Shot.Handle, Datum))
+		{
+			TraceStretch(World, Shot);
+			return true;
+		}
+
+		if (const FHitResult* Hit{ FHitResult::GetFirstBlockingHit(Datum.OutHits) })
+		{
+			Land(Shot, *Hit);
+			return false;
+		}
+
+		Shot.Head = Shot.TraceEnd;
+		if (Shot.Travelled >= MaxRange)
+		{
+			const FVector Location{ Shot.Head };
+			Release(Shot);
+			OnShotMissed.Broadcast(Location);
+			return false;
+		}
+	}
+
+	// Next stretch is read back next frame, the drawn strand stays at the last one that was clear
+	const float Step{ FMath::Min(ShotSpeed * DeltaTime, MaxRange - Shot.Travelled) };
+	Shot.TraceEnd = Shot.Head + Shot.Direction * Step;
+	Shot.Travelled += Step;
+	TraceStretch(World, Shot);
+	return true;
+}
+
+void UWebShooterComponent::TraceStretch(UWorld* World, FWebShot& Shot) const
+{
+	Shot.Handle = World->AsyncLineTraceByObjectType(EAsyncTraceType::Single, Shot.Head, Shot.TraceEnd, m_SurfaceQuery, m_QueryParams);
+	INC_DWORD_STAT(STAT_SpiderWebShotTraces);
+}
+
+void UWebShooterComponent::Land(FWebShot& Shot, const FHitResult& Hit)
+{
+	const FVector Start{ Shot.Start };
+	const FVector Location{ Hit.ImpactPoint };
+	Release(Shot);
+
+	// Shot right into a wall, nothing to span
+	if (FVector::DistSquared(Start, Location) < FMath::Square(StrandThickness))
+	{
+		OnShotMissed.Broadcast(Location);
+		return;
+	}
+
+	// Only ends are tied together, a strand hit mid-span is cut there first. The instance index is the strand
+	UWebStrandInstancesComponent* HitStrands{ Cast<UWebStrandInstancesComponent>(Hit.GetComponent()) };
+	int32 First{ INDEX_NONE };
+	int32 Second{ INDEX_NONE };
+	if (HitStrands && HitStrands->SplitStrand(Hit.Item, Location, First, Second) && HitStrands == m_Strands)
+	{
+		// The halves take the cut strand's place in line
+		const int32 Order{ FMath::Max(m_StrandOrder.Find(Hit.Item), 0) };
+		m_StrandOrder.Remove(Hit.Item);
+		m_StrandOrder.Insert({ First, Second }, Order);
+	}
+
+	// Oldest strands make room, their instances are the ones reused. The halves just cut are kept for the new strand to hang from
+	int32 Oldest{};
+	while (m_StrandOrder.Num() >= MaxStrands && Oldest < m_StrandOrder.Num())
+	{
+		const int32 Candidate{ m_StrandOrder[Oldest] };
+		if (HitStrands == m_Strands && (Candidate == First || Candidate == Second))
+		{
+			++Oldest;
+			continue;
+		}
+
+		m_StrandOrder.RemoveAt(Oldest, 1, false);
+		m_Strands->RemoveStrand(Candidate);
+	}
+
+	const int32 Strand{ m_Strands->AddStrand(Start, Location) };
+	m_StrandOrder.Add(Strand);
+	OnShotHit.Broadcast(Strand, Location);
+}
+
+void UWebShooterComponent::Release(FWebShot& Shot)
+{
+	m_FlyingStrands->RemoveStrand(Shot.Strand);
+	Shot.Strand = INDEX_NONE;
+	Shot.Handle = {};
+	--m_NumShotsInFlight;
+}
+
+void UWebShooterComponent::HandleStrandBroken(int32 Strand)
+{
+	m_StrandOrder.Remove(Strand);
+}
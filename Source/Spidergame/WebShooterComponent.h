@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "SpiderCollision.h"
+#include "WebShooterComponent.generated.h"
+
+class UStaticMesh;
+class UWebStrandInstancesComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FWebShotHitSignature, int32, Strand, const FVector&, Location);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWebShotMissedSignature, const FVector&, Location);
+
+/**
+ * Shoots web lines from the owner's web socket. Shots fly for a few frames, every frame's stretch is one async trace
+ * read back the next frame. A hit turns the shot into a strand registered in the web graph,
+ * a strand hit mid-span is cut there so the new one is tied to it.
+ * Flying and landed strands are both instances reserved on BeginPlay, shooting never spawns or destroys actors.
+ */
+UCLASS(ClassGroup=(Web), meta=(BlueprintSpawnableComponent))
+class SPIDERGAME_API UWebShooterComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWebShooterComponent();
+
+	// Strand mesh is expected to be centred on its pivot and run along Z
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Web")
+	TObjectPtr<UStaticMesh> StrandMesh{};
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Web")
+	float StrandThickness{ 2.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Shooting")
+	float ShotSpeed{ 4000.f };
+	// Shots that hit nothing in this distance are dropped
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Shooting")
+	float MaxRange{ 3000.f };
+
+	// Shots flying at once, shooting is refused past this
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Pool", meta=(ClampMin=1))
+	int32 MaxShots{ 8 };
+	// Landed strands kept, the oldest is taken down for a new one past this
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Pool", meta=(ClampMin=1))
+	int32 MaxStrands{ 32 };
+
+	UPROPERTY(BlueprintAssignable, Category="Web")
+	FWebShotHitSignature OnShotHit{};
+	UPROPERTY(BlueprintAssignable, Category="Web")
+	FWebShotMissedSignature OnShotMissed{};
+
+	// Zero shoots along the web socket, false when every shot is still flying
+	UFUNCTION(BlueprintCallable, Category="Web")
+	bool Shoot(const FVector& Direction);
+	UFUNCTION(BlueprintCallable, Category="Web")
+	bool ShootAt(const FVector& Target);
+	// Takes down every landed strand, shots in flight keep going
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void ClearStrands();
+
+	UFUNCTION(BlueprintPure, Category="Web")
+	int32 GetNumShotsInFlight() const;
+	UFUNCTION(BlueprintPure, Category="Web")
+	UWebStrandInstancesComponent* GetStrands() const;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	struct FWebShot
+	{
+		FVector Start{};
+		FVector Head{};
+		FVector Direction{};
+		float Travelled{};
+		// Flying strand instance, INDEX_NONE while the slot is free
+		int32 Strand{ INDEX_NONE };
+
+		// Stretch in front of the head traced last frame
+		FVector TraceEnd{};
+		FTraceHandle Handle{};
+	};
+
+	TArray<FWebShot> m_Shots{};
+	int32 m_NumShotsInFlight{};
+	// Landed strands, oldest first
+	TArray<int32> m_StrandOrder{};
+
+	UPROPERTY(Transient)
+	TObjectPtr<UWebStrandInstancesComponent> m_Strands{};
+	UPROPERTY(Transient)
+	TObjectPtr<UWebStrandInstancesComponent> m_FlyingStrands{};
+	UPROPERTY(Transient)
+	TObjectPtr<USceneComponent> m_Muzzle{};
+
+	// Anything a strand can stick to, the owner's own strands included
+	FCollisionObjectQueryParams m_SurfaceQuery{ MakeSpiderSurfaceQuery() };
+	FCollisionQueryParams m_QueryParams{};
+
+	UWebStrandInstancesComponent* CreateStrands(FName Name, bool Landed, int32 Reserve);
+	// False once the shot has landed or missed
+	bool UpdateShot(UWorld* World, FWebShot& Shot, float DeltaTime);
+	void TraceStretch(UWorld* World, FWebShot& Shot) const;
+	void Land(FWebShot& Shot, const FHitResult& Hit);
+	void Release(FWebShot& Shot);
+
+	UFUNCTION()
+	void HandleStrandBroken(int32 Strand);
+};
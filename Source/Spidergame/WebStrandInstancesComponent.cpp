@@ -0,0 +1,237 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "WebStrandInstancesComponent.h"
+
+#include "SpiderCollision.h"
+#include "WebGraphSubsystem.h"
+#include "Engine/World.h"
+
+UWebStrandInstancesComponent::UWebStrandInstancesComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// Strands are placed in world space and move on their own
+	SetMobility(EComponentMobility::Movable);
+	SetUsingAbsoluteLocation(true);
+	SetUsingAbsoluteRotation(true);
+	SetUsingAbsoluteScale(true);
+
+	// Spiders mount strands by their object type
+	SetCollisionProfileName(WEB_LINE_PROFILE);
+}
+
+int32 UWebStrandInstancesComponent::AddStrand(const FVector& Start, const FVector& End)
+{
+	const FTransform Transform{ CalcStrandTransform(Start, End) };
+
+	int32 Strand{};
+	if (m_FreeStrands.IsEmpty())
+	{
+		Strand = AddInstance(Transform, true);
+		m_Segments.Add(INDEX_NONE);
+		m_Used.Add(true);
+	}
+	else
+	{
+		Strand = m_FreeStrands.Pop(false);
+		UpdateInstanceTransform(Strand, Transform, true, true);
+		m_Used[Strand] = true;
+	}
+
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+	{
+		m_Segments[Strand] = WebGraph->AddSegment(Start, End, GetOwner());
+		m_SegmentStrands.Add(m_Segments[Strand], Strand);
+	}
+
+	++m_NumStrands;
+	OnStrandAdded.Broadcast(Strand);
+	return Strand;
+}
+
+void UWebStrandInstancesComponent::RemoveStrand(int32 Strand)
+{
+	if (!IsValidStrand(Strand))
+		return;
+
+	// Forget the segment first so its removal isn't mistaken for a break
+	const int32 Segment{ m_Segments[Strand] };
+	HideStrand(Strand);
+
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+		WebGraph->RemoveSegment(Segment);
+}
+
+void UWebStrandInstancesComponent::MoveStrand(int32 Strand, const FVector& Start, const FVector& End, bool DirtyRenderState)
+{
+	if (!IsValidStrand(Strand))
+		return;
+
+	UpdateInstanceTransform(Strand, CalcStrandTransform(Start, End), true, DirtyRenderState);
+
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+		WebGraph->MoveSegment(m_Segments[Strand], Start, End);
+}
+
+bool UWebStrandInstancesComponent::SplitStrand(int32 Strand, const FVector& Point, int32& OutFirst, int32& OutSecond)
+{
+	OutFirst = INDEX_NONE;
+	OutSecond = INDEX_NONE;
+	if (!IsValidStrand(Strand))
+		return false;
+
+	FVector Start{};
+	FVector End{};
+	GetStrandEnds(Strand, Start, End);
+	const FVector Cut{ FMath::ClosestPointOnSegment(Point, Start, End) };
+	if (FVector::DistSquared(Cut, Start) < FMath::Square(StrandThickness) || FVector::DistSquared(Cut, End) < FMath::Square(StrandThickness))
+		return false;
+
+	// Both halves are in before the strand comes out, so the web graph never sees the web cut in two
+	OutFirst = AddStrand(Start, Cut);
+	OutSecond = AddStrand(Cut, End);
+	RemoveStrand(Strand);
+	return true;
+}
+
+void UWebStrandInstancesComponent::ClearStrands()
+{
+	const TArray<int32> Segments{ MoveTemp(m_Segments) };
+	m_Segments.Reset();
+	m_SegmentStrands.Reset();
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+	{
+		for (const int32 Segment : Segments)
+			WebGraph->RemoveSegment(Segment);
+	}
+
+	ClearInstances();
+	m_Used.Reset();
+	m_FreeStrands.Reset();
+	m_NumStrands = 0;
+}
+
+void UWebStrandInstancesComponent::ReserveStrands(int32 Count)
+{
+	while (m_Used.Num() < Count)
+	{
+		const int32 Strand{ AddInstance(FTransform{ FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector }, true) };
+		m_Segments.Add(INDEX_NONE);
+		m_Used.Add(false);
+		m_FreeStrands.Add(Strand);
+	}
+}
+
+bool UWebStrandInstancesComponent::IsValidStrand(int32 Strand) const
+{
+	return m_Used.IsValidIndex(Strand) && m_Used[Strand];
+}
+
+int32 UWebStrandInstancesComponent::GetNumStrands() const
+{
+	return m_NumStrands;
+}
+
+void UWebStrandInstancesComponent::GetStrandEnds(int32 Strand, FVector& OutStart, FVector& OutEnd) const
+{
+	FTransform Transform{};
+	GetInstanceTransform(Strand, Transform, true);
+
+	const FVector HalfStrand{ Transform.GetUnitAxis(EAxis::Z) * Transform.GetScale3D().Z * MeshLength * 0.5 };
+	OutStart = Transform.GetLocation() - HalfStrand;
+	OutEnd = Transform.GetLocation() + HalfStrand;
+}
+
+int32 UWebStrandInstancesComponent::GetStrandSegment(int32 Strand) const
+{
+	return IsValidStrand(Strand) ? m_Segments[Strand] : INDEX_NONE;
+}
+
+void UWebStrandInstancesComponent::OnRegister()
+{
+	Super::OnRegister();
+
+	UWebGraphSubsystem* WebGraph{ GetWebGraph() };
+	if (WebGraph == nullptr)
+		return;
+
+	m_SegmentRemovedHandle = WebGraph->OnSegmentRemoved.AddUObject(this, &UWebStrandInstancesComponent::HandleSegmentRemoved);
+
+	// Registered again (construction script, ReregisterComponent), put back what OnUnregister took out
+	for (TConstSetBitIterator<> It{ m_Used }; It; ++It)
+	{
+		const int32 Strand{ It.GetIndex() };
+		if (m_Segments[Strand] != INDEX_NONE)
+			continue;
+
+		FVector Start{};
+		FVector End{};
+		GetStrandEnds(Strand, Start, End);
+		m_Segments[Strand] = WebGraph->AddSegment(Start, End, GetOwner());
+		m_SegmentStrands.Add(m_Segments[Strand], Strand);
+	}
+}
+
+void UWebStrandInstancesComponent::OnUnregister()
+{
+	// Segments must not outlive the strands drawing them
+	if (UWebGraphSubsystem* WebGraph{ GetWebGraph() })
+	{
+		WebGraph->OnSegmentRemoved.Remove(m_SegmentRemovedHandle);
+		m_SegmentRemovedHandle.Reset();
+
+		for (int32& Segment : m_Segments)
+		{
+			WebGraph->RemoveSegment(Segment);
+			Segment = INDEX_NONE;
+		}
+		m_SegmentStrands.Reset();
+	}
+
+	Super::OnUnregister();
+}
+
+FTransform UWebStrandInstancesComponent::CalcStrandTransform(const FVector& Start, const FVector& End) const
+{
+	const FVector Direction{ End - Start };
+	const double Length{ Direction.Length() };
+	const double ThicknessScale{ StrandThickness / MeshDiameter };
+
+	return FTransform{
+		FRotationMatrix::MakeFromZ(Direction).ToQuat(),
+		(Start + End) * 0.5,
+		{ ThicknessScale, ThicknessScale, Length / MeshLength }
+	};
+}
+
+void UWebStrandInstancesComponent::HideStrand(int32 Strand)
+{
+	// Zero scale hides the instance and skips its physics body, the slot waits for the next strand
+	UpdateInstanceTransform(Strand, FTransform{ FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector }, true, true);
+
+	m_SegmentStrands.Remove(m_Segments[Strand]);
+	m_Segments[Strand] = INDEX_NONE;
+	m_Used[Strand] = false;
+	m_FreeStrands.Add(Strand);
+	--m_NumStrands;
+}
+
+void UWebStrandInstancesComponent::HandleSegmentRemoved(int32 Segment, AActor* Owner)
+{
+	if (Owner != GetOwner())
+		return;
+
+	const int32* Strand{ m_SegmentStrands.Find(Segment) };
+	if (Strand == nullptr || !IsValidStrand(*Strand))
+		return;
+
+	// Hiding forgets the segment, keep the strand for the broadcast
+	const int32 Broken{ *Strand };
+	HideStrand(Broken);
+	OnStrandBroken.Broadcast(Broken);
+}
+
+UWebGraphSubsystem* UWebStrandInstancesComponent::GetWebGraph() const
+{
+	const UWorld* World{ GetWorld() };
+	return RegisterInWebGraph && World ? World->GetSubsystem<UWebGraphSubsystem>() : nullptr;
+}
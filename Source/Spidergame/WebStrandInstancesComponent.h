@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "WebStrandInstancesComponent.generated.h"
+
+class UWebGraphSubsystem;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWebStrandBrokenSignature, int32, Strand);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FWebStrandAddedSignature, int32, Strand);
+
+/**
+ * Draws web strands as instances of one stretched strand mesh, one component per web structure or one for the whole level.
+ * Removed strands are scaled to zero and their instance reused by the next strand,
+ * so adding and removing never shifts or rebuilds the other instances.
+ */
+UCLASS(ClassGroup=(Web), meta=(BlueprintSpawnableComponent))
+class SPIDERGAME_API UWebStrandInstancesComponent : public UInstancedStaticMeshComponent
+{
+	GENERATED_BODY()
+
+public:
+	UWebStrandInstancesComponent();
+
+	// Strand mesh is expected to be centred on its pivot and run along Z
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Web")
+	float MeshLength{ 100.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Web")
+	float MeshDiameter{ 100.f };
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Web")
+	float StrandThickness{ 2.f };
+	// Also register every strand in the web graph so spiders and fireflies can find it
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Web")
+	bool RegisterInWebGraph{ true };
+
+	// Strand removed through the web graph instead of this component, already hidden when this fires
+	UPROPERTY(BlueprintAssignable, Category="Web")
+	FWebStrandBrokenSignature OnStrandBroken{};
+	UPROPERTY(BlueprintAssignable, Category="Web")
+	FWebStrandAddedSignature OnStrandAdded{};
+
+	UFUNCTION(BlueprintCallable, Category="Web")
+	int32 AddStrand(const FVector& Start, const FVector& End);
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void RemoveStrand(int32 Strand);
+	// Moving many strands at once, only mark the render state dirty on the last one
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void MoveStrand(int32 Strand, const FVector& Start, const FVector& End, bool DirtyRenderState = true);
+	// Cuts the strand in two at the point on it closest to Point, so another strand can be tied on mid-span.
+	// False and nothing cut when that point is at an end
+	UFUNCTION(BlueprintCallable, Category="Web")
+	bool SplitStrand(int32 Strand, const FVector& Point, int32& OutFirst, int32& OutSecond);
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void ClearStrands();
+	// Adds hidden instances until Count strands fit without growing the instance buffer
+	UFUNCTION(BlueprintCallable, Category="Web")
+	void ReserveStrands(int32 Count);
+
+	UFUNCTION(BlueprintPure, Category="Web")
+	bool IsValidStrand(int32 Strand) const;
+	UFUNCTION(BlueprintPure, Category="Web")
+	int32 GetNumStrands() const;
+	UFUNCTION(BlueprintPure, Category="Web")
+	void GetStrandEnds(int32 Strand, FVector& OutStart, FVector& OutEnd) const;
+	// Web graph segment of the strand, INDEX_NONE when not registered
+	int32 GetStrandSegment(int32 Strand) const;
+
+protected:
+	virtual void OnRegister() override;
+	virtual void OnUnregister() override;
+
+private:
+	// Web graph segment per instance, INDEX_NONE for free or unregistered instances
+	TArray<int32> m_Segments{};
+	// Back from a removed segment to its strand without searching every instance
+	TMap<int32, int32> m_SegmentStrands{};
+	TBitArray<> m_Used{};
+	TArray<int32> m_FreeStrands{};
+	int32 m_NumStrands{};
+	FDelegateHandle m_SegmentRemovedHandle{};
+
+	FTransform CalcStrandTransform(const FVector& Start, const FVector& End) const;
+	void HideStrand(int32 Strand);
+	void HandleSegmentRemoved(int32 Segment, AActor* Owner);
+	UWebGraphSubsystem* GetWebGraph() const;
+};
@@ -10,6 +10,6 @@ public class SpidergameEditorTarget : TargetRules
 		Type = TargetType.Editor;
 		DefaultBuildSettings = BuildSettingsVersion.V2;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_1;
-		ExtraModuleNames.Add("Spidergame");
+		ExtraModuleNames.AddRange(new string[] { "Spidergame", "SpidergameEditor" });
 	}
 }
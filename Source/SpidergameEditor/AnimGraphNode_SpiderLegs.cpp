@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+#include "AnimGraphNode_SpiderLegs.h"
+
+#define LOCTEXT_NAMESPACE "SpiderLegs"
+
+FText UAnimGraphNode_SpiderLegs::GetNodeTitle(ENodeTitleType::Type TitleType) const
+{
+	return GetControllerDescription();
+}
+
+FText UAnimGraphNode_SpiderLegs::GetTooltipText() const
+{
+	return LOCTEXT("Tooltip", "Plants the spider's feet on the surfaces under them and steps them in a tetrapod gait");
+}
+
+FText UAnimGraphNode_SpiderLegs::GetControllerDescription() const
+{
+	return LOCTEXT("Title", "Spider Legs");
+}
+
+const FAnimNode_SkeletalControlBase* UAnimGraphNode_SpiderLegs::GetNode() const
+{
+	return &Node;
+}
+
+#undef LOCTEXT_NAMESPACE
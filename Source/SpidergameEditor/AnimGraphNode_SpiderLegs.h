@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AnimGraphNode_SkeletalControlBase.h"
+#include "AnimNode_SpiderLegs.h"
+#include "AnimGraphNode_SpiderLegs.generated.h"
+
+// Puts FAnimNode_SpiderLegs in the animation graph, editor only
+UCLASS()
+class SPIDERGAMEEDITOR_API UAnimGraphNode_SpiderLegs : public UAnimGraphNode_SkeletalControlBase
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(EditAnywhere, Category="Settings")
+	FAnimNode_SpiderLegs Node{};
+
+	virtual FText GetNodeTitle(ENodeTitleType::Type TitleType) const override;
+	virtual FText GetTooltipText() const override;
+
+protected:
+	virtual FText GetControllerDescription() const override;
+	virtual const FAnimNode_SkeletalControlBase* GetNode() const override;
+};
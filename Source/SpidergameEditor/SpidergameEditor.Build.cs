@@ -0,0 +1,15 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+using UnrealBuildTool;
+
+public class SpidergameEditor : ModuleRules
+{
+	public SpidergameEditor(ReadOnlyTargetRules Target) : base(Target)
+	{
+		PCHUsage = PCHUsageMode.UseExplicitOrSharedPCHs;
+
+		PublicDependencyModuleNames.AddRange(new string[] { "Core", "CoreUObject", "Engine", "AnimGraph", "Spidergame" });
+
+		PrivateDependencyModuleNames.AddRange(new string[] { "AnimGraphRuntime", "BlueprintGraph" });
+	}
+}